@@ -0,0 +1,109 @@
+// Measures FileGenerator throughput for increasing thread counts.
+//
+// Usage: bench_generator <scratch-dir> [nodes] [threads...]
+//
+// Run it once with a scratch directory on tmpfs (e.g. /dev/shm) and once on
+// ext4 to separate CPU-bound overhead from filesystem latency.
+
+#include "yaqeen/core/generator.hpp"
+#include "yaqeen/core/parser.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace yaqeen::core;
+
+namespace {
+
+// Builds a tree shaped like a large monorepo: packages -> modules -> files
+std::unique_ptr<Node> build_tree(size_t target_nodes) {
+    const size_t files_per_module = 20;
+    const size_t modules_per_package = 10;
+    const size_t nodes_per_package = 1 + modules_per_package * (1 + files_per_module);
+
+    auto root = std::make_unique<Node>(Node::Type::Directory, "bench");
+    size_t packages = std::max<size_t>(1, target_nodes / nodes_per_package);
+
+    for (size_t p = 0; p < packages; ++p) {
+        auto package = std::make_unique<Node>(Node::Type::Directory, "package" + std::to_string(p));
+        for (size_t m = 0; m < modules_per_package; ++m) {
+            auto module = std::make_unique<Node>(Node::Type::Directory, "module" + std::to_string(m));
+            for (size_t f = 0; f < files_per_module; ++f) {
+                auto file = std::make_unique<Node>(Node::Type::File, "file" + std::to_string(f) + ".ts");
+                file->content = "export const value = " + std::to_string(f) + ";\n";
+                module->add_child(std::move(file));
+            }
+            package->add_child(std::move(module));
+        }
+        root->add_child(std::move(package));
+    }
+
+    return root;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <scratch-dir> [nodes] [threads...]\n";
+        return 1;
+    }
+
+    std::filesystem::path scratch = argv[1];
+    size_t nodes = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+
+    std::vector<size_t> thread_counts;
+    for (int i = 3; i < argc; ++i) {
+        thread_counts.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+    if (thread_counts.empty()) {
+        thread_counts = {1, 2, 4, 8};
+    }
+
+    auto tree = build_tree(nodes);
+    std::filesystem::create_directories(scratch);
+
+    std::cout << "nodes: " << nodes << "  scratch: " << scratch.string() << "\n\n";
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "ms"
+              << std::setw(14) << "nodes/s" << std::setw(10) << "speedup" << "\n";
+
+    double baseline_ms = 0.0;
+
+    for (size_t threads : thread_counts) {
+        auto target = scratch / ("run_" + std::to_string(threads));
+        std::filesystem::remove_all(target);
+
+        FileGenerator::Options options;
+        options.parallel = threads > 1;
+        options.max_threads = threads;
+
+        auto start = std::chrono::steady_clock::now();
+        auto result = FileGenerator(options).generate(*tree, target);
+        auto end = std::chrono::steady_clock::now();
+
+        if (result.is_error()) {
+            std::cerr << result.error().to_string() << "\n";
+            return 1;
+        }
+
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        if (baseline_ms == 0.0) {
+            baseline_ms = ms;
+        }
+
+        size_t created = result.value().files_created + result.value().dirs_created;
+        std::cout << std::setw(8) << threads
+                  << std::setw(12) << std::fixed << std::setprecision(1) << ms
+                  << std::setw(14) << static_cast<size_t>(created / (ms / 1000.0))
+                  << std::setw(9) << std::setprecision(2) << baseline_ms / ms << "x\n";
+
+        std::filesystem::remove_all(target);
+    }
+
+    return 0;
+}
@@ -0,0 +1,284 @@
+// Measures MarkdownParser throughput on generated specs of growing size.
+//
+// Usage: bench_parser [megabytes...]
+//
+// Each size is parsed a few times and the best run is reported next to a
+// memcpy of the same buffer, so the ratio shows how close the scanner gets
+// to touching each byte once. Time per megabyte should stay flat as the
+// input grows. A second table times the line classifier alone with each
+// glyph scanner this CPU supports, a third builds trees from flat path
+// lists in listing order and shuffled, and a fourth builds and frees the
+// same million-node tree as Nodes and as a NodeStore.
+
+#include "yaqeen/core/parser.hpp"
+#include "yaqeen/core/glyph_scan.hpp"
+#include "yaqeen/core/path_list.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace yaqeen::core;
+
+namespace {
+
+// A fenced tree of packages -> modules -> files, drawn the way specs are
+std::string build_spec(size_t target_bytes) {
+    std::string spec = "# Generated layout\n\nSome prose before the tree.\n\n```\nbench/\n";
+
+    for (size_t p = 0; spec.size() < target_bytes; ++p) {
+        spec += "    package" + std::to_string(p) + "/\n";
+        for (size_t m = 0; m < 10; ++m) {
+            spec += "        \xE2\x94\x9C\xE2\x94\x80\xE2\x94\x80 module" + std::to_string(m) + "/\n";
+            for (size_t f = 0; f < 20; ++f) {
+                spec += "            \xE2\x94\x82   file" + std::to_string(f) + ".ts\n";
+            }
+        }
+    }
+
+    spec += "```\n";
+    return spec;
+}
+
+// The same layout as build_spec() as a path list, one path per line
+std::vector<std::string> build_path_list(size_t paths) {
+    std::vector<std::string> lines;
+    for (size_t p = 0; lines.size() < paths; ++p) {
+        std::string package = "bench/package" + std::to_string(p);
+        lines.push_back(package + "/");
+        for (size_t m = 0; m < 10; ++m) {
+            std::string module = package + "/module" + std::to_string(m);
+            lines.push_back(module + "/");
+            for (size_t f = 0; f < 20; ++f) {
+                lines.push_back(module + "/file" + std::to_string(f) + ".ts");
+            }
+        }
+    }
+    return lines;
+}
+
+std::string join_lines(const std::vector<std::string>& lines) {
+    std::string joined;
+    for (const auto& line : lines) {
+        joined += line;
+        joined += '\n';
+    }
+    return joined;
+}
+
+template <typename F>
+double best_ms(int runs, F&& body) {
+    double best = 0.0;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        if (i == 0 || ms < best) {
+            best = ms;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+        sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+    if (sizes.empty()) {
+        sizes = {1, 4, 16, 64};
+    }
+
+    std::cout << std::setw(6) << "MB" << std::setw(12) << "nodes" << std::setw(12) << "parse ms"
+              << std::setw(10) << "MB/s" << std::setw(12) << "memcpy ms" << std::setw(10) << "ratio" << "\n";
+
+    MarkdownParser parser;
+    for (size_t megabytes : sizes) {
+        auto spec = build_spec(megabytes << 20);
+        std::vector<char> copy(spec.size());
+
+        size_t nodes = 0;
+        bool failed = false;
+        double parse_ms = best_ms(3, [&] {
+            auto result = parser.parse_string_store(spec);
+            if (result.is_error()) {
+                failed = true;
+                return;
+            }
+            if (nodes == 0) {
+                nodes = result.value().size();
+            }
+        });
+        if (failed) {
+            std::cerr << "parse failed\n";
+            return 1;
+        }
+
+        double copy_ms = best_ms(3, [&] {
+            std::memcpy(copy.data(), spec.data(), spec.size());
+        });
+
+        double mb = static_cast<double>(spec.size()) / (1 << 20);
+        std::cout << std::setw(6) << megabytes
+                  << std::setw(12) << nodes
+                  << std::setw(12) << std::fixed << std::setprecision(1) << parse_ms
+                  << std::setw(10) << std::setprecision(0) << mb / (parse_ms / 1000.0)
+                  << std::setw(12) << std::setprecision(2) << copy_ms
+                  << std::setw(9) << std::setprecision(1) << parse_ms / copy_ms << "x\n";
+    }
+
+    // The classifier alone over every line of the largest spec
+    auto spec = build_spec(sizes.back() << 20);
+    std::vector<std::string_view> lines;
+    for (size_t begin = 0; begin < spec.size();) {
+        size_t end = spec.find('\n', begin);
+        end = end == std::string::npos ? spec.size() : end;
+        lines.emplace_back(spec.data() + begin, end - begin);
+        begin = end + 1;
+    }
+
+    std::cout << "\n" << std::setw(8) << "scanner" << std::setw(12) << "classify ms" << std::setw(10) << "MB/s" << "\n";
+    double mb = static_cast<double>(spec.size()) / (1 << 20);
+    for (auto scanner : {GlyphScanner::Scalar, GlyphScanner::SSE2, GlyphScanner::AVX2}) {
+        if (!glyph_scanner_supported(scanner)) {
+            continue;
+        }
+        size_t columns = 0;
+        double ms = best_ms(3, [&] {
+            for (auto line : lines) {
+                size_t readable = static_cast<size_t>(spec.data() + spec.size() - line.data());
+                columns += classify_line(line, readable, scanner).prefix_columns;
+            }
+        });
+        std::cout << std::setw(8) << glyph_scanner_name(scanner)
+                  << std::setw(12) << std::setprecision(1) << ms
+                  << std::setw(10) << std::setprecision(0) << mb / (ms / 1000.0)
+                  << (columns == 0 ? " (no prefixes?)" : "") << "\n";
+    }
+
+    // Path lists: sorted input reuses the previous line's directories,
+    // shuffled input goes through the per-directory index
+    auto paths = build_path_list(size_t(1) << 20);
+    std::sort(paths.begin(), paths.end());
+    auto sorted = join_lines(paths);
+    std::shuffle(paths.begin(), paths.end(), std::mt19937(42));
+    auto shuffled = join_lines(paths);
+
+    std::cout << "\n" << std::setw(10) << "path list" << std::setw(10) << "paths" << std::setw(12) << "build ms"
+              << std::setw(12) << "Mpaths/s" << "\n";
+    PathListParser path_parser;
+    for (auto [name, list] : {std::pair<const char*, const std::string*>{"sorted", &sorted}, {"shuffled", &shuffled}}) {
+        bool failed = false;
+        double ms = best_ms(3, [&] {
+            failed = failed || path_parser.parse_string_store(*list).is_error();
+        });
+        if (failed) {
+            std::cerr << "path list failed\n";
+            return 1;
+        }
+        std::cout << std::setw(10) << name
+                  << std::setw(10) << paths.size()
+                  << std::setw(12) << std::setprecision(1) << ms
+                  << std::setw(12) << std::setprecision(2) << static_cast<double>(paths.size()) / (ms * 1000.0) << "\n";
+    }
+
+    // 1M nodes in the package/module/file shape, built then freed; names
+    // are formatted up front so that only the trees are timed
+    constexpr size_t kTreeNodes = size_t(1) << 20;
+    std::vector<std::string> package_names;
+    std::vector<std::string> module_names;
+    std::vector<std::string> file_names;
+    for (size_t p = 0; p * 211 < kTreeNodes; ++p) {
+        package_names.push_back("package" + std::to_string(p));
+    }
+    for (size_t m = 0; m < 10; ++m) {
+        module_names.push_back("module" + std::to_string(m));
+    }
+    for (size_t f = 0; f < 20; ++f) {
+        file_names.push_back("file" + std::to_string(f) + ".ts");
+    }
+    std::cout << "\n" << std::setw(10) << "tree" << std::setw(10) << "nodes" << std::setw(12) << "build ms"
+              << std::setw(12) << "free ms" << "\n";
+    auto report = [](const char* name, size_t nodes, double build_ms, double free_ms) {
+        std::cout << std::setw(10) << name << std::setw(10) << nodes
+                  << std::setw(12) << std::setprecision(1) << build_ms
+                  << std::setw(12) << free_ms << "\n";
+    };
+
+    {
+        double build_ms = 0.0;
+        double free_ms = 0.0;
+        size_t nodes = 0;
+        best_ms(3, [&] {
+            auto start = std::chrono::steady_clock::now();
+            auto root = std::make_unique<Node>(Node::Type::Directory, "bench");
+            nodes = 1;
+            for (const auto& package_name : package_names) {
+                auto package = std::make_unique<Node>(Node::Type::Directory, package_name);
+                for (const auto& module_name : module_names) {
+                    auto module = std::make_unique<Node>(Node::Type::Directory, module_name);
+                    for (const auto& file_name : file_names) {
+                        module->add_child(std::make_unique<Node>(Node::Type::File, file_name));
+                    }
+                    package->add_child(std::move(module));
+                }
+                root->add_child(std::move(package));
+                nodes += 1 + 10 * 21;
+            }
+            auto built = std::chrono::steady_clock::now();
+            root.reset();
+            auto freed = std::chrono::steady_clock::now();
+
+            double build = std::chrono::duration<double, std::milli>(built - start).count();
+            double free = std::chrono::duration<double, std::milli>(freed - built).count();
+            if (build_ms == 0.0 || build + free < build_ms + free_ms) {
+                build_ms = build;
+                free_ms = free;
+            }
+        });
+        report("Node", nodes, build_ms, free_ms);
+    }
+
+    {
+        double build_ms = 0.0;
+        double free_ms = 0.0;
+        size_t nodes = 0;
+        best_ms(3, [&] {
+            auto start = std::chrono::steady_clock::now();
+            auto tree = std::make_unique<NodeStore>();
+            NodeId root = tree->add_root("bench");
+            for (const auto& package_name : package_names) {
+                NodeId package = tree->add_child(root, package_name, true);
+                for (const auto& module_name : module_names) {
+                    NodeId module = tree->add_child(package, module_name, true);
+                    for (const auto& file_name : file_names) {
+                        tree->add_child(module, file_name, false);
+                    }
+                }
+            }
+            nodes = tree->size();
+            auto built = std::chrono::steady_clock::now();
+            tree.reset();
+            auto freed = std::chrono::steady_clock::now();
+
+            double build = std::chrono::duration<double, std::milli>(built - start).count();
+            double free = std::chrono::duration<double, std::milli>(freed - built).count();
+            if (build_ms == 0.0 || build + free < build_ms + free_ms) {
+                build_ms = build;
+                free_ms = free;
+            }
+        });
+        report("NodeStore", nodes, build_ms, free_ms);
+    }
+
+    return 0;
+}
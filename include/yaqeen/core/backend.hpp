@@ -0,0 +1,287 @@
+#pragma once
+
+#include "yaqeen/utils/error.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define YAQEEN_HAS_POSIX_BACKEND 1
+#else
+#define YAQEEN_HAS_POSIX_BACKEND 0
+#endif
+
+namespace yaqeen::core {
+
+// Growable path used only for progress reporting and error messages.
+// Components are appended on the way down and truncated on the way back up,
+// so a whole traversal shares one allocation.
+class PathBuffer {
+public:
+    PathBuffer() = default;
+    explicit PathBuffer(std::string base) : buffer_(std::move(base)) {}
+
+    // Append a component; returns the length to restore with pop()
+    size_t push(std::string_view component) {
+        size_t mark = buffer_.size();
+        if (!buffer_.empty() && buffer_.back() != '/') {
+            buffer_ += '/';
+        }
+        buffer_.append(component.data(), component.size());
+        return mark;
+    }
+
+    void pop(size_t mark) { buffer_.resize(mark); }
+
+    std::string_view view() const { return buffer_; }
+    const std::string& str() const { return buffer_; }
+
+private:
+    std::string buffer_;
+};
+
+// Outcome of creating one file. Unless overwriting, an existing file is left
+// untouched and reported with existed set and nothing written.
+struct FileOutcome {
+    size_t bytes_written = 0;
+    bool existed = false;
+};
+
+// One child of a directory in a create_entries() batch
+struct CreateRequest {
+    const std::string* name = nullptr;
+    std::string_view content;
+    bool is_directory = false;
+
+    // Set by the backend for files (see FileOutcome)
+    size_t bytes_written = 0;
+    bool existed = false;
+};
+
+// Low-level work done by a backend, reported through GenerationStats
+struct BackendCounters {
+    size_t syscalls = 0;
+    size_t bytes_saved = 0;  // content materialized by cloning or linking
+    size_t sqes_submitted = 0;
+    size_t cqes_completed = 0;
+};
+
+// Where generated directories and files end up.
+//
+// Directories are addressed by handles obtained from open_root() and
+// open_directory(); children are created relative to an open parent, so an
+// implementation never has to resolve a full path. The path arguments are
+// for error messages only. Implementations must allow concurrent calls on
+// different handles.
+class GenerationBackend {
+public:
+    using DirHandle = int;
+
+    virtual ~GenerationBackend() = default;
+
+    virtual const char* name() const = 0;
+
+    // Create the output directory (and missing parents) and open it
+    virtual Result<DirHandle> open_root(const std::filesystem::path& path) = 0;
+
+    // Create a subdirectory; an existing directory is reused
+    virtual Result<void> create_directory(
+        DirHandle parent,
+        const std::string& name,
+        std::string_view path
+    ) = 0;
+
+    virtual Result<DirHandle> open_directory(
+        DirHandle parent,
+        const std::string& name,
+        std::string_view path
+    ) = 0;
+
+    // Create a file and write its content. Whether the file already exists
+    // is decided by the create itself (O_EXCL), never by a separate probe.
+    virtual Result<FileOutcome> create_file(
+        DirHandle parent,
+        const std::string& name,
+        std::string_view content,
+        std::string_view path
+    ) = 0;
+
+    virtual void close_directory(DirHandle dir) = 0;
+
+    // Create all children of one directory. Batching backends override this
+    // to submit the whole directory at once; the default creates them one by
+    // one. parent_path is used for error messages.
+    virtual Result<void> create_entries(
+        DirHandle parent,
+        std::vector<CreateRequest>& entries,
+        std::string_view parent_path
+    );
+
+    // Called once after every node has been created successfully
+    virtual Result<void> finish() { return Result<void>(); }
+
+    virtual BackendCounters counters() const { return {}; }
+};
+
+enum class BackendKind {
+    Auto,         // DirectoryFd where available, Portable otherwise
+    Portable,     // std::filesystem with full paths
+    DirectoryFd,  // POSIX mkdirat/openat relative to open directory fds
+    IoUring       // Linux io_uring batches, falling back to DirectoryFd
+};
+
+struct BackendOptions {
+    bool overwrite = false;
+    unsigned queue_depth = 256;  // submission queue entries (io_uring)
+
+    // Materialize repeated file contents from the first copy written: by
+    // reflink (FICLONE) where the filesystem supports it, by hard link when
+    // dedup_hardlinks is set, and by a plain write otherwise
+    bool dedup = false;
+    bool dedup_hardlinks = false;
+    size_t dedup_min_size = 4096;  // smaller files fit in one block anyway
+};
+
+// Backend built on std::filesystem. Handles map to full paths.
+class PortableBackend : public GenerationBackend {
+public:
+    explicit PortableBackend(bool overwrite) : overwrite_(overwrite) {}
+
+    const char* name() const override { return "portable"; }
+
+    Result<DirHandle> open_root(const std::filesystem::path& path) override;
+    Result<void> create_directory(DirHandle parent, const std::string& name, std::string_view path) override;
+    Result<DirHandle> open_directory(DirHandle parent, const std::string& name, std::string_view path) override;
+    Result<FileOutcome> create_file(
+        DirHandle parent,
+        const std::string& name,
+        std::string_view content,
+        std::string_view path
+    ) override;
+    void close_directory(DirHandle dir) override;
+
+private:
+    Result<void> ensure_directory(const std::filesystem::path& path);
+    DirHandle acquire(std::filesystem::path path);
+    std::filesystem::path resolve(DirHandle dir);
+
+    bool overwrite_;
+    std::mutex mutex_;
+    std::vector<std::filesystem::path> slots_;
+    std::vector<DirHandle> free_slots_;
+};
+
+// Backend for --dry-run: touches nothing and reports the bytes that would be written
+class NullBackend : public GenerationBackend {
+public:
+    const char* name() const override { return "dry-run"; }
+
+    Result<DirHandle> open_root(const std::filesystem::path&) override { return 0; }
+    Result<void> create_directory(DirHandle, const std::string&, std::string_view) override {
+        return Result<void>();
+    }
+    Result<DirHandle> open_directory(DirHandle, const std::string&, std::string_view) override {
+        return 0;
+    }
+    Result<FileOutcome> create_file(DirHandle, const std::string&, std::string_view content, std::string_view) override {
+        return FileOutcome{content.size(), false};
+    }
+    void close_directory(DirHandle) override {}
+};
+
+#if YAQEEN_HAS_POSIX_BACKEND
+// Backend that keeps one directory fd per open level and creates children
+// with mkdirat/openat, so each node costs a constant number of path lookups
+// regardless of depth.
+class PosixBackend : public GenerationBackend {
+public:
+    explicit PosixBackend(const BackendOptions& options);
+    ~PosixBackend() override;
+
+    const char* name() const override { return "directory-fd"; }
+
+    Result<DirHandle> open_root(const std::filesystem::path& path) override;
+    Result<void> create_directory(DirHandle parent, const std::string& name, std::string_view path) override;
+    Result<DirHandle> open_directory(DirHandle parent, const std::string& name, std::string_view path) override;
+    Result<FileOutcome> create_file(
+        DirHandle parent,
+        const std::string& name,
+        std::string_view content,
+        std::string_view path
+    ) override;
+    void close_directory(DirHandle dir) override;
+
+    BackendCounters counters() const override;
+
+protected:
+    // Write a file relative to parent; an existing file is replaced by a new
+    // one when replace is set and left untouched otherwise
+    Result<FileOutcome> write_file(
+        DirHandle parent,
+        const std::string& name,
+        std::string_view content,
+        std::string_view path,
+        bool replace
+    );
+
+    // Create name exclusively. With replace, an existing file is unlinked
+    // and created afresh, never truncated in place. Returns -1 with errno
+    // set on failure.
+    int open_new_file(DirHandle parent, const std::string& name, bool replace);
+
+    // Resolve an EEXIST from mkdirat: existing directories are reused
+    Result<void> check_existing_directory(DirHandle parent, const std::string& name, std::string_view path);
+
+    void count_syscalls(size_t count = 1) {
+        syscalls_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    // Deduplication (see BackendOptions::dedup). Content that qualifies is
+    // first looked up with create_duplicate(), which returns nullopt when no
+    // earlier copy exists; once written, the file is offered to
+    // remember_source() so that later copies can be made from it.
+    bool dedup_candidate(std::string_view content) const {
+        return dedup_ && content.size() >= dedup_min_size_;
+    }
+    bool has_source(std::string_view content);
+    std::optional<Result<FileOutcome>> create_duplicate(
+        DirHandle parent,
+        const std::string& name,
+        std::string_view content,
+        std::string_view path
+    );
+    void remember_source(DirHandle parent, const std::string& name, std::string_view content);
+
+private:
+    struct DedupSource {
+        std::string_view content;
+        int fd;  // read-only descriptor of the first copy
+    };
+
+    int find_source(std::string_view content);
+
+    bool overwrite_;
+    bool dedup_;
+    bool dedup_hardlinks_;
+    size_t dedup_min_size_;
+    std::atomic<size_t> syscalls_{0};
+    std::atomic<size_t> bytes_saved_{0};
+    std::atomic<bool> clone_supported_{true};
+
+    std::mutex sources_mutex_;
+    std::unordered_map<uint64_t, std::vector<DedupSource>> sources_;
+    size_t source_count_ = 0;
+};
+#endif
+
+std::unique_ptr<GenerationBackend> make_backend(BackendKind kind, const BackendOptions& options);
+
+} // namespace yaqeen::core
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace yaqeen::core {
+
+// One node of a tree delivered in document (depth-first) order. Depth 1 is
+// a direct child of the output root, and an entry's parent is the last
+// entry seen one level up.
+struct StreamEntry {
+    uint32_t depth = 1;
+    std::string name;
+    bool is_directory = false;
+};
+
+using EntryBatch = std::vector<StreamEntry>;
+
+// Bounded hand-off between a thread that discovers entries and one that
+// creates them. push() blocks while `capacity` batches are waiting, so the
+// entries in flight stay bounded however large the tree is. The producer
+// calls close() after its last batch; either side can cancel(), after which
+// push() and pop() fail immediately.
+class EntryQueue {
+public:
+    explicit EntryQueue(size_t capacity = 8);
+
+    EntryQueue(const EntryQueue&) = delete;
+    EntryQueue& operator=(const EntryQueue&) = delete;
+
+    // false once cancelled; the batch is dropped
+    bool push(EntryBatch batch);
+
+    // false once closed and drained, or cancelled
+    bool pop(EntryBatch& batch);
+
+    void close();
+    void cancel();
+    bool cancelled() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<EntryBatch> batches_;
+    size_t capacity_;
+    bool closed_ = false;
+    bool cancelled_ = false;
+};
+
+} // namespace yaqeen::core
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "yaqeen/core/backend.hpp"
+#include "yaqeen/core/entry_stream.hpp"
+#include "yaqeen/core/parser.hpp"
+#include "yaqeen/core/plan.hpp"
+#include "yaqeen/core/tree_walk.hpp"
+#include "yaqeen/utils/error.hpp"
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace yaqeen::core {
+
+// Template structures for walk_tree(): a node is one key of an object, and
+// only objects have children. The root is the whole structure, with no key.
+struct JsonTree {
+    struct Node {
+        std::string_view key;
+        const nlohmann::json* value = nullptr;
+    };
+    struct Cursor {
+        nlohmann::json::const_iterator at;
+        nlohmann::json::const_iterator end;
+    };
+
+    Cursor children(const Node& node) const {
+        if (!node.value->is_object()) {
+            return Cursor{node.value->cend(), node.value->cend()};
+        }
+        return Cursor{node.value->cbegin(), node.value->cend()};
+    }
+
+    bool next(Cursor& cursor, Node& child) const {
+        if (cursor.at == cursor.end) {
+            return false;
+        }
+        child = Node{cursor.at.key(), &cursor.at.value()};
+        ++cursor.at;
+        return true;
+    }
+};
+
+// Statistics collected during a generation run
+struct GenerationStats {
+    size_t files_created = 0;
+    size_t files_skipped = 0;    // already present and left untouched
+    size_t dirs_created = 0;
+    size_t entries_removed = 0;  // pruned by an incremental run
+    size_t total_size = 0;       // bytes actually written
+    size_t bytes_saved = 0;      // duplicate content cloned or linked instead
+    std::chrono::milliseconds elapsed{0};
+
+    // System calls issued by the backend (zero where it does not count them)
+    size_t syscalls = 0;
+
+    // io_uring submission/completion queue entries (zero for other backends)
+    size_t sqes_submitted = 0;
+    size_t cqes_completed = 0;
+
+    // Accumulate counters from another run (e.g. a worker thread); elapsed is not summed
+    void merge(const GenerationStats& other);
+
+    std::string to_string() const;
+};
+
+// Progress callback: (path, is_directory, current, total)
+using ProgressCallback = std::function<void(const std::filesystem::path&, bool, size_t, size_t)>;
+
+// Creates files and directories on disk from a node tree
+class FileGenerator {
+public:
+    struct Options {
+        bool dry_run = false;
+        bool overwrite = false;
+        bool verbose = false;
+
+        // How files and directories are created; dry runs never touch the disk
+        BackendKind backend = BackendKind::Auto;
+        unsigned queue_depth = 256;  // io_uring submission queue size
+
+        // Create sibling subtrees concurrently on a work-stealing pool.
+        // Progress is still reported in plan order, as in a serial run.
+        bool parallel = false;
+        size_t max_threads = 0;  // 0 = one thread per core
+
+        // Build the tree in a hidden sibling directory and move it into place
+        // only once it is complete; a failed run leaves the output untouched.
+        // An existing output directory is replaced as a whole, and only when
+        // overwrite is set.
+        bool atomic = false;
+
+        // Compare the tree against the Manifest left in the output root by the
+        // previous incremental run and write only added or changed nodes; an
+        // unchanged tree costs one manifest read. Every path in the tree is
+        // owned by the generator, so changed files are rewritten. With prune,
+        // paths the previous run created but the tree no longer has are
+        // deleted (directories only when empty).
+        bool incremental = false;
+        bool prune = false;
+
+        // Create repeated file contents from their first copy (reflink, or
+        // hard link with dedup_hardlinks) instead of writing them again.
+        // Hard-linked copies share one inode: editing one edits them all.
+        bool dedup = false;
+        bool dedup_hardlinks = false;
+
+        // Send the tree to this backend (e.g. a TarBackend) instead of the
+        // filesystem. output_dir is then only handed to its open_root();
+        // validation, atomic, incremental and parallel modes do not apply.
+        GenerationBackend* sink = nullptr;
+
+        ProgressCallback progress_callback;
+    };
+
+    explicit FileGenerator(Options opts);
+
+    // Compiles root into a GenerationPlan and executes it
+    Result<GenerationStats> generate(
+        const Node& root,
+        const std::filesystem::path& output_dir
+    );
+
+    Result<GenerationStats> generate(
+        const NodeStore& tree,
+        const std::filesystem::path& output_dir
+    );
+
+    // Executes a compiled plan; one plan can be generated into any number
+    // of output directories
+    Result<GenerationStats> generate(
+        const GenerationPlan& plan,
+        const std::filesystem::path& output_dir
+    );
+
+    // Creates entries as they arrive on queue, in document order, until the
+    // producer closes it. Only the chain of open directories is held, so
+    // memory does not grow with the tree, and the output directory is
+    // created with the first entry. Names are checked one entry at a time;
+    // there is no whole-tree preflight, and atomic, incremental and parallel
+    // modes (which need the whole tree) are rejected. Progress totals are 0.
+    // On failure the queue is cancelled so that the producer stops.
+    Result<GenerationStats> generate_stream(
+        EntryQueue& queue,
+        const std::filesystem::path& output_dir
+    );
+
+    // Parses markdown from `in` on a second thread while generate_stream()
+    // creates what has been read so far; at most queue_capacity batches of
+    // entries are in flight
+    Result<GenerationStats> generate_streaming(
+        std::istream& in,
+        const std::filesystem::path& output_dir,
+        size_t queue_capacity = 8
+    );
+
+    const GenerationStats& stats() const { return stats_; }
+
+private:
+    // The backend options select, or options_.sink; owned keeps it alive
+    GenerationBackend* select_backend(std::unique_ptr<GenerationBackend>& owned);
+    void finish_stats(const GenerationBackend& backend);
+
+    Result<void> validate(const GenerationPlan& plan, const std::filesystem::path& output_dir);
+
+    // Engines build the tree under build_dir; output_dir is what progress reports
+    Result<void> generate_serial(
+        GenerationBackend& backend,
+        const GenerationPlan& plan,
+        const std::filesystem::path& build_dir,
+        const std::filesystem::path& output_dir
+    );
+
+    Result<void> generate_parallel(
+        GenerationBackend& backend,
+        const GenerationPlan& plan,
+        const std::filesystem::path& build_dir,
+        const std::filesystem::path& output_dir
+    );
+
+    // Runs an engine inside a StagingDirectory and publishes the result
+    Result<void> generate_atomic(
+        GenerationBackend& backend,
+        const GenerationPlan& plan,
+        const std::filesystem::path& output_dir
+    );
+
+    Result<GenerationStats> generate_incremental(
+        const GenerationPlan& plan,
+        const std::filesystem::path& output_dir
+    );
+
+    // Handles the degenerate case of a tree consisting of a single file
+    Result<void> generate_root_file(
+        GenerationBackend& backend,
+        const GenerationPlan& plan,
+        const std::filesystem::path& output_path
+    );
+
+    void notify_progress(
+        std::string_view path,
+        bool is_directory,
+        size_t current,
+        size_t total
+    );
+
+    Options options_;
+    GenerationStats stats_;
+    std::chrono::steady_clock::time_point start_time_;
+};
+
+// Generates project structures from JSON template definitions
+class TemplateGenerator {
+public:
+    struct TemplateOptions {
+        std::string project_name;
+        std::filesystem::path output_dir;
+        bool dry_run = false;
+        bool verbose = false;
+        bool parallel = false;
+        size_t max_threads = 0;
+        bool atomic = false;
+        bool incremental = false;
+        bool prune = false;
+        bool dedup = false;
+        bool dedup_hardlinks = false;
+        BackendKind backend = BackendKind::Auto;
+        GenerationBackend* sink = nullptr;
+        ProgressCallback progress_callback;
+    };
+
+    Result<GenerationStats> generate_from_json(
+        const nlohmann::json& structure,
+        const TemplateOptions& options
+    );
+
+    // A structure already converted, e.g. read from a TemplatePack
+    Result<GenerationStats> generate_from_store(
+        const NodeStore& tree,
+        const TemplateOptions& options
+    );
+
+    static Result<std::unique_ptr<Node>> json_to_node_tree(
+        const nlohmann::json& json_obj,
+        const std::string& root_name
+    );
+
+    // The same tree as a NodeStore; file contents are copied into it. "dir"
+    // and "dir/" keys name one directory, and a name used for both a file
+    // and a directory is an error. Names are interned in names when given,
+    // so that projects generated in one run share them.
+    static Result<NodeStore> json_to_store(
+        const nlohmann::json& json_obj,
+        const std::string& root_name,
+        std::shared_ptr<NamePool> names = nullptr
+    );
+};
+
+} // namespace yaqeen::core
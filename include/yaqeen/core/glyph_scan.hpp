@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace yaqeen::core {
+
+// How one line of a tree drawing breaks down, as found by classify_line()
+struct LineClass {
+    // Leading tree prefix: spaces, tabs, no-break spaces, '|', box-drawing
+    // glyphs (U+2500..U+257F) and ASCII branches ("|-- ", "`-- ", "+-- ")
+    size_t prefix_bytes = 0;
+    size_t prefix_columns = 0;  // display width; a tab counts as 4
+
+    // One past the last byte after the prefix that is not blank, '|' or a
+    // glyph, so the name is [prefix_bytes, name_end)
+    size_t name_end = 0;
+
+    bool has_glyph = false;
+    bool has_dot = false;
+    bool has_slash = false;
+    bool has_fence = false;  // ``` anywhere in the line
+};
+
+enum class GlyphScanner {
+    Auto,    // the widest implementation this CPU supports
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+// Classify a line in one pass. Every scanner gives identical results; the
+// vector ones test 16 or 32 bytes per step.
+LineClass classify_line(std::string_view line, GlyphScanner scanner = GlyphScanner::Auto);
+
+// As above, for a line inside a larger buffer: `readable` bytes from
+// line.data() may be read, so the vector scanners load whole windows past
+// the end of the line instead of copying its tail out.
+LineClass classify_line(std::string_view line, size_t readable, GlyphScanner scanner = GlyphScanner::Auto);
+
+// What Auto resolves to, chosen once from the running CPU
+GlyphScanner detect_glyph_scanner();
+
+bool glyph_scanner_supported(GlyphScanner scanner);
+const char* glyph_scanner_name(GlyphScanner scanner);
+
+} // namespace yaqeen::core
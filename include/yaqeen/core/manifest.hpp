@@ -0,0 +1,72 @@
+#pragma once
+
+#include "yaqeen/core/parser.hpp"
+#include "yaqeen/core/plan.hpp"
+#include "yaqeen/utils/error.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yaqeen::core {
+
+// One generated path, relative to the output root with '/' separators
+struct ManifestEntry {
+    std::string path;
+    bool is_directory = false;
+    uint64_t hash = 0;  // FNV-1a of the content (files only)
+    size_t size = 0;    // content size (files only)
+
+    bool operator==(const ManifestEntry& other) const {
+        return is_directory == other.is_directory && hash == other.hash &&
+               size == other.size && path == other.path;
+    }
+};
+
+// Record of what generation runs produced, stored as a small text file in
+// the output root. Entries are kept in plan order, so parents always precede
+// their children; entries an earlier run created and the plan no longer
+// has, but which were left on disk, follow the plan's own.
+class Manifest {
+public:
+    static constexpr const char* kFileName = ".yaqeen-manifest";
+
+    // Describe the tree below the plan's root (the root itself is not
+    // listed, so entry i describes plan entry i + 1)
+    static Manifest from_plan(const GenerationPlan& plan);
+    static Manifest from_tree(const Node& root);
+
+    static Result<Manifest> parse(std::string_view text);
+    static Result<Manifest> load(const std::filesystem::path& file);
+
+    std::string serialize() const;
+
+    // Written atomically, so readers never see a partial manifest
+    Result<void> save(const std::filesystem::path& file) const;
+
+    // Keep listing an entry the plan dropped but that still exists, after
+    // the plan's entries; entries must be added parents first
+    void add_leftover(const ManifestEntry& entry) { entries_.push_back(entry); }
+
+    const std::vector<ManifestEntry>& entries() const { return entries_; }
+    bool empty() const { return entries_.empty(); }
+
+private:
+    std::vector<ManifestEntry> entries_;
+};
+
+// Difference between a previous run and the planned one. Indices refer to
+// the entries of the manifest named in the comment.
+struct ManifestDiff {
+    std::vector<size_t> added;     // next: new paths, or paths whose type changed
+    std::vector<size_t> changed;   // next: files whose content changed
+    std::vector<size_t> removed;   // previous: gone or type changed, deepest first
+    size_t unchanged_files = 0;
+
+    static ManifestDiff compute(const Manifest& previous, const Manifest& next);
+
+    bool has_writes() const { return !added.empty() || !changed.empty(); }
+};
+
+} // namespace yaqeen::core
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yaqeen::core {
+
+// Handle of a name in a NamePool
+using NameId = uint32_t;
+
+// Interns the names of tree entries. Each distinct name is stored once and
+// known by a 32-bit handle, so equal names are equal handles, and its hash
+// is computed once, when it is first seen. Trees that repeat the same
+// component names (`src`, `tests`, `index.ts`) keep one copy of each, and
+// stores built from one pool compare names across trees as integers.
+//
+// Strings keep their address for the life of the pool. A pool is not
+// synchronized; share it between threads only behind a lock.
+class NamePool {
+public:
+    static constexpr NameId kNone = std::numeric_limits<NameId>::max();
+
+    // The handle of name, adding it if it is new
+    NameId intern(std::string_view name);
+
+    // The handle of name if it has been interned, otherwise kNone
+    NameId find(std::string_view name) const;
+
+    const std::string& str(NameId id) const { return strings_[id]; }
+    uint32_t hash(NameId id) const { return hashes_[id]; }
+    size_t size() const { return strings_.size(); }
+
+    static uint32_t hash_of(std::string_view name);
+
+private:
+    NameId find(std::string_view name, uint32_t hash) const;
+    void insert(NameId id, uint32_t hash);
+
+    std::deque<std::string> strings_;
+    std::vector<uint32_t> hashes_;  // indexed like strings_
+    std::vector<NameId> slots_;     // open-addressed by hash; kNone when empty
+};
+
+} // namespace yaqeen::core
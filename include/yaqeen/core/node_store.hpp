@@ -0,0 +1,176 @@
+#pragma once
+
+#include "yaqeen/core/name_pool.hpp"
+#include "yaqeen/utils/error.hpp"
+#include "yaqeen/utils/mapped_file.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yaqeen::core {
+
+struct Node;
+
+// Index of a node in a NodeStore
+using NodeId = uint32_t;
+
+// A project structure tree held in fixed-size blocks of node records: nodes
+// are 32-bit indices in first-child/next-sibling form, and file contents are
+// either copied into a monotonic arena or point into the document the tree
+// was parsed from. Building a tree fills records in place and freeing it
+// releases a few large blocks, where a Node tree allocates and frees every
+// node and child vector separately.
+//
+// The parsers, JSON conversion, plan compiler and TreeVisualizer work on a
+// store directly; Node remains for callers that want an owning pointer
+// tree, and converts to and from a store.
+//
+// Names are handles into a NamePool, which stores that share one pool have
+// in common; a GenerationPlan compiled from the store refers to the pool's
+// strings, which never move.
+//
+// A directory with more than kIndexThreshold children gets a hash index of
+// them the first time place_child() looks a name up in it, so lookups stay
+// O(1) in directories with tens of thousands of entries while trees built
+// with add_child() alone never pay for one.
+class NodeStore {
+public:
+    static constexpr NodeId kNone = std::numeric_limits<NodeId>::max();
+    static constexpr uint32_t kIndexThreshold = 8;
+
+    // What place_child() did with a name
+    struct Placement {
+        enum Kind {
+            Added,     // new child
+            Merged,    // a directory already there, which id now stands for
+            Conflict   // a file, or a file and a directory, already there
+        };
+
+        NodeId id = kNone;  // the new child, or the one already there
+        Kind kind = Added;
+    };
+
+    // names may be shared with other stores; a store creates its own pool
+    // when given none
+    explicit NodeStore(std::shared_ptr<NamePool> names = nullptr);
+    NodeStore(NodeStore&&) noexcept;
+    NodeStore& operator=(NodeStore&&) noexcept;
+    ~NodeStore();
+
+    NodeStore(const NodeStore&) = delete;
+    NodeStore& operator=(const NodeStore&) = delete;
+
+    // The root is node 0 and must be added first
+    NodeId add_root(std::string_view name, bool is_directory = true);
+
+    // Appends a child after the parent's last child, even if one with the
+    // same name exists
+    NodeId add_child(NodeId parent, std::string_view name, bool is_directory);
+
+    // Appends a child unless parent already has one of that name. A
+    // directory named twice is one directory, and entries under either
+    // mention land in it; anything else named twice is left alone and
+    // reported as a Conflict for the caller to turn into an error.
+    Placement place_child(NodeId parent, std::string_view name, bool is_directory);
+
+    // Describes a Conflict from placing a name as a directory or a file
+    Error conflict(const Placement& placed, bool is_directory, ErrorCode code) const;
+
+    // Copies content into the store's arena
+    void set_content(NodeId id, std::string_view content);
+
+    // content must point into source() and is not copied
+    void set_source_content(NodeId id, std::string_view content);
+
+    void set_directory(NodeId id, bool is_directory) { record(id).is_directory = is_directory; }
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+    NodeId root() const { return 0; }
+
+    const std::string& name(NodeId id) const { return names_->str(record(id).name); }
+    NameId name_id(NodeId id) const { return record(id).name; }
+    bool is_directory(NodeId id) const { return record(id).is_directory; }
+    bool is_file(NodeId id) const { return !record(id).is_directory; }
+    std::string_view content(NodeId id) const {
+        return std::string_view(record(id).content, record(id).content_size);
+    }
+
+    NodeId parent(NodeId id) const { return record(id).parent; }
+    NodeId first_child(NodeId id) const { return record(id).first_child; }
+    NodeId last_child(NodeId id) const { return record(id).last_child; }
+    NodeId next_sibling(NodeId id) const { return record(id).next_sibling; }
+    uint32_t child_count(NodeId id) const { return record(id).child_count; }
+
+    // kNone if there is no such child; hashed in directories that have an
+    // index, a scan of the children otherwise
+    NodeId find_child(NodeId parent, std::string_view name) const;
+    NodeId find_child(NodeId parent, NameId name) const;
+
+    // Path below the root, '/'-separated, for messages
+    std::string path(NodeId id) const;
+
+    // The document contents may point into; shared so that it lives as long
+    // as every copy of the tree
+    void set_source(std::shared_ptr<const MappedFile> source) { source_ = std::move(source); }
+    const std::shared_ptr<const MappedFile>& source() const { return source_; }
+
+    const NamePool& names() const { return *names_; }
+    const std::shared_ptr<NamePool>& name_pool() const { return names_; }
+
+    // Conversions for the Node API. Contents that point into source() stay
+    // content spans of the same document in both directions.
+    static NodeStore from_node(const Node& root, std::shared_ptr<NamePool> names = nullptr);
+    std::unique_ptr<Node> to_node() const;
+
+private:
+    static constexpr unsigned kBlockBits = 12;
+    static constexpr NodeId kBlockMask = (NodeId(1) << kBlockBits) - 1;
+
+    struct Record {
+        NodeId parent = kNone;
+        NodeId first_child = kNone;
+        NodeId last_child = kNone;
+        NodeId next_sibling = kNone;
+        uint32_t child_count = 0;
+        uint32_t index = kNone;  // into indexes_, for directories that have one
+        NameId name = NamePool::kNone;
+        bool is_directory = false;
+        size_t content_size = 0;
+        const char* content = nullptr;
+    };
+
+    Record& record(NodeId id) { return blocks_[id >> kBlockBits][id & kBlockMask]; }
+    const Record& record(NodeId id) const { return blocks_[id >> kBlockBits][id & kBlockMask]; }
+
+    // The children of one directory, open-addressed by name hash
+    struct ChildIndex {
+        struct Slot {
+            NameId name = NamePool::kNone;
+            NodeId node = kNone;  // kNone when empty
+        };
+
+        std::vector<Slot> slots;
+        uint32_t used = 0;
+    };
+
+    NodeId append(NodeId parent, NameId name, bool is_directory);
+    NodeId link_child(NodeId parent, NameId name, bool is_directory);
+
+    void index_children(NodeId parent);
+    void insert_indexed(ChildIndex& index, NameId name, NodeId node);
+
+    std::vector<std::unique_ptr<Record[]>> blocks_;
+    size_t size_ = 0;
+    std::vector<ChildIndex> indexes_;
+    std::shared_ptr<NamePool> names_;
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+    std::shared_ptr<const MappedFile> source_;
+};
+
+} // namespace yaqeen::core
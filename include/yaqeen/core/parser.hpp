@@ -0,0 +1,145 @@
+#pragma once
+
+#include "yaqeen/core/entry_stream.hpp"
+#include "yaqeen/core/node_store.hpp"
+#include "yaqeen/utils/error.hpp"
+#include "yaqeen/utils/mapped_file.hpp"
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yaqeen::core {
+
+// File content kept in the document a tree was parsed from, as a byte range
+// of the root's source; length 0 means none
+struct ContentSpan {
+    size_t offset = 0;
+    size_t length = 0;
+};
+
+// A node in the project structure tree (directory or file). Each node owns
+// its children; NodeStore holds the same tree in flat arrays and is what
+// the parsers build.
+struct Node {
+    enum class Type {
+        Directory,
+        File
+    };
+
+    Type type;
+    std::string name;
+    std::optional<std::string> content;
+    ContentSpan content_span;  // used when content is not set
+    std::vector<std::unique_ptr<Node>> children;
+
+    // Root only: the document content spans point into, shared so that it
+    // lives as long as the tree
+    std::shared_ptr<const MappedFile> source;
+
+    Node(Type t, std::string n) : type(t), name(std::move(n)) {}
+    ~Node();
+
+    bool is_directory() const { return type == Type::Directory; }
+    bool is_file() const { return type == Type::File; }
+
+    void add_child(std::unique_ptr<Node> child);
+    Node* find_child(const std::string& name);
+    const Node* find_child(const std::string& name) const;
+
+    std::string to_string(int indent = 0) const;
+};
+
+// Parses markdown documents containing a tree structure. The tree is read
+// from fenced code blocks (``` or ~~~) with no language, or tagged `tree`,
+// `text`, `txt` or `plaintext`; blocks in other languages and all prose are
+// skipped. A fenced block whose info string has `file=<path>` holds the
+// content of that file instead, <path> being relative to the top of the tree.
+class MarkdownParser {
+public:
+    // Stores this parser builds intern their names in names, when given,
+    // so that trees parsed one after another share one copy of each name
+    explicit MarkdownParser(std::shared_ptr<NamePool> names = nullptr);
+    ~MarkdownParser();
+
+    Result<std::unique_ptr<Node>> parse(const std::filesystem::path& md_file);
+    Result<std::unique_ptr<Node>> parse_string(std::string_view markdown);
+
+    // The same trees as a NodeStore, without building Nodes
+    Result<NodeStore> parse_store(const std::filesystem::path& md_file);
+    Result<NodeStore> parse_string_store(std::string_view markdown);
+
+    // Reads markdown from `in` in chunks and hands each entry to emit as soon
+    // as its line is read, without building nodes; memory is bounded by the
+    // chunk size and the tree depth. emit returns false to stop early. Fails
+    // like parse_string() when no tree is found. Fences are recognized line
+    // by line here, so only those outside lists and block quotes count, and
+    // `file=` blocks are rejected since entries are gone before they appear.
+    Result<void> parse_stream(std::istream& in, const std::function<bool(StreamEntry&&)>& emit);
+
+private:
+    // One scanned line; name is a view into the input
+    struct LineInfo {
+        int indent_level = 0;
+        std::string_view name;
+        bool is_directory = false;
+    };
+
+    // Where lines of tree blocks land in the tree, shared by the whole-input
+    // and streaming paths
+    struct TreeCursor {
+        std::vector<int> indents;  // indent level of each open entry, outermost first
+
+        // Depth of the entry a line describes (1 = top level), or 0 for none
+        size_t place(const LineInfo& info);
+    };
+
+    // Builds nodes from the lines of the document's tree blocks; md4c finds
+    // the blocks, so prose is never scanned line by line. source owns
+    // content when it is a file; otherwise content is copied if any file
+    // contents point into it.
+    Result<NodeStore> parse_tree_structure(
+        std::string_view content,
+        std::shared_ptr<const MappedFile> source
+    );
+
+    // leading_columns is indentation already stripped from the line
+    static LineInfo scan_line(std::string_view line, size_t readable, size_t leading_columns = 0);
+
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// Renders a node tree using box-drawing characters
+class TreeVisualizer {
+public:
+    struct Options {
+        bool use_unicode = true;
+
+        // Entries deeper than max_depth (the root's children are depth 1)
+        // and children of a directory past the first max_entries_per_dir
+        // are left out, each run of them shown as one "… N more" line.
+        // 0 means no limit.
+        size_t max_depth = 0;
+        size_t max_entries_per_dir = 0;
+    };
+
+    static std::string visualize(const Node& root, bool use_unicode = true);
+    static std::string visualize(const NodeStore& tree, bool use_unicode = true);
+    static std::string visualize(const NodeStore& tree, const Options& options);
+
+    // Streams the rendering to fd through a fixed-size buffer, so memory
+    // stays constant however large the tree is
+    static Result<void> write(const NodeStore& tree, int fd, const Options& options);
+
+    // Streams to standard output, after flushing std::cout
+    static void print(const Node& root, bool use_unicode = true);
+    static void print(const NodeStore& tree, bool use_unicode = true);
+    static void print(const NodeStore& tree, const Options& options);
+};
+
+} // namespace yaqeen::core
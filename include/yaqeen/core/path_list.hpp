@@ -0,0 +1,53 @@
+#pragma once
+
+#include "yaqeen/core/parser.hpp"
+#include "yaqeen/utils/error.hpp"
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+
+namespace yaqeen::core {
+
+// Builds a tree from a flat list of relative paths, one per line, as
+// printed by `find` or `git ls-files`. A trailing '/' marks a directory, and
+// so does having entries listed under it. Leading "./", empty lines and
+// repeated entries are ignored; absolute paths and ".." are rejected.
+//
+// Each line is matched against the chain of directories the previous line
+// opened, so sorted input (or any order that lists a directory's entries
+// together) adds entries without a lookup. A sibling that sorts before the
+// previous one switches that directory to NodeStore::place_child(), which
+// hashes the children of large directories.
+class PathListParser {
+public:
+    struct Stats {
+        size_t lines = 0;            // paths read, blank lines excluded
+        size_t indexed_lookups = 0;  // components looked up among their siblings
+    };
+
+    // Trees are built with names interned in names, when given
+    explicit PathListParser(std::shared_ptr<NamePool> names = nullptr) : names_(std::move(names)) {}
+
+    Result<std::unique_ptr<Node>> parse(const std::filesystem::path& list_file);
+    Result<std::unique_ptr<Node>> parse_string(std::string_view list);
+
+    // The same trees as a NodeStore, without building Nodes
+    Result<NodeStore> parse_store(const std::filesystem::path& list_file);
+    Result<NodeStore> parse_string_store(std::string_view list);
+
+    // Counters from the last parse
+    const Stats& stats() const { return stats_; }
+
+private:
+    NodeId child(NodeStore& tree, NodeId parent, std::string_view name, bool is_directory);
+
+    std::shared_ptr<NamePool> names_;
+
+    // Directories whose entries did not arrive in order
+    std::unordered_set<NodeId> unordered_;
+    Stats stats_;
+};
+
+} // namespace yaqeen::core
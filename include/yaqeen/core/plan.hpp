@@ -0,0 +1,76 @@
+#pragma once
+
+#include "yaqeen/core/parser.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yaqeen::core {
+
+// One create operation of a GenerationPlan
+struct PlanEntry {
+    static constexpr uint32_t kNoParent = std::numeric_limits<uint32_t>::max();
+
+    const std::string* name = nullptr;
+    std::string_view content;       // files only
+    uint32_t parent = kNoParent;
+    uint32_t depth = 0;
+    uint32_t first_child = 0;       // directories: children are
+    uint32_t child_count = 0;       // [first_child, first_child + child_count)
+    bool is_directory = false;
+};
+
+// A Node tree or NodeStore lowered into one flat array of create operations.
+//
+// Entry 0 is the root. The children of each directory are stored
+// contiguously, and these child blocks follow each other in depth-first
+// order, so every parent precedes its children, a front-to-back scan is a
+// valid creation order, and each block is one create_entries() batch.
+//
+// Names and contents are views into the source tree (file contents parsed
+// from markdown into the document the root keeps), which must outlive the
+// plan unmodified. The plan does not depend on where it is generated and can
+// be executed against any number of output directories.
+class GenerationPlan {
+public:
+    static GenerationPlan compile(const Node& root);
+    static GenerationPlan compile(const NodeStore& tree);
+
+    const PlanEntry& operator[](size_t index) const { return entries_[index]; }
+    const std::vector<PlanEntry>& entries() const { return entries_; }
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+
+    size_t file_count() const { return files_; }
+    size_t directory_count() const { return directories_; }
+    size_t content_bytes() const { return content_bytes_; }
+
+    // Compiled from a NodeStore, whose NamePool holds each distinct name
+    // once: equal names are the same pointer
+    bool names_interned() const { return names_interned_; }
+
+    // Path below the root, '/'-separated ("" for the root itself)
+    std::string relative_path(size_t index) const;
+
+    // The entries marked in keep (indexed like this plan), plus the
+    // directories needed to reach them; the root is always kept
+    GenerationPlan subset(const std::vector<bool>& keep) const;
+
+    // One line per operation, for --print-plan
+    void print(std::ostream& out) const;
+
+private:
+    void add(const PlanEntry& entry);
+
+    std::vector<PlanEntry> entries_;
+    size_t files_ = 0;
+    size_t directories_ = 0;
+    size_t content_bytes_ = 0;
+    bool names_interned_ = false;
+};
+
+} // namespace yaqeen::core
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "yaqeen/core/plan.hpp"
+#include "yaqeen/utils/error.hpp"
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace yaqeen::core {
+
+struct PreflightOptions {
+    // Existing files will be rewritten rather than skipped
+    bool overwrite = false;
+
+    // The tree is built in a fresh staging directory next to the output, so
+    // nothing already on disk can collide with it
+    bool fresh = false;
+
+    // Output goes to a sink rather than the filesystem: only entry names
+    // and duplicate siblings are checked, and nothing on disk is read
+    bool names_only = false;
+};
+
+// What a plan needs from the filesystem, as measured by preflight()
+struct PreflightReport {
+    size_t bytes_needed = 0;       // content rounded up to whole blocks
+    size_t inodes_needed = 0;
+    size_t bytes_available = 0;
+    size_t inodes_available = 0;   // 0 where the filesystem has no fixed limit
+    size_t existing_files = 0;
+    size_t existing_dirs = 0;
+};
+
+// Names the filesystem would reject or read as more than one component
+// ("", ".", "..", embedded '/' or NUL, over 255 bytes) are invalid
+bool is_valid_entry_name(std::string_view name);
+
+// Check a whole plan against its output location before anything is
+// created: entry names, duplicate siblings, write access, type collisions
+// with entries already on disk, and free space and inodes. Existing
+// directories are read once each rather than probed per entry; nothing is
+// written. Every problem found is reported in one error, the first in its
+// message and all of them in its details.
+Result<PreflightReport> preflight(
+    const GenerationPlan& plan,
+    const std::filesystem::path& output_dir,
+    const PreflightOptions& options
+);
+
+} // namespace yaqeen::core
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "yaqeen/core/backend.hpp"
+#include "yaqeen/utils/error.hpp"
+#include <filesystem>
+#include <string_view>
+
+namespace yaqeen::core {
+
+// Hidden sibling directory in which a tree is built before it replaces its
+// target in one rename. Unless publish() succeeds, the staging directory and
+// everything in it are removed when the object goes out of scope.
+class StagingDirectory {
+public:
+    // Create a fresh staging directory next to target
+    static Result<StagingDirectory> create(const std::filesystem::path& target);
+
+    StagingDirectory(StagingDirectory&& other) noexcept;
+    StagingDirectory& operator=(StagingDirectory&&) = delete;
+    StagingDirectory(const StagingDirectory&) = delete;
+    StagingDirectory& operator=(const StagingDirectory&) = delete;
+    ~StagingDirectory();
+
+    const std::filesystem::path& path() const { return path_; }
+
+    // Move the staged tree into place. A missing target is created by a
+    // plain rename. An existing one is a FileAlreadyExists error unless
+    // overwrite is set, even if it appeared after the caller looked; with
+    // overwrite it is swapped out atomically where the platform supports it
+    // (renameat2 RENAME_EXCHANGE on Linux) and deleted afterwards. Readers
+    // of target see either the old tree or the new one.
+    Result<void> publish(bool overwrite);
+
+private:
+    StagingDirectory(std::filesystem::path path, std::filesystem::path target)
+        : path_(std::move(path)), target_(std::move(target)) {}
+
+    void discard();
+
+    std::filesystem::path path_;
+    std::filesystem::path target_;
+    bool active_ = true;
+};
+
+// Write a single file so that it appears at path complete or not at all.
+// On Linux the content goes to an anonymous O_TMPFILE which is then linked
+// into place; elsewhere a hidden temporary is written and renamed. Without
+// overwrite an existing file is left untouched (see FileOutcome).
+Result<FileOutcome> write_file_atomically(
+    const std::filesystem::path& path,
+    std::string_view content,
+    bool overwrite
+);
+
+} // namespace yaqeen::core
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "yaqeen/core/backend.hpp"
+
+#if YAQEEN_HAS_POSIX_BACKEND
+
+#include <cstdint>
+
+namespace yaqeen::core {
+
+// Output sink that streams the tree as a POSIX tar archive (ustar, with pax
+// extended headers for long paths and huge files) to a file descriptor.
+// Each entry is written with a single writev of header, content and padding,
+// so no file content is copied or buffered. Headers carry fixed ownership,
+// permissions and mtime, making the archive byte-identical across runs.
+class TarBackend : public GenerationBackend {
+public:
+    // fd is not owned; mtime is stamped on every entry
+    explicit TarBackend(int fd, uint64_t mtime = 0) : fd_(fd), mtime_(mtime) {}
+
+    const char* name() const override { return "tar"; }
+
+    // path becomes the prefix of every member name ("" or "." for none); an
+    // absolute path or one that climbs out with ".." is rejected
+    Result<DirHandle> open_root(const std::filesystem::path& path) override;
+    Result<void> create_directory(DirHandle parent, const std::string& name, std::string_view path) override;
+    Result<DirHandle> open_directory(DirHandle parent, const std::string& name, std::string_view path) override;
+    Result<FileOutcome> create_file(
+        DirHandle parent,
+        const std::string& name,
+        std::string_view content,
+        std::string_view path
+    ) override;
+    void close_directory(DirHandle dir) override;
+
+    // Writes the two zero blocks that end an archive
+    Result<void> finish() override;
+
+    BackendCounters counters() const override;
+
+private:
+    std::string member_name(DirHandle parent, const std::string& name);
+    Result<void> write_entry(const std::string& member, char type, std::string_view content);
+
+    int fd_;
+    uint64_t mtime_;
+
+    // Entries are written whole, one at a time
+    std::mutex mutex_;
+    std::vector<std::string> slots_;  // member prefix of each open directory
+    std::vector<DirHandle> free_slots_;
+    std::atomic<size_t> syscalls_{0};
+};
+
+} // namespace yaqeen::core
+
+#endif // YAQEEN_HAS_POSIX_BACKEND
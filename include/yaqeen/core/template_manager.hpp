@@ -0,0 +1,102 @@
+#pragma once
+
+#include "yaqeen/core/generator.hpp"
+#include "yaqeen/utils/error.hpp"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace yaqeen::core {
+
+// Template metadata
+struct TemplateInfo {
+    std::string name;
+    std::string description;
+    std::string version;
+    std::string category;
+    std::vector<std::string> tags;
+    std::optional<std::string> author;
+    std::optional<std::string> repository;
+
+    static Result<TemplateInfo> from_json(const nlohmann::json& json);
+
+    // The metadata of a template file, read without building its structure.
+    // A template whose header reads is registered under its name, whether
+    // or not its structure turns out to be valid.
+    static Result<TemplateInfo> read_from_file(const std::filesystem::path& path);
+    nlohmann::json to_json() const;
+};
+
+// A loaded template: metadata plus its structure definition
+struct Template {
+    TemplateInfo info;
+    nlohmann::json structure;
+    std::filesystem::path source_path;
+
+    static Result<Template> load_from_file(const std::filesystem::path& path);
+    bool is_valid() const;
+};
+
+// Discovers, loads and validates templates
+class TemplateManager {
+public:
+    TemplateManager();
+    explicit TemplateManager(const std::filesystem::path& templates_dir);
+
+    Result<void> initialize();
+    Result<void> load_templates();
+
+    std::vector<std::string> list_templates() const;
+    std::vector<std::string> list_categories() const;
+    std::vector<TemplateInfo> list_templates_in_category(const std::string& category) const;
+    std::vector<TemplateInfo> search_templates(const std::string& query) const;
+
+    Result<Template> get_template(const std::string& name) const;
+    Result<TemplateInfo> get_template_info(const std::string& name) const;
+    bool has_template(const std::string& name) const;
+
+    Result<GenerationStats> generate_from_template(
+        const std::string& template_name,
+        const std::filesystem::path& output_dir,
+        const std::string& project_name,
+        const TemplateGenerator::TemplateOptions& options
+    );
+
+    Result<void> validate_template(const Template& tmpl) const;
+    Result<void> validate_all_templates();
+
+    static std::filesystem::path get_default_templates_directory();
+
+private:
+    Result<Template> load_template_file(const std::filesystem::path& file_path);
+    void scan_directory(const std::filesystem::path& dir);
+    bool validate_structure_recursive(const nlohmann::json& structure) const;
+
+    std::filesystem::path templates_dir_;
+    std::unordered_map<std::string, Template> templates_;  // metadata and source path only
+
+    // Structures read on demand by get_template(); shared so that the
+    // manager stays movable
+    struct StructureCache;
+    std::shared_ptr<StructureCache> structures_;
+    bool initialized_;
+};
+
+// Formatting helpers for template listings
+class TemplateDisplay {
+public:
+    static std::string format_template_list(const std::vector<TemplateInfo>& templates);
+    static std::string format_template_details(const Template& tmpl);
+    static std::string format_categories(const std::vector<std::string>& categories);
+
+    static void print_template_list(const std::vector<TemplateInfo>& templates);
+    static void print_template_details(const Template& tmpl);
+    static void print_categories(const std::vector<std::string>& categories);
+};
+
+} // namespace yaqeen::core
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "yaqeen/core/node_store.hpp"
+#include "yaqeen/core/template_manager.hpp"
+#include "yaqeen/utils/error.hpp"
+#include "yaqeen/utils/mapped_file.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yaqeen::core {
+
+// A templates directory compiled into one binary file: the metadata of every
+// template, their structures flattened into node records with names
+// interned once across the pack, and file contents in a single blob. A pack
+// is memory-mapped and read in place, so starting up with thousands of
+// templates parses no JSON.
+//
+// The pack records the path, size and modification time of every template
+// file it was compiled from. open() refuses a pack when any of them
+// changed, disappeared or gained a new sibling, or when the pack is from
+// another format version; callers then read the JSON files as before.
+class TemplatePack {
+public:
+    static constexpr const char* kFileName = ".yaqeen-pack";
+    static constexpr uint32_t kVersion = 2;
+
+    struct CompileSummary {
+        size_t templates = 0;  // packed
+        size_t invalid = 0;    // of those, packed without their invalid structure
+        size_t skipped = 0;    // unreadable header, or a name already taken
+        size_t bytes = 0;      // pack size
+    };
+
+    // Where a directory's pack lives
+    static std::filesystem::path default_path(const std::filesystem::path& templates_dir);
+
+    // Compiles every .json template under templates_dir into pack_path,
+    // replacing it atomically. Files are visited in order of their generic
+    // path relative to templates_dir, as TemplateManager scans them, and
+    // the first template whose header reads takes its name, even if its
+    // structure is invalid: such a template is packed without one.
+    static Result<CompileSummary> compile(
+        const std::filesystem::path& templates_dir,
+        const std::filesystem::path& pack_path
+    );
+
+    // Maps a pack compiled from templates_dir, failing if it is stale,
+    // corrupt or of another version
+    static Result<TemplatePack> open(
+        const std::filesystem::path& templates_dir,
+        const std::filesystem::path& pack_path
+    );
+
+    size_t size() const { return templates_; }
+
+    TemplateInfo info(size_t index) const;
+    std::filesystem::path source_path(size_t index) const;
+
+    // False for a template packed without its invalid structure, which
+    // is then read from its source file
+    bool has_structure(size_t index) const;
+
+    // The structure below a root named root_name, for templates that have
+    // one. Contents point into the mapped pack, which the store keeps alive.
+    NodeStore structure(size_t index, const std::string& root_name,
+                        std::shared_ptr<NamePool> names = nullptr) const;
+
+    // The structure as the JSON object it was compiled from: directories
+    // are objects and files are content strings
+    nlohmann::json structure_json(size_t index) const;
+
+private:
+    TemplatePack() = default;
+
+    std::shared_ptr<const MappedFile> file_;
+    std::filesystem::path templates_dir_;
+    size_t templates_ = 0;
+};
+
+} // namespace yaqeen::core
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yaqeen::core {
+
+// Fixed-size thread pool with one task deque per worker.
+//
+// A worker pops its own newest task first (depth-first, cache friendly) and
+// steals the oldest task of another worker when its deque runs dry. Tasks may
+// submit further tasks; wait() returns once every submitted task, including
+// those spawned by other tasks, has finished. Tasks must not throw.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(size_t thread_count);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(Task task);
+    void wait();
+
+    size_t size() const { return workers_.size(); }
+
+    // Index of the calling worker in [0, size()), or size() when the caller
+    // is not one of this pool's threads
+    size_t current_worker() const;
+
+    // Thread count to use for a requested value; 0 means one thread per core
+    static size_t resolve_thread_count(size_t requested);
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(size_t index);
+    bool try_pop(size_t index, Task& task);
+    bool try_steal(size_t thief, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    std::mutex state_mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable all_done_;
+    std::atomic<size_t> queued_{0};
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> next_queue_{0};
+    bool stopping_ = false;
+};
+
+} // namespace yaqeen::core
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "yaqeen/core/node_store.hpp"
+#include "yaqeen/core/parser.hpp"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace yaqeen::core {
+
+// What a visitor wants done after seeing a node
+enum class WalkAction {
+    Continue,  // go on, into the node's children when visiting pre-order
+    Skip,      // leave the node's children out (pre-order only)
+    Stop       // end the walk
+};
+
+// Walks a tree depth first with an explicit stack, so that depth is bounded
+// by memory rather than by the thread's stack: specs nested tens of
+// thousands of levels deep are walked like shallow ones.
+//
+// Tree adapts a tree shape to the walk. It provides
+//     using Node = ...;    // a cheap, copyable handle of one node
+//     using Cursor = ...;  // position among a node's children
+//     Cursor children(const Node&) const;
+//     bool next(Cursor&, Node& child) const;  // false past the last child
+//
+// pre(node, depth) is called when a node is reached and post(node, depth)
+// after its children, or right after pre when they are skipped; the root is
+// at depth 0. Both return a WalkAction. Returns false if a visitor stopped
+// the walk.
+template <typename Tree, typename Pre, typename Post>
+bool walk_tree(const Tree& tree, const typename Tree::Node& root, Pre&& pre, Post&& post) {
+    using Node = typename Tree::Node;
+    struct Frame {
+        Node node;
+        typename Tree::Cursor cursor;
+    };
+    std::vector<Frame> stack;
+
+    auto enter = [&](const Node& node) {
+        switch (pre(node, stack.size())) {
+            case WalkAction::Stop:
+                return false;
+            case WalkAction::Skip:
+                return post(node, stack.size()) != WalkAction::Stop;
+            case WalkAction::Continue:
+                break;
+        }
+        stack.push_back(Frame{node, tree.children(node)});
+        return true;
+    };
+
+    if (!enter(root)) {
+        return false;
+    }
+    while (!stack.empty()) {
+        Node child;
+        if (tree.next(stack.back().cursor, child)) {
+            if (!enter(child)) {
+                return false;
+            }
+            continue;
+        }
+
+        Node done = std::move(stack.back().node);
+        stack.pop_back();
+        if (post(done, stack.size()) == WalkAction::Stop) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Pre-order only
+template <typename Tree, typename Pre>
+bool walk_tree(const Tree& tree, const typename Tree::Node& root, Pre&& pre) {
+    return walk_tree(tree, root, std::forward<Pre>(pre),
+                     [](const typename Tree::Node&, size_t) { return WalkAction::Continue; });
+}
+
+// Node trees, by pointer
+struct NodeTree {
+    using Node = const core::Node*;
+    struct Cursor {
+        const std::unique_ptr<core::Node>* at = nullptr;
+        const std::unique_ptr<core::Node>* end = nullptr;
+    };
+
+    Cursor children(Node node) const {
+        const auto& children = node->children;
+        return Cursor{children.data(), children.data() + children.size()};
+    }
+
+    bool next(Cursor& cursor, Node& child) const {
+        if (cursor.at == cursor.end) {
+            return false;
+        }
+        child = (cursor.at++)->get();
+        return true;
+    }
+};
+
+// NodeStore trees, by id
+struct StoreTree {
+    using Node = NodeId;
+    using Cursor = NodeId;  // the next child, or kNone
+
+    const NodeStore& store;
+
+    Cursor children(Node node) const { return store.first_child(node); }
+
+    bool next(Cursor& cursor, Node& child) const {
+        if (cursor == NodeStore::kNone) {
+            return false;
+        }
+        child = cursor;
+        cursor = store.next_sibling(cursor);
+        return true;
+    }
+};
+
+} // namespace yaqeen::core
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "yaqeen/core/backend.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define YAQEEN_HAS_IO_URING 1
+#else
+#define YAQEEN_HAS_IO_URING 0
+#endif
+
+#if YAQEEN_HAS_IO_URING
+
+#include <atomic>
+
+namespace yaqeen::core {
+
+// Directory-fd backend that creates a whole directory's children through
+// io_uring. Each file is submitted as a linked openat -> write -> close chain
+// on a direct descriptor (preceded by an unlinkat when overwriting) and each
+// subdirectory as a mkdirat, so one io_uring_enter covers up to queue_depth
+// operations. Anything the batch cannot settle (collisions, short writes) is
+// finished with the synchronous POSIX calls.
+class IoUringBackend : public PosixBackend {
+public:
+    // Returns nullptr when the kernel lacks io_uring or the required opcodes
+    static std::unique_ptr<IoUringBackend> create(const BackendOptions& options);
+
+    ~IoUringBackend() override;
+
+    const char* name() const override { return "io_uring"; }
+
+    Result<void> create_entries(
+        DirHandle parent,
+        std::vector<CreateRequest>& entries,
+        std::string_view parent_path
+    ) override;
+
+    BackendCounters counters() const override;
+
+private:
+    class Ring;
+
+    IoUringBackend(const BackendOptions& options, std::unique_ptr<Ring> ring);
+
+    // Rings are single-producer, so concurrent callers each take their own
+    std::unique_ptr<Ring> acquire_ring();
+    void release_ring(std::unique_ptr<Ring> ring);
+
+    BackendOptions options_;
+    std::mutex rings_mutex_;
+    std::vector<std::unique_ptr<Ring>> idle_rings_;
+    std::atomic<size_t> sqes_submitted_{0};
+    std::atomic<size_t> cqes_completed_{0};
+};
+
+} // namespace yaqeen::core
+
+#endif // YAQEEN_HAS_IO_URING
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace yaqeen {
+
+// 64-bit FNV-1a. Not cryptographic: used to detect changed content and to
+// bucket candidates, with byte comparison wherever a collision would matter.
+class Hash {
+public:
+    static constexpr uint64_t kOffsetBasis = 14695981039346656037ULL;
+    static constexpr uint64_t kPrime = 1099511628211ULL;
+
+    static constexpr uint64_t fnv1a(std::string_view data, uint64_t seed = kOffsetBasis) {
+        uint64_t hash = seed;
+        for (char c : data) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= kPrime;
+        }
+        return hash;
+    }
+
+    // Fixed-width lowercase hex, as stored in manifests
+    static std::string to_hex(uint64_t hash) {
+        static constexpr char kDigits[] = "0123456789abcdef";
+        std::string out(16, '0');
+        for (int i = 15; i >= 0; --i) {
+            out[static_cast<size_t>(i)] = kDigits[hash & 0xf];
+            hash >>= 4;
+        }
+        return out;
+    }
+};
+
+} // namespace yaqeen
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "yaqeen/utils/error.hpp"
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace yaqeen {
+
+// Read-only contents of a file, mapped where possible. Regular files are
+// mapped MAP_PRIVATE and advised for sequential access; pipes, character
+// devices and platforms without mmap are read into an owned buffer. Either
+// way view() borrows from this object, which must outlive it.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Opens once; failures come back as FileNotFound, PermissionDenied or
+    // InvalidInput (a directory), so no separate readability check is needed
+    static Result<MappedFile> open(const std::filesystem::path& path);
+
+    // Owns contents that did not come from a file, as if read from a pipe
+    static MappedFile from_buffer(std::string contents);
+
+    std::string_view view() const { return {data_, size_}; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool is_mapped() const { return mapped_; }
+
+private:
+    void release();
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::string buffer_;  // contents when not mapped
+};
+
+} // namespace yaqeen
@@ -0,0 +1,185 @@
+#include "yaqeen/core/backend.hpp"
+#include "yaqeen/core/uring_backend.hpp"
+#include "yaqeen/utils/logger.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace yaqeen::core {
+
+// GenerationBackend implementation
+Result<void> GenerationBackend::create_entries(
+    DirHandle parent,
+    std::vector<CreateRequest>& entries,
+    std::string_view parent_path
+) {
+    PathBuffer path{std::string(parent_path)};
+
+    for (auto& entry : entries) {
+        size_t mark = path.push(*entry.name);
+
+        if (entry.is_directory) {
+            auto created = create_directory(parent, *entry.name, path.view());
+            if (created.is_error()) {
+                return created;
+            }
+        } else {
+            auto written = create_file(parent, *entry.name, entry.content, path.view());
+            if (written.is_error()) {
+                return written.error();
+            }
+            entry.bytes_written = written.value().bytes_written;
+            entry.existed = written.value().existed;
+        }
+
+        path.pop(mark);
+    }
+
+    return Result<void>();
+}
+
+// PortableBackend implementation
+Result<GenerationBackend::DirHandle> PortableBackend::open_root(const std::filesystem::path& path) {
+    auto result = ensure_directory(path);
+    if (result.is_error()) {
+        return result.error();
+    }
+    return acquire(path);
+}
+
+Result<void> PortableBackend::create_directory(
+    DirHandle parent,
+    const std::string& name,
+    std::string_view /*path*/
+) {
+    auto path = resolve(parent) / name;
+
+    // create_directory() reports an existing non-directory as file_exists
+    std::error_code ec;
+    std::filesystem::create_directory(path, ec);
+    if (ec == std::errc::file_exists) {
+        return Error(ErrorCode::FileAlreadyExists,
+                    "Path exists but is not a directory: " + path.string());
+    }
+    if (ec) {
+        return Error(ErrorCode::CannotCreateDirectory,
+                    "Cannot create directory: " + path.string(),
+                    ec.message());
+    }
+
+    return Result<void>();
+}
+
+Result<GenerationBackend::DirHandle> PortableBackend::open_directory(
+    DirHandle parent,
+    const std::string& name,
+    std::string_view /*path*/
+) {
+    return acquire(resolve(parent) / name);
+}
+
+Result<FileOutcome> PortableBackend::create_file(
+    DirHandle parent,
+    const std::string& name,
+    std::string_view content,
+    std::string_view /*path*/
+) {
+    auto path = resolve(parent) / name;
+
+    // Replace rather than truncate, so hard links to the old file keep it
+    if (overwrite_) {
+        std::error_code ec;
+        if (std::filesystem::is_regular_file(std::filesystem::symlink_status(path, ec))) {
+            std::filesystem::remove(path, ec);
+        }
+    }
+
+    // "x" is the C11 exclusive-create mode: the open itself detects collisions
+    std::FILE* file = std::fopen(path.string().c_str(), overwrite_ ? "wb" : "wbx");
+    if (!file) {
+        if (!overwrite_ && errno == EEXIST) {
+            return FileOutcome{0, true};
+        }
+        return Error(ErrorCode::CannotCreateFile,
+                    "Cannot create file: " + path.string(),
+                    std::strerror(errno));
+    }
+
+    bool written = content.empty() ||
+                   std::fwrite(content.data(), 1, content.size(), file) == content.size();
+    if (std::fclose(file) != 0) {
+        written = false;
+    }
+
+    if (!written) {
+        return Error(ErrorCode::CannotCreateFile, "Cannot write file: " + path.string());
+    }
+
+    return FileOutcome{content.size(), false};
+}
+
+void PortableBackend::close_directory(DirHandle dir) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_[dir].clear();
+    free_slots_.push_back(dir);
+}
+
+Result<void> PortableBackend::ensure_directory(const std::filesystem::path& path) {
+    if (std::filesystem::exists(path)) {
+        if (std::filesystem::is_directory(path)) {
+            return Result<void>();
+        }
+        return Error(ErrorCode::FileAlreadyExists,
+                    "Path exists but is not a directory: " + path.string());
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(path, ec);
+    if (ec) {
+        return Error(ErrorCode::CannotCreateDirectory,
+                    "Cannot create directory: " + path.string(),
+                    ec.message());
+    }
+
+    return Result<void>();
+}
+
+GenerationBackend::DirHandle PortableBackend::acquire(std::filesystem::path path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_slots_.empty()) {
+        DirHandle slot = free_slots_.back();
+        free_slots_.pop_back();
+        slots_[slot] = std::move(path);
+        return slot;
+    }
+
+    slots_.push_back(std::move(path));
+    return static_cast<DirHandle>(slots_.size() - 1);
+}
+
+std::filesystem::path PortableBackend::resolve(DirHandle dir) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_[dir];
+}
+
+std::unique_ptr<GenerationBackend> make_backend(BackendKind kind, const BackendOptions& options) {
+#if YAQEEN_HAS_IO_URING
+    if (kind == BackendKind::IoUring) {
+        auto uring = IoUringBackend::create(options);
+        if (uring) {
+            return uring;
+        }
+        LOG_DEBUG("io_uring unavailable, falling back to directory-fd backend");
+    }
+#endif
+
+#if YAQEEN_HAS_POSIX_BACKEND
+    if (kind != BackendKind::Portable) {
+        return std::make_unique<PosixBackend>(options);
+    }
+#endif
+
+    return std::make_unique<PortableBackend>(options.overwrite);
+}
+
+} // namespace yaqeen::core
@@ -0,0 +1,58 @@
+#include "yaqeen/core/entry_stream.hpp"
+
+namespace yaqeen::core {
+
+EntryQueue::EntryQueue(size_t capacity) : capacity_(capacity == 0 ? 1 : capacity) {
+}
+
+bool EntryQueue::push(EntryBatch batch) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return cancelled_ || batches_.size() < capacity_; });
+    if (cancelled_) {
+        return false;
+    }
+
+    batches_.push_back(std::move(batch));
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+}
+
+bool EntryQueue::pop(EntryBatch& batch) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return cancelled_ || closed_ || !batches_.empty(); });
+    if (cancelled_ || batches_.empty()) {
+        return false;
+    }
+
+    batch = std::move(batches_.front());
+    batches_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+    return true;
+}
+
+void EntryQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    not_empty_.notify_all();
+}
+
+void EntryQueue::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        batches_.clear();
+    }
+    not_full_.notify_all();
+    not_empty_.notify_all();
+}
+
+bool EntryQueue::cancelled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cancelled_;
+}
+
+} // namespace yaqeen::core
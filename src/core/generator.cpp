@@ -1,19 +1,131 @@
 #include "yaqeen/core/generator.hpp"
+#include "yaqeen/core/manifest.hpp"
+#include "yaqeen/core/preflight.hpp"
+#include "yaqeen/core/staging.hpp"
+#include "yaqeen/core/thread_pool.hpp"
 #include "yaqeen/utils/logger.hpp"
-#include "yaqeen/utils/validators.hpp"
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_set>
 
 namespace yaqeen::core {
 
+namespace {
+
+// Delivers progress events in plan order regardless of which worker
+// finishes first. Events are buffered until every earlier entry is done, and
+// the callback is only ever invoked by one thread at a time.
+class ProgressSequencer {
+public:
+    using Sink = std::function<void(std::string_view, bool, size_t, size_t)>;
+
+    ProgressSequencer(size_t total, Sink sink)
+        : events_(total), sink_(std::move(sink)) {
+    }
+
+    void complete(size_t index, std::string_view path, bool is_directory) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        events_[index] = Event{std::string(path), is_directory, true};
+
+        while (next_ < events_.size() && events_[next_].ready) {
+            auto event = std::move(events_[next_]);
+            events_[next_].path.clear();
+            ++next_;
+            sink_(event.path, event.is_directory, next_, events_.size());
+        }
+    }
+
+private:
+    struct Event {
+        std::string path;
+        bool is_directory = false;
+        bool ready = false;
+    };
+
+    std::mutex mutex_;
+    std::vector<Event> events_;
+    size_t next_ = 0;
+    Sink sink_;
+};
+
+// Owns an open backend directory; shared by the tasks that create its children
+struct OpenDirectory {
+    GenerationBackend& backend;
+    GenerationBackend::DirHandle handle;
+
+    OpenDirectory(GenerationBackend& b, GenerationBackend::DirHandle h) : backend(b), handle(h) {}
+    OpenDirectory(const OpenDirectory&) = delete;
+    OpenDirectory& operator=(const OpenDirectory&) = delete;
+
+    ~OpenDirectory() {
+        backend.close_directory(handle);
+    }
+};
+
+// The child block of a plan directory as one create_entries() batch
+std::vector<CreateRequest> make_requests(const GenerationPlan& plan, size_t dir) {
+    const auto& owner = plan[dir];
+    std::vector<CreateRequest> entries(owner.child_count);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& child = plan[owner.first_child + i];
+        entries[i].name = child.name;
+        entries[i].is_directory = child.is_directory;
+        entries[i].content = child.content;
+    }
+    return entries;
+}
+
+void tally(GenerationStats& stats, const CreateRequest& entry) {
+    if (entry.is_directory) {
+        stats.dirs_created++;
+        return;
+    }
+    if (entry.existed) {
+        stats.files_skipped++;
+    } else {
+        stats.files_created++;
+    }
+    stats.total_size += entry.bytes_written;
+}
+} // namespace
+
 // GenerationStats implementation
+void GenerationStats::merge(const GenerationStats& other) {
+    files_created += other.files_created;
+    files_skipped += other.files_skipped;
+    dirs_created += other.dirs_created;
+    entries_removed += other.entries_removed;
+    bytes_saved += other.bytes_saved;
+    total_size += other.total_size;
+}
+
 std::string GenerationStats::to_string() const {
     std::ostringstream oss;
     oss << "Statistics:\n";
     oss << "  Files created: " << files_created << "\n";
+    if (files_skipped > 0) {
+        oss << "  Files skipped (already exist): " << files_skipped << "\n";
+    }
     oss << "  Directories created: " << dirs_created << "\n";
+    if (entries_removed > 0) {
+        oss << "  Entries removed: " << entries_removed << "\n";
+    }
     oss << "  Total size: " << total_size << " bytes\n";
+    if (bytes_saved > 0) {
+        oss << "  Deduplicated: " << bytes_saved << " bytes\n";
+    }
+    if (syscalls > 0) {
+        oss << "  System calls: " << syscalls << "\n";
+    }
+    if (sqes_submitted > 0) {
+        oss << "  io_uring SQEs/CQEs: " << sqes_submitted << "/" << cqes_completed << "\n";
+    }
     oss << "  Time elapsed: " << elapsed.count() << "ms";
     return oss.str();
 }
@@ -25,11 +137,35 @@ FileGenerator::FileGenerator(Options opts) : options_(std::move(opts)) {
 Result<GenerationStats> FileGenerator::generate(
     const Node& root,
     const std::filesystem::path& output_dir
+) {
+    return generate(GenerationPlan::compile(root), output_dir);
+}
+
+Result<GenerationStats> FileGenerator::generate(
+    const NodeStore& tree,
+    const std::filesystem::path& output_dir
+) {
+    return generate(GenerationPlan::compile(tree), output_dir);
+}
+
+Result<GenerationStats> FileGenerator::generate(
+    const GenerationPlan& plan,
+    const std::filesystem::path& output_dir
 ) {
     //LOG_INFO("Starting generation at: {}", output_dir.string());
 
-    // Validate before generating
-    auto validation = validate(root, output_dir);
+    if (plan.empty()) {
+        return Error(ErrorCode::InvalidInput, "Generation plan is empty");
+    }
+
+    bool root_is_directory = plan[0].is_directory;
+    if (options_.incremental && root_is_directory && !options_.sink) {
+        return generate_incremental(plan, output_dir);
+    }
+
+    // Validate before generating; a sink decides for itself where output
+    // goes, but its entry names are checked all the same
+    auto validation = validate(plan, output_dir);
     if (validation.is_error()) {
         return validation.error();
     }
@@ -38,189 +174,703 @@ Result<GenerationStats> FileGenerator::generate(
     stats_ = GenerationStats{};
     start_time_ = std::chrono::steady_clock::now();
 
-    // Count total nodes for progress tracking
-    size_t total = count_nodes(root);
-    size_t current = 0;
+    std::unique_ptr<GenerationBackend> owned_backend;
+    GenerationBackend* backend = select_backend(owned_backend);
+
+    // Sinks receive entries strictly in plan order
+    bool on_disk = !options_.dry_run && !options_.sink;
+
+    Result<void> result;
+    if (!root_is_directory) {
+        result = generate_root_file(*backend, plan, output_dir);
+    } else if (options_.atomic && on_disk) {
+        result = generate_atomic(*backend, plan, output_dir);
+    } else if (options_.parallel && on_disk) {
+        result = generate_parallel(*backend, plan, output_dir, output_dir);
+    } else {
+        result = generate_serial(*backend, plan, output_dir, output_dir);
+    }
 
-    // Generate from root
-    auto result = generate_node(root, output_dir, current, total);
+    if (result.is_ok()) {
+        result = backend->finish();
+    }
     if (result.is_error()) {
         return result.error();
     }
 
+    finish_stats(*backend);
+
+    //LOG_INFO("Generation complete: {} files, {} directories",
+    //         stats_.files_created, stats_.dirs_created);
+
+    return stats_;
+}
+
+GenerationBackend* FileGenerator::select_backend(std::unique_ptr<GenerationBackend>& owned) {
+    if (options_.dry_run) {
+        owned = std::make_unique<NullBackend>();
+        return owned.get();
+    }
+    if (options_.sink) {
+        return options_.sink;
+    }
+
+    BackendOptions backend_options;
+    backend_options.overwrite = options_.overwrite;
+    backend_options.queue_depth = options_.queue_depth;
+    backend_options.dedup = options_.dedup;
+    backend_options.dedup_hardlinks = options_.dedup_hardlinks;
+    owned = make_backend(options_.backend, backend_options);
+    return owned.get();
+}
+
+void FileGenerator::finish_stats(const GenerationBackend& backend) {
+    auto counters = backend.counters();
+    stats_.syscalls = counters.syscalls;
+    stats_.bytes_saved = counters.bytes_saved;
+    stats_.sqes_submitted = counters.sqes_submitted;
+    stats_.cqes_completed = counters.cqes_completed;
+
     // Calculate elapsed time
     auto end_time = std::chrono::steady_clock::now();
     stats_.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
         end_time - start_time_
     );
+}
 
-    //LOG_INFO("Generation complete: {} files, {} directories",
-    //         stats_.files_created, stats_.dirs_created);
+Result<GenerationStats> FileGenerator::generate_stream(
+    EntryQueue& queue,
+    const std::filesystem::path& output_dir
+) {
+    bool on_disk = !options_.dry_run && !options_.sink;
+    if (on_disk && (options_.atomic || options_.incremental || options_.parallel)) {
+        queue.cancel();
+        return Error(ErrorCode::InvalidInput,
+                     "Atomic, incremental and parallel generation need the whole tree and cannot stream");
+    }
+
+    stats_ = GenerationStats{};
+    start_time_ = std::chrono::steady_clock::now();
+
+    std::unique_ptr<GenerationBackend> owned_backend;
+    GenerationBackend* backend = select_backend(owned_backend);
+
+    // The chain of open directories from the root down; frame k is the
+    // directory at depth k. The root is opened only once the first entry
+    // has been checked, so a stream rejected outright leaves nothing behind.
+    struct Frame {
+        GenerationBackend::DirHandle handle;
+        size_t mark;
+    };
+    std::vector<Frame> open;
+    PathBuffer path(output_dir.string());
+    size_t created = 0;
+
+    // The latest entry when it is a file, so that an entry nested under it
+    // is reported as such; carried over by copy when its batch is consumed
+    const std::string* last_file = nullptr;
+    std::string carried_file;
+
+    auto close_to = [&](size_t depth) {
+        while (open.size() > depth) {
+            backend->close_directory(open.back().handle);
+            path.pop(open.back().mark);
+            open.pop_back();
+        }
+    };
+
+    // Runs of files in one directory go to the backend as one batch; names
+    // point into the current EntryBatch, so runs never outlive it
+    std::vector<CreateRequest> run;
+    auto flush = [&]() -> Result<void> {
+        if (run.empty()) {
+            return Result<void>();
+        }
+        auto written = backend->create_entries(open.back().handle, run, path.view());
+        if (written.is_error()) {
+            return written;
+        }
+        for (const auto& entry : run) {
+            size_t mark = path.push(*entry.name);
+            tally(stats_, entry);
+            notify_progress(path.view(), false, ++created, 0);
+            path.pop(mark);
+        }
+        run.clear();
+        return Result<void>();
+    };
+
+    auto consume = [&](EntryBatch& batch) -> Result<void> {
+        for (const auto& entry : batch) {
+            // The root is at depth 0 whether or not it is open yet
+            size_t levels = std::max<size_t>(open.size(), 1);
+            if (last_file && entry.depth == levels + 1) {
+                return Error(ErrorCode::InvalidTemplateStructure,
+                             "Cannot create \"" + entry.name + "\" inside file " +
+                             path.str() + "/" + *last_file);
+            }
+            if (entry.depth == 0 || entry.depth > levels) {
+                return Error(ErrorCode::InvalidTemplateStructure,
+                             "Entry \"" + entry.name + "\" has no parent in " + path.str());
+            }
+            if (!is_valid_entry_name(entry.name)) {
+                return Error(ErrorCode::InvalidTemplateStructure,
+                             "Invalid name \"" + entry.name + "\" in " + path.str());
+            }
+            last_file = entry.is_directory ? nullptr : &entry.name;
+
+            if (open.empty()) {
+                auto root = backend->open_root(output_dir);
+                if (root.is_error()) {
+                    return root.error();
+                }
+                open.push_back(Frame{root.value(), path.str().size()});
+                stats_.dirs_created++;
+                notify_progress(path.view(), true, ++created, 0);
+            }
+
+            // A file continuing the current run joins its batch
+            if (!entry.is_directory && entry.depth == open.size()) {
+                CreateRequest request;
+                request.name = &entry.name;
+                run.push_back(request);
+                continue;
+            }
+
+            auto flushed = flush();
+            if (flushed.is_error()) {
+                return flushed;
+            }
+            close_to(entry.depth);
+
+            if (!entry.is_directory) {
+                CreateRequest request;
+                request.name = &entry.name;
+                run.push_back(request);
+                continue;
+            }
 
+            size_t mark = path.push(entry.name);
+            auto made = backend->create_directory(open.back().handle, entry.name, path.view());
+            if (made.is_error()) {
+                return made;
+            }
+            auto opened = backend->open_directory(open.back().handle, entry.name, path.view());
+            if (opened.is_error()) {
+                return opened.error();
+            }
+            open.push_back(Frame{opened.value(), mark});
+            stats_.dirs_created++;
+            notify_progress(path.view(), true, ++created, 0);
+        }
+
+        if (last_file) {
+            carried_file = *last_file;
+            last_file = &carried_file;
+        }
+        return flush();
+    };
+
+    Result<void> result;
+    EntryBatch batch;
+    while (queue.pop(batch)) {
+        result = consume(batch);
+        if (result.is_error()) {
+            break;
+        }
+    }
+
+    close_to(0);
+    if (result.is_error()) {
+        queue.cancel();
+        return result.error();
+    }
+
+    // Nothing arrived: an empty or cancelled stream creates nothing
+    if (created > 0) {
+        result = backend->finish();
+        if (result.is_error()) {
+            return result.error();
+        }
+    }
+
+    finish_stats(*backend);
     return stats_;
 }
 
-Result<void> FileGenerator::create_file(
-    const std::filesystem::path& path,
-    const std::string& content
+Result<GenerationStats> FileGenerator::generate_streaming(
+    std::istream& in,
+    const std::filesystem::path& output_dir,
+    size_t queue_capacity
 ) {
-    if (options_.dry_run) {
-        //LOG_INFO("[DRY RUN] Would create file: {}", path.string());
-        return Result<void>();
+    constexpr size_t kBatchSize = 256;
+    EntryQueue queue(queue_capacity);
+
+    Result<void> parsed;
+    std::thread producer([&] {
+        MarkdownParser parser;
+        EntryBatch batch;
+        parsed = parser.parse_stream(in, [&](StreamEntry&& entry) {
+            batch.push_back(std::move(entry));
+            if (batch.size() < kBatchSize) {
+                return true;
+            }
+            bool accepted = queue.push(std::move(batch));
+            batch = EntryBatch{};
+            return accepted;
+        });
+        if (parsed.is_ok() && !batch.empty()) {
+            queue.push(std::move(batch));
+        }
+        queue.close();
+    });
+
+    auto generated = generate_stream(queue, output_dir);
+    queue.cancel();
+    producer.join();
+
+    // A parse error explains a short stream better than what it led to
+    if (parsed.is_error()) {
+        return parsed.error();
     }
+    return generated;
+}
 
-    // Check if file already exists
-    if (std::filesystem::exists(path) && !options_.overwrite) {
-        if (should_skip_existing(path)) {
-            //LOG_DEBUG("Skipping existing file: {}", path.string());
-            return Result<void>();
+Result<GenerationStats> FileGenerator::generate_incremental(
+    const GenerationPlan& plan,
+    const std::filesystem::path& output_dir
+) {
+    if (options_.atomic) {
+        return Error(ErrorCode::InvalidInput,
+                    "Incremental generation cannot be combined with atomic mode");
+    }
+
+    stats_ = GenerationStats{};
+    start_time_ = std::chrono::steady_clock::now();
+
+    // A missing or unreadable manifest means everything is new
+    auto manifest_path = output_dir / Manifest::kFileName;
+    auto loaded = Manifest::load(manifest_path);
+    if (loaded.is_error() && loaded.error().code != ErrorCode::FileNotFound) {
+        LOG_WARN("Ignoring manifest: " + loaded.error().message);
+    }
+    Manifest previous = loaded.is_ok() ? std::move(loaded.value()) : Manifest();
+
+    auto next = Manifest::from_plan(plan);
+    auto diff = ManifestDiff::compute(previous, next);
+    bool prune = options_.prune && !diff.removed.empty();
+
+    stats_.files_skipped = diff.unchanged_files;
+    if (!diff.has_writes() && !prune) {
+        stats_.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start_time_);
+        return stats_;
+    }
+
+    // Drop the manifest first: if this run is interrupted, the next one
+    // regenerates everything instead of trusting a stale record
+    if (!options_.dry_run && !previous.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(manifest_path, ec);
+    }
+
+    // Entries whose type changed must go regardless of prune, and with them
+    // whatever the previous run created inside a replaced directory
+    std::unordered_set<std::string_view> next_paths;
+    for (const auto& entry : next.entries()) {
+        next_paths.insert(entry.path);
+    }
+    std::vector<std::string> replaced_dirs;
+    for (size_t index : diff.removed) {
+        const auto& entry = previous.entries()[index];
+        if (entry.is_directory && next_paths.count(entry.path) > 0) {
+            replaced_dirs.push_back(entry.path + '/');
         }
-        return Error(ErrorCode::FileAlreadyExists, "File already exists: " + path.string());
     }
+    auto must_remove = [&](const std::string& path) {
+        if (options_.prune || next_paths.count(path) > 0) {
+            return true;
+        }
+        for (const auto& prefix : replaced_dirs) {
+            if (path.compare(0, prefix.size(), prefix) == 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Children are listed before their parents, so directories empty out
+    // first. Whatever stays on disk stays in the manifest too, so that a
+    // later prune can still find it.
+    std::vector<size_t> left_behind;
+    for (size_t index : diff.removed) {
+        const auto& entry = previous.entries()[index];
+        if (!must_remove(entry.path)) {
+            left_behind.push_back(index);
+            continue;
+        }
+
+        if (options_.dry_run) {
+            stats_.entries_removed++;
+            continue;
+        }
 
-    // Create parent directory if needed
-    auto parent = path.parent_path();
-    if (!parent.empty() && !std::filesystem::exists(parent)) {
         std::error_code ec;
-        std::filesystem::create_directories(parent, ec);
-        if (ec) {
-            return Error(ErrorCode::CannotCreateDirectory,
-                        "Cannot create parent directory: " + parent.string(),
+        if (std::filesystem::remove(output_dir / entry.path, ec)) {
+            stats_.entries_removed++;
+        } else if (ec && !entry.is_directory) {
+            return Error(ErrorCode::PermissionDenied,
+                        "Cannot remove: " + (output_dir / entry.path).string(),
                         ec.message());
+        } else if (ec) {
+            LOG_WARN("Keeping non-empty directory: " + (output_dir / entry.path).string());
+            if (next_paths.count(entry.path) == 0) {
+                left_behind.push_back(index);
+            }
         }
     }
 
-    // Write file
-    std::ofstream file(path);
-    if (!file) {
-        return Error(ErrorCode::CannotCreateFile, "Cannot create file: " + path.string());
+    if (diff.has_writes()) {
+        // Manifest entry i describes plan entry i + 1 (the root is not listed).
+        // Only changed entries are ours to rewrite; an added one may collide
+        // with a file the user made, which is left alone unless overwrite is on.
+        auto write_entries = [&](const std::vector<size_t>& indices, bool overwrite) -> Result<void> {
+            if (indices.empty()) {
+                return Result<void>();
+            }
+            std::vector<bool> wanted(plan.size(), false);
+            for (size_t index : indices) {
+                wanted[index + 1] = true;
+            }
+            auto selected = plan.subset(wanted);
+
+            Options sub_options = options_;
+            sub_options.incremental = false;
+            sub_options.overwrite = overwrite;
+
+            auto result = FileGenerator(sub_options).generate(selected, output_dir);
+            if (result.is_error()) {
+                return result.error();
+            }
+            const auto& stats = result.value();
+            stats_.merge(stats);
+            stats_.syscalls += stats.syscalls;
+            stats_.sqes_submitted += stats.sqes_submitted;
+            stats_.cqes_completed += stats.cqes_completed;
+            return Result<void>();
+        };
+
+        auto added = write_entries(diff.added, options_.overwrite);
+        if (added.is_error()) {
+            return added.error();
+        }
+        auto changed = write_entries(diff.changed, true);
+        if (changed.is_error()) {
+            return changed.error();
+        }
     }
 
-    if (!content.empty()) {
-        file << content;
+    if (!options_.dry_run) {
+        // Back in plan order, parents before children
+        for (auto it = left_behind.rbegin(); it != left_behind.rend(); ++it) {
+            next.add_leftover(previous.entries()[*it]);
+        }
+        auto saved = next.save(manifest_path);
+        if (saved.is_error()) {
+            return saved.error();
+        }
     }
 
-    file.close();
+    stats_.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time_);
+    return stats_;
+}
+
+Result<void> FileGenerator::validate(const GenerationPlan& plan, const std::filesystem::path& output_dir) {
+    // Reject the whole plan up front rather than failing halfway through
+    PreflightOptions preflight_options;
+    preflight_options.overwrite = options_.overwrite;
+    preflight_options.fresh = options_.atomic && plan[0].is_directory;
+    preflight_options.names_only = options_.sink != nullptr;
+
+    auto checked = preflight(plan, output_dir, preflight_options);
+    if (checked.is_error()) {
+        return checked.error();
+    }
 
-    //LOG_DEBUG("Created file: {}", path.string());
     return Result<void>();
 }
 
-Result<void> FileGenerator::create_directory(const std::filesystem::path& path) {
-    if (options_.dry_run) {
-        //LOG_INFO("[DRY RUN] Would create directory: {}", path.string());
+Result<void> FileGenerator::generate_root_file(
+    GenerationBackend& backend,
+    const GenerationPlan& plan,
+    const std::filesystem::path& output_path
+) {
+    if (options_.atomic && !options_.dry_run && !options_.sink) {
+        auto written = write_file_atomically(output_path, plan[0].content, options_.overwrite);
+        if (written.is_error()) {
+            return written.error();
+        }
+
+        if (written.value().existed) {
+            stats_.files_skipped++;
+        } else {
+            stats_.files_created++;
+        }
+        stats_.total_size += written.value().bytes_written;
+        notify_progress(output_path.string(), false, 1, 1);
         return Result<void>();
     }
 
-    if (std::filesystem::exists(path)) {
-        if (std::filesystem::is_directory(path)) {
-            //LOG_DEBUG("Directory already exists: {}", path.string());
-            return Result<void>();
-        }
-        return Error(ErrorCode::FileAlreadyExists,
-                    "Path exists but is not a directory: " + path.string());
+    auto parent = output_path.parent_path();
+    auto dir = backend.open_root(parent.empty() ? std::filesystem::path(".") : parent);
+    if (dir.is_error()) {
+        return dir.error();
     }
 
-    std::error_code ec;
-    std::filesystem::create_directories(path, ec);
-    if (ec) {
-        return Error(ErrorCode::CannotCreateDirectory,
-                    "Cannot create directory: " + path.string(),
-                    ec.message());
+    auto written = backend.create_file(
+        dir.value(), output_path.filename().string(), plan[0].content, output_path.string());
+    backend.close_directory(dir.value());
+
+    if (written.is_error()) {
+        return written.error();
     }
 
-    //LOG_DEBUG("Created directory: {}", path.string());
+    if (written.value().existed) {
+        stats_.files_skipped++;
+    } else {
+        stats_.files_created++;
+    }
+    stats_.total_size += written.value().bytes_written;
+    notify_progress(output_path.string(), false, 1, 1);
     return Result<void>();
 }
 
-Result<void> FileGenerator::validate(const Node& root, const std::filesystem::path& output_dir) {
-    // Check if output directory's parent exists
-    if (!output_dir.empty()) {
-        auto parent = output_dir.parent_path();
-        if (!parent.empty() && !std::filesystem::exists(parent)) {
-            return Error(ErrorCode::DirectoryNotFound,
-                        "Parent directory does not exist: " + parent.string());
+Result<void> FileGenerator::generate_atomic(
+    GenerationBackend& backend,
+    const GenerationPlan& plan,
+    const std::filesystem::path& output_dir
+) {
+    std::error_code ec;
+    auto status = std::filesystem::symlink_status(output_dir, ec);
+    if (std::filesystem::exists(status)) {
+        if (!std::filesystem::is_directory(status)) {
+            return Error(ErrorCode::FileAlreadyExists,
+                        "Path exists but is not a directory: " + output_dir.string());
+        }
+        if (!options_.overwrite) {
+            return Error(ErrorCode::FileAlreadyExists,
+                        "Output directory already exists: " + output_dir.string(),
+                        "atomic generation replaces it only when overwriting");
         }
     }
 
-    // Check write permissions
-    auto writable = Validator::validate_path_writable(output_dir);
-    if (writable.is_error()) {
-        return writable;
+    auto staging = StagingDirectory::create(output_dir);
+    if (staging.is_error()) {
+        return staging.error();
     }
 
-    return Result<void>();
+    // On error the staging directory is removed when it goes out of scope
+    const auto& build_dir = staging.value().path();
+    auto result = options_.parallel
+        ? generate_parallel(backend, plan, build_dir, output_dir)
+        : generate_serial(backend, plan, build_dir, output_dir);
+    if (result.is_error()) {
+        return result;
+    }
+
+    return staging.value().publish(options_.overwrite);
 }
 
-Result<void> FileGenerator::generate_node(
-    const Node& node,
-    const std::filesystem::path& current_path,
-    size_t& current,
-    size_t total
+Result<void> FileGenerator::generate_serial(
+    GenerationBackend& backend,
+    const GenerationPlan& plan,
+    const std::filesystem::path& build_dir,
+    const std::filesystem::path& output_dir
 ) {
-    current++;
+    size_t total = plan.size();
 
-    notify_progress(current_path, node.is_directory(), current, total);
+    auto root_dir = backend.open_root(build_dir);
+    if (root_dir.is_error()) {
+        return root_dir.error();
+    }
 
-    if (node.is_directory()) {
-        // Create directory
-        auto result = create_directory(current_path);
-        if (result.is_error()) {
-            return result;
+    PathBuffer path(output_dir.string());
+    stats_.dirs_created++;
+    notify_progress(path.view(), true, 1, total);
+
+    // The chain of open directories from the root down; frame k holds the
+    // directory at depth k. Child blocks follow in depth-first order, so the
+    // owner of the next block is always a child of an open directory.
+    struct Frame {
+        uint32_t index;
+        GenerationBackend::DirHandle handle;
+        size_t mark;
+    };
+    std::vector<Frame> open{{0, root_dir.value(), 0}};
+
+    auto close_to = [&](size_t depth) {
+        while (open.size() > depth) {
+            backend.close_directory(open.back().handle);
+            path.pop(open.back().mark);
+            open.pop_back();
         }
+    };
 
-        stats_.dirs_created++;
+    for (size_t p = 1; p < plan.size();) {
+        uint32_t owner = plan[p].parent;
+        size_t depth = plan[owner].depth;
 
-        // Process children
-        for (const auto& child : node.children) {
-            auto child_path = current_path / child->name;
-            auto child_result = generate_node(*child, child_path, current, total);
-            if (child_result.is_error()) {
-                return child_result;
+        if (open.size() > depth && open[depth].index == owner) {
+            close_to(depth + 1);
+        } else {
+            close_to(depth);
+
+            const auto& name = *plan[owner].name;
+            size_t mark = path.push(name);
+            auto opened = backend.open_directory(open.back().handle, name, path.view());
+            if (opened.is_error()) {
+                path.pop(mark);
+                close_to(0);
+                return opened.error();
             }
-        }
-    } else {
-        // Create file
-        std::string content = node.content.value_or("");
-        auto result = create_file(current_path, content);
-        if (result.is_error()) {
-            return result;
+            open.push_back(Frame{owner, opened.value(), mark});
         }
 
-        stats_.files_created++;
+        // Create the whole block in one backend call so batching backends
+        // can submit the directory at once
+        auto entries = make_requests(plan, owner);
+        auto created = backend.create_entries(open.back().handle, entries, path.view());
+        if (created.is_error()) {
+            close_to(0);
+            return created;
+        }
 
-        // Update total size
-        if (std::filesystem::exists(current_path)) {
-            stats_.total_size += std::filesystem::file_size(current_path);
+        for (size_t i = 0; i < entries.size(); ++i, ++p) {
+            size_t mark = path.push(*entries[i].name);
+            tally(stats_, entries[i]);
+            notify_progress(path.view(), entries[i].is_directory, p + 1, total);
+            path.pop(mark);
         }
     }
 
+    close_to(0);
     return Result<void>();
 }
 
-size_t FileGenerator::count_nodes(const Node& node) const {
-    size_t count = 1; // Count this node
+Result<void> FileGenerator::generate_parallel(
+    GenerationBackend& backend,
+    const GenerationPlan& plan,
+    const std::filesystem::path& build_dir,
+    const std::filesystem::path& output_dir
+) {
+    std::unique_ptr<ProgressSequencer> sequencer;
+    if (options_.progress_callback || options_.verbose) {
+        sequencer = std::make_unique<ProgressSequencer>(plan.size(),
+            [this](std::string_view path, bool is_dir, size_t current, size_t count) {
+                notify_progress(path, is_dir, current, count);
+            });
+    }
 
-    for (const auto& child : node.children) {
-        count += count_nodes(*child);
+    auto report = [&sequencer](size_t index, std::string_view path, bool is_dir) {
+        if (sequencer) {
+            sequencer->complete(index, path, is_dir);
+        }
+    };
+
+    // The root is created up front so that every task starts from an existing parent
+    auto root_dir = backend.open_root(build_dir);
+    if (root_dir.is_error()) {
+        return root_dir.error();
     }
+    auto root_ref = std::make_shared<OpenDirectory>(backend, root_dir.value());
+    stats_.dirs_created++;
+    report(0, output_dir.string(), true);
 
-    return count;
-}
+    WorkStealingPool pool(WorkStealingPool::resolve_thread_count(options_.max_threads));
+    std::vector<GenerationStats> worker_stats(pool.size());
 
-bool FileGenerator::should_skip_existing(const std::filesystem::path& path) const {
-    // In non-overwrite mode, skip existing files
-    return !options_.overwrite;
+    std::mutex error_mutex;
+    std::optional<Error> first_error;
+    std::atomic<bool> failed{false};
+
+    auto fail = [&](const Error& error) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!first_error) {
+            first_error = error;
+        }
+        failed.store(true, std::memory_order_relaxed);
+    };
+
+    // Creates the child block of an open directory, then schedules each
+    // non-empty subdirectory as an independent task. A task keeps its
+    // parent open only until it has opened its own directory.
+    std::function<void(uint32_t, std::shared_ptr<OpenDirectory>, const std::string&)> populate;
+    populate = [&](uint32_t dir, std::shared_ptr<OpenDirectory> handle, const std::string& dir_path) {
+        auto& stats = worker_stats[pool.current_worker()];
+        PathBuffer path(dir_path);
+
+        auto entries = make_requests(plan, dir);
+        auto created = backend.create_entries(handle->handle, entries, path.view());
+        if (created.is_error()) {
+            fail(created.error());
+            return;
+        }
+
+        for (size_t i = 0; i < entries.size(); ++i) {
+            auto index = static_cast<uint32_t>(plan[dir].first_child + i);
+            const auto& child = plan[index];
+            size_t mark = path.push(*child.name);
+
+            tally(stats, entries[i]);
+            report(index, path.view(), child.is_directory);
+
+            if (child.child_count > 0 && !failed.load(std::memory_order_relaxed)) {
+                pool.submit([&, index, parent = handle, child_path = path.str()]() mutable {
+                    if (failed.load(std::memory_order_relaxed)) {
+                        return;
+                    }
+
+                    auto opened = backend.open_directory(parent->handle, *plan[index].name, child_path);
+                    parent.reset();
+                    if (opened.is_error()) {
+                        fail(opened.error());
+                        return;
+                    }
+
+                    auto own = std::make_shared<OpenDirectory>(backend, opened.value());
+                    populate(index, std::move(own), child_path);
+                });
+            }
+
+            path.pop(mark);
+        }
+    };
+
+    pool.submit([&populate, root_ref = std::move(root_ref), &output_dir]() mutable {
+        populate(0, std::move(root_ref), output_dir.string());
+    });
+    pool.wait();
+
+    for (const auto& stats : worker_stats) {
+        stats_.merge(stats);
+    }
+
+    if (first_error) {
+        return *first_error;
+    }
+
+    return Result<void>();
 }
 
 void FileGenerator::notify_progress(
-    const std::filesystem::path& path,
+    std::string_view path,
     bool is_directory,
     size_t current,
     size_t total
 ) {
     if (options_.progress_callback) {
-        options_.progress_callback(path, is_directory, current, total);
+        options_.progress_callback(std::filesystem::path(path), is_directory, current, total);
     }
 
     if (options_.verbose) {
@@ -238,77 +888,104 @@ Result<GenerationStats> TemplateGenerator::generate_from_json(
     //LOG_INFO("Generating from template for project: {}", options.project_name);
 
     // Convert JSON to node tree
-    auto tree_result = json_to_node_tree(structure, options.project_name);
+    auto tree_result = json_to_store(structure, options.project_name);
     if (tree_result.is_error()) {
         return tree_result.error();
     }
 
-    auto root = std::move(tree_result.value());
+    return generate_from_store(tree_result.value(), options);
+}
 
+Result<GenerationStats> TemplateGenerator::generate_from_store(
+    const NodeStore& tree,
+    const TemplateOptions& options
+) {
     // Create file generator
     FileGenerator::Options gen_options;
     gen_options.dry_run = options.dry_run;
     gen_options.verbose = options.verbose;
+    gen_options.parallel = options.parallel;
+    gen_options.max_threads = options.max_threads;
+    gen_options.atomic = options.atomic;
+    gen_options.incremental = options.incremental;
+    gen_options.prune = options.prune;
+    gen_options.dedup = options.dedup;
+    gen_options.dedup_hardlinks = options.dedup_hardlinks;
+    gen_options.sink = options.sink;
+    gen_options.backend = options.backend;
     gen_options.progress_callback = options.progress_callback;
 
     FileGenerator generator(gen_options);
 
-    return generator.generate(*root, options.output_dir);
+    return generator.generate(tree, options.output_dir);
 }
 
 Result<std::unique_ptr<Node>> TemplateGenerator::json_to_node_tree(
     const nlohmann::json& json_obj,
     const std::string& root_name
+) {
+    auto tree = json_to_store(json_obj, root_name);
+    if (tree.is_error()) {
+        return tree.error();
+    }
+    return tree.value().to_node();
+}
+
+Result<NodeStore> TemplateGenerator::json_to_store(
+    const nlohmann::json& json_obj,
+    const std::string& root_name,
+    std::shared_ptr<NamePool> names
 ) {
     if (!json_obj.is_object()) {
         return Error(ErrorCode::InvalidJSONFormat,
                     "Template structure must be a JSON object");
     }
 
-    auto root = std::make_unique<Node>(Node::Type::Directory, root_name);
-    json_to_node_recursive(json_obj, *root);
+    NodeStore tree(std::move(names));
+    tree.add_root(root_name);
+
+    // parents[depth] is where keys at depth + 1 go
+    std::vector<NodeId> parents;
+    std::optional<Error> conflict;
+    walk_tree(JsonTree{}, JsonTree::Node{{}, &json_obj}, [&](const JsonTree::Node& entry, size_t depth) {
+        parents.resize(depth + 1);
+        if (depth == 0) {
+            parents[0] = tree.root();
+            return WalkAction::Continue;
+        }
 
-    return root;
-}
-
-void TemplateGenerator::json_to_node_recursive(
-    const nlohmann::json& json_obj,
-    Node& parent_node
-) {
-    for (auto it = json_obj.begin(); it != json_obj.end(); ++it) {
-        std::string name = it.key();
-        const auto& value = it.value();
+        std::string_view name = entry.key;
+        const auto& value = *entry.value;
 
         // Determine if this is a file or directory
-        bool is_directory = name.back() == '/' || value.is_object();
+        bool is_directory = (!name.empty() && name.back() == '/') || value.is_object();
 
         // Remove trailing slash if present
         if (!name.empty() && name.back() == '/') {
-            name.pop_back();
+            name.remove_suffix(1);
         }
 
-        if (is_directory) {
-            // Create directory node
-            auto dir_node = std::make_unique<Node>(Node::Type::Directory, name);
-
-            // Recursively process children if it's an object
-            if (value.is_object()) {
-                json_to_node_recursive(value, *dir_node);
-            }
-
-            parent_node.add_child(std::move(dir_node));
-        } else {
-            // Create file node
-            auto file_node = std::make_unique<Node>(Node::Type::File, name);
+        auto placed = tree.place_child(parents[depth - 1], name, is_directory);
+        if (placed.kind == NodeStore::Placement::Conflict) {
+            conflict = tree.conflict(placed, is_directory, ErrorCode::InvalidTemplateStructure);
+            return WalkAction::Stop;
+        }
 
+        if (!is_directory) {
             // Set content if provided as string
-            if (value.is_string() && !value.get<std::string>().empty()) {
-                file_node->content = value.get<std::string>();
+            if (value.is_string()) {
+                tree.set_content(placed.id, value.get_ref<const std::string&>());
             }
-
-            parent_node.add_child(std::move(file_node));
+            return WalkAction::Skip;
         }
+        parents[depth] = placed.id;
+        return WalkAction::Continue;
+    });
+
+    if (conflict) {
+        return *conflict;
     }
+    return tree;
 }
 
 } // namespace yaqeen::core
@@ -0,0 +1,374 @@
+#include "yaqeen/core/glyph_scan.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define YAQEEN_GLYPH_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace yaqeen::core {
+
+namespace {
+
+// Box-drawing glyphs U+2500..U+257F are E2 94 xx or E2 95 xx in UTF-8
+bool glyph_at(std::string_view line, size_t i) {
+    return i + 2 < line.size() && line[i] == '\xE2' &&
+           (line[i + 1] == '\x94' || line[i + 1] == '\x95') &&
+           (static_cast<unsigned char>(line[i + 2]) & 0xC0) == 0x80;
+}
+
+// U+00A0, which tree(1) puts in its indentation
+bool nbsp_at(std::string_view line, size_t i) {
+    return i + 1 < line.size() && line[i] == '\xC2' && line[i + 1] == '\xA0';
+}
+
+// '`', '+' or '\' opening an ASCII branch such as "`-- "
+bool branch_lead_at(std::string_view line, size_t i) {
+    char c = line[i];
+    return (c == '`' || c == '+' || c == '\\') && i + 1 < line.size() && line[i + 1] == '-';
+}
+
+LineClass classify_scalar(std::string_view line, size_t) {
+    LineClass out;
+    size_t i = 0;
+
+    // Dashes belong to the prefix only straight after '|', a branch lead,
+    // a glyph or another such dash
+    bool after_branch = false;
+    while (i < line.size()) {
+        char c = line[i];
+        if (c == ' ' || c == '\t') {
+            out.prefix_columns += c == '\t' ? 4 : 1;
+            after_branch = false;
+            ++i;
+            continue;
+        }
+
+        if (c == '|' || branch_lead_at(line, i) || (c == '-' && after_branch)) {
+            after_branch = true;
+            ++i;
+        } else if (glyph_at(line, i)) {
+            out.has_glyph = true;
+            after_branch = true;
+            i += 3;
+        } else if (nbsp_at(line, i)) {
+            after_branch = false;
+            i += 2;
+        } else {
+            break;
+        }
+        ++out.prefix_columns;
+    }
+    out.prefix_bytes = i;
+    out.name_end = i;
+
+    size_t backticks = 0;
+    while (i < line.size()) {
+        if (glyph_at(line, i)) {
+            out.has_glyph = true;
+            i += 3;
+            backticks = 0;
+            continue;
+        }
+        if (nbsp_at(line, i)) {
+            i += 2;
+            backticks = 0;
+            continue;
+        }
+
+        switch (line[i]) {
+        case ' ':
+        case '\t':
+        case '\r':
+        case '|':
+            backticks = 0;
+            ++i;
+            continue;
+        case '`':
+            out.has_fence = out.has_fence || ++backticks == 3;
+            break;
+        case '.':
+            out.has_dot = true;
+            backticks = 0;
+            break;
+        case '/':
+            out.has_slash = true;
+            backticks = 0;
+            break;
+        default:
+            backticks = 0;
+            break;
+        }
+        out.name_end = ++i;
+    }
+
+    return out;
+}
+
+#if YAQEEN_GLYPH_SCAN_X86
+
+// One bit per byte of a window, bit i for byte i
+struct Masks {
+    uint64_t space, tab, cr, pipe, dash, lead, dot, slash, backtick;
+    uint64_t e2, box, cont, c2, a0;
+};
+
+inline uint64_t low_bits(size_t n) {
+    return n >= 64 ? ~uint64_t{0} : (uint64_t{1} << n) - 1;
+}
+
+inline size_t popcount(uint64_t bits) {
+    return static_cast<size_t>(__builtin_popcountll(bits));
+}
+
+// The vector scanners share this loop and differ only in how a window of
+// W bytes becomes Masks. Multi-byte patterns are recognised only when they
+// fit in the window, so each step commits bytes up to W - 2 (or to the end
+// of a glyph straddling that point) and the next window starts there.
+// Bytes of a window past the line are zeroed, which matches nothing; they
+// are loaded in place while still inside `readable`, else copied out.
+template <size_t W, typename Load>
+inline LineClass classify_windows(std::string_view line, size_t readable, Load load) {
+    LineClass out;
+    const size_t size = line.size();
+
+    alignas(32) char padded[W];
+    auto window = [&](size_t offset) {
+        size_t left = size - offset;
+        if (left >= W || readable - offset >= W) {
+            return load(line.data() + offset, left < W ? left : W);
+        }
+        std::memset(padded, 0, W);
+        std::memcpy(padded, line.data() + offset, left);
+        return load(padded, W);
+    };
+
+    auto resume_at = [](uint64_t tails) {
+        size_t q = W - 2;
+        while (q < W && ((tails >> q) & 1)) {
+            ++q;
+        }
+        return q;
+    };
+
+    size_t offset = 0;
+    bool in_prefix = true;
+    bool carry = false;
+    while (offset < size) {
+        const Masks m = window(offset);
+        const size_t left = size - offset;
+        const bool last = left <= W;
+
+        uint64_t glyphs = m.e2 & (m.box >> 1) & (m.cont >> 2);
+        uint64_t nbsp = m.c2 & (m.a0 >> 1);
+        uint64_t tails = (glyphs << 1) | (glyphs << 2) | (nbsp << 1);
+        size_t resume = last ? left : resume_at(tails);
+
+        // The prefix, until the first byte that cannot belong to it; the
+        // rest of that window is then read as the name
+        size_t prefix = 0;
+        if (in_prefix) {
+            uint64_t leads = m.lead & (m.dash >> 1);
+
+            // A dash run is part of the prefix when it follows a branch;
+            // adding its first bit carries through the run and clears it
+            uint64_t ends = m.pipe | leads | (glyphs << 2);
+            uint64_t starts = m.dash & ((ends << 1) | (carry ? 1 : 0));
+            uint64_t dashes = m.dash & ~(m.dash + starts);
+
+            uint64_t covered = m.space | m.tab | m.pipe | glyphs | nbsp | tails | leads | dashes;
+            size_t run = static_cast<size_t>(__builtin_ctzll(~covered));
+
+            // A run reaching the uncommitted end of the window may go on
+            bool more = !last && run >= W - 2;
+            prefix = more ? resume : run;
+
+            uint64_t bits = low_bits(prefix);
+            out.prefix_columns += popcount(covered & ~m.cont & bits) + 3 * popcount(m.tab & bits);
+            out.has_glyph = out.has_glyph || (glyphs & bits) != 0;
+
+            if (more) {
+                carry = ((ends | dashes) >> (prefix - 1)) & 1;
+                offset += prefix;
+                continue;
+            }
+            in_prefix = false;
+            out.prefix_bytes = offset + prefix;
+            out.name_end = offset + prefix;
+        }
+
+        uint64_t bits = low_bits(resume) & ~low_bits(prefix);
+        uint64_t frame = m.space | m.tab | m.cr | m.pipe | glyphs | nbsp | tails;
+        uint64_t name = ~frame & bits;
+        if (name != 0) {
+            out.name_end = offset + 64 - static_cast<size_t>(__builtin_clzll(name));
+        }
+
+        out.has_glyph = out.has_glyph || (glyphs & bits) != 0;
+        out.has_dot = out.has_dot || (m.dot & bits) != 0;
+        out.has_slash = out.has_slash || (m.slash & bits) != 0;
+        out.has_fence = out.has_fence || (m.backtick & (m.backtick >> 1) & (m.backtick >> 2) & bits) != 0;
+        offset += resume;
+    }
+
+    if (in_prefix) {
+        out.prefix_bytes = offset;
+        out.name_end = offset;
+    }
+
+    return out;
+}
+
+inline uint64_t movemask16(__m128i bytes) {
+    return static_cast<uint16_t>(_mm_movemask_epi8(bytes));
+}
+
+inline uint64_t eq16(__m128i v, char c) {
+    return movemask16(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+}
+
+// 32 set bytes then 32 clear ones; a load at 32 - n keeps the first n bytes
+alignas(64) const unsigned char keep_table[64] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+// SSE2 is part of x86-64, so this needs no target attribute
+inline Masks load_sse2(const char* p, size_t keep) {
+    __m128i v = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+                              _mm_loadu_si128(reinterpret_cast<const __m128i*>(keep_table + 32 - keep)));
+    Masks m;
+    m.space = eq16(v, ' ');
+    m.tab = eq16(v, '\t');
+    m.cr = eq16(v, '\r');
+    m.pipe = eq16(v, '|');
+    m.dash = eq16(v, '-');
+    m.backtick = eq16(v, '`');
+    m.lead = m.backtick | eq16(v, '+') | eq16(v, '\\');
+    m.dot = eq16(v, '.');
+    m.slash = eq16(v, '/');
+    m.e2 = eq16(v, '\xE2');
+    m.box = eq16(v, '\x94') | eq16(v, '\x95');
+    // 0x80..0xBF are the signed bytes below -64
+    m.cont = movemask16(_mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(0xC0))));
+    m.c2 = eq16(v, '\xC2');
+    m.a0 = eq16(v, '\xA0');
+    return m;
+}
+
+LineClass classify_sse2(std::string_view line, size_t readable) {
+    return classify_windows<16>(line, readable, [](const char* p, size_t keep) { return load_sse2(p, keep); });
+}
+
+__attribute__((target("avx2"))) inline uint64_t movemask32(__m256i bytes) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(bytes));
+}
+
+__attribute__((target("avx2"))) inline uint64_t eq32(__m256i v, char c) {
+    return movemask32(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)));
+}
+
+__attribute__((target("avx2"))) inline Masks load_avx2(const char* p, size_t keep) {
+    __m256i v = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)),
+                                 _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keep_table + 32 - keep)));
+    Masks m;
+    m.space = eq32(v, ' ');
+    m.tab = eq32(v, '\t');
+    m.cr = eq32(v, '\r');
+    m.pipe = eq32(v, '|');
+    m.dash = eq32(v, '-');
+    m.backtick = eq32(v, '`');
+    m.lead = m.backtick | eq32(v, '+') | eq32(v, '\\');
+    m.dot = eq32(v, '.');
+    m.slash = eq32(v, '/');
+    m.e2 = eq32(v, '\xE2');
+    m.box = eq32(v, '\x94') | eq32(v, '\x95');
+    m.cont = movemask32(_mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(0xC0)), v));
+    m.c2 = eq32(v, '\xC2');
+    m.a0 = eq32(v, '\xA0');
+    return m;
+}
+
+// flatten pulls the shared loop and the loads into this AVX2 body
+__attribute__((target("avx2"), flatten)) LineClass classify_avx2(std::string_view line, size_t readable) {
+    return classify_windows<32>(line, readable, [](const char* p, size_t keep) { return load_avx2(p, keep); });
+}
+
+#endif // YAQEEN_GLYPH_SCAN_X86
+
+using Classifier = LineClass (*)(std::string_view, size_t);
+
+Classifier classifier_for(GlyphScanner scanner) {
+    switch (scanner) {
+#if YAQEEN_GLYPH_SCAN_X86
+    case GlyphScanner::SSE2:
+        return classify_sse2;
+    case GlyphScanner::AVX2:
+        return classify_avx2;
+#endif
+    default:
+        return classify_scalar;
+    }
+}
+
+} // namespace
+
+GlyphScanner detect_glyph_scanner() {
+    static const GlyphScanner detected = [] {
+#if YAQEEN_GLYPH_SCAN_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return GlyphScanner::AVX2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return GlyphScanner::SSE2;
+        }
+#endif
+        return GlyphScanner::Scalar;
+    }();
+    return detected;
+}
+
+bool glyph_scanner_supported(GlyphScanner scanner) {
+    switch (scanner) {
+    case GlyphScanner::Auto:
+    case GlyphScanner::Scalar:
+        return true;
+    case GlyphScanner::SSE2:
+        return detect_glyph_scanner() != GlyphScanner::Scalar;
+    case GlyphScanner::AVX2:
+        return detect_glyph_scanner() == GlyphScanner::AVX2;
+    }
+    return false;
+}
+
+const char* glyph_scanner_name(GlyphScanner scanner) {
+    switch (scanner) {
+    case GlyphScanner::Auto:
+        return glyph_scanner_name(detect_glyph_scanner());
+    case GlyphScanner::Scalar:
+        return "scalar";
+    case GlyphScanner::SSE2:
+        return "sse2";
+    case GlyphScanner::AVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+LineClass classify_line(std::string_view line, size_t readable, GlyphScanner scanner) {
+    static const Classifier best = classifier_for(detect_glyph_scanner());
+    readable = readable < line.size() ? line.size() : readable;
+    if (scanner == GlyphScanner::Auto) {
+        return best(line, readable);
+    }
+    return classifier_for(glyph_scanner_supported(scanner) ? scanner : GlyphScanner::Scalar)(line, readable);
+}
+
+LineClass classify_line(std::string_view line, GlyphScanner scanner) {
+    return classify_line(line, line.size(), scanner);
+}
+
+} // namespace yaqeen::core
@@ -0,0 +1,239 @@
+#include "yaqeen/core/manifest.hpp"
+#include "yaqeen/core/staging.hpp"
+#include "yaqeen/utils/hash.hpp"
+#include "yaqeen/utils/mapped_file.hpp"
+#include <unordered_map>
+
+namespace yaqeen::core {
+
+namespace {
+    constexpr std::string_view kHeader = "# yaqeen manifest v1";
+
+    // Paths are the last field of a line; newlines and backslashes are escaped
+    void append_escaped(std::string& out, std::string_view path) {
+        for (char c : path) {
+            if (c == '\\') {
+                out += "\\\\";
+            } else if (c == '\n') {
+                out += "\\n";
+            } else {
+                out += c;
+            }
+        }
+    }
+
+    std::string unescape(std::string_view path) {
+        std::string out;
+        out.reserve(path.size());
+        for (size_t i = 0; i < path.size(); ++i) {
+            if (path[i] == '\\' && i + 1 < path.size()) {
+                out += path[++i] == 'n' ? '\n' : path[i];
+            } else {
+                out += path[i];
+            }
+        }
+        return out;
+    }
+
+    // Split off the next space-separated field
+    std::string_view next_field(std::string_view& line) {
+        size_t space = line.find(' ');
+        auto field = line.substr(0, space);
+        line.remove_prefix(space == std::string_view::npos ? line.size() : space + 1);
+        return field;
+    }
+
+    bool parse_hex(std::string_view text, uint64_t& value) {
+        if (text.size() != 16) {
+            return false;
+        }
+        value = 0;
+        for (char c : text) {
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= static_cast<uint64_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                value |= static_cast<uint64_t>(c - 'a' + 10);
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool parse_size(std::string_view text, size_t& value) {
+        if (text.empty()) {
+            return false;
+        }
+        value = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            value = value * 10 + static_cast<size_t>(c - '0');
+        }
+        return true;
+    }
+}
+
+// Manifest implementation
+Manifest Manifest::from_plan(const GenerationPlan& plan) {
+    Manifest manifest;
+    if (plan.size() < 2) {
+        return manifest;
+    }
+    manifest.entries_.reserve(plan.size() - 1);
+
+    // Parents come first, so each path extends one already built
+    for (size_t i = 1; i < plan.size(); ++i) {
+        const auto& node = plan[i];
+
+        ManifestEntry entry;
+        if (node.parent != 0) {
+            entry.path = manifest.entries_[node.parent - 1].path;
+            entry.path += '/';
+        }
+        entry.path += *node.name;
+        entry.is_directory = node.is_directory;
+        if (!entry.is_directory) {
+            entry.hash = Hash::fnv1a(node.content);
+            entry.size = node.content.size();
+        }
+        manifest.entries_.push_back(std::move(entry));
+    }
+
+    return manifest;
+}
+
+Manifest Manifest::from_tree(const Node& root) {
+    return from_plan(GenerationPlan::compile(root));
+}
+
+Result<Manifest> Manifest::parse(std::string_view text) {
+    Manifest manifest;
+    size_t line_number = 0;
+
+    while (!text.empty()) {
+        size_t newline = text.find('\n');
+        auto line = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+        line_number++;
+
+        if (line_number == 1) {
+            if (line != kHeader) {
+                return Error(ErrorCode::InvalidInput, "Not a yaqeen manifest");
+            }
+            continue;
+        }
+        if (line.empty()) {
+            continue;
+        }
+
+        ManifestEntry entry;
+        auto type = next_field(line);
+        bool valid = type == "d" || type == "f";
+        entry.is_directory = type == "d";
+        if (valid && !entry.is_directory) {
+            valid = parse_hex(next_field(line), entry.hash) && parse_size(next_field(line), entry.size);
+        }
+        if (!valid || line.empty()) {
+            return Error(ErrorCode::InvalidInput,
+                        "Malformed manifest line " + std::to_string(line_number));
+        }
+
+        entry.path = unescape(line);
+        manifest.entries_.push_back(std::move(entry));
+    }
+
+    return manifest;
+}
+
+Result<Manifest> Manifest::load(const std::filesystem::path& file) {
+    auto mapped = MappedFile::open(file);
+    if (mapped.is_error()) {
+        if (mapped.error().code == ErrorCode::FileNotFound) {
+            return Error(ErrorCode::FileNotFound, "Manifest not found: " + file.string());
+        }
+        return mapped.error();
+    }
+    return parse(mapped.value().view());
+}
+
+std::string Manifest::serialize() const {
+    std::string out;
+    out.reserve(kHeader.size() + 1 + entries_.size() * 48);
+    out += kHeader;
+    out += '\n';
+
+    for (const auto& entry : entries_) {
+        if (entry.is_directory) {
+            out += "d ";
+        } else {
+            out += "f ";
+            out += Hash::to_hex(entry.hash);
+            out += ' ';
+            out += std::to_string(entry.size);
+            out += ' ';
+        }
+        append_escaped(out, entry.path);
+        out += '\n';
+    }
+
+    return out;
+}
+
+Result<void> Manifest::save(const std::filesystem::path& file) const {
+    auto written = write_file_atomically(file, serialize(), true);
+    if (written.is_error()) {
+        return written.error();
+    }
+    return Result<void>();
+}
+
+// ManifestDiff implementation
+ManifestDiff ManifestDiff::compute(const Manifest& previous, const Manifest& next) {
+    ManifestDiff diff;
+
+    std::unordered_map<std::string_view, size_t> old_index;
+    old_index.reserve(previous.entries().size());
+    for (size_t i = 0; i < previous.entries().size(); ++i) {
+        old_index.emplace(previous.entries()[i].path, i);
+    }
+
+    std::vector<bool> kept(previous.entries().size(), false);
+    for (size_t i = 0; i < next.entries().size(); ++i) {
+        const auto& entry = next.entries()[i];
+        auto it = old_index.find(entry.path);
+        if (it == old_index.end()) {
+            diff.added.push_back(i);
+            continue;
+        }
+
+        const auto& old = previous.entries()[it->second];
+        if (old.is_directory != entry.is_directory) {
+            diff.added.push_back(i);
+            continue;
+        }
+
+        kept[it->second] = true;
+        if (entry.is_directory) {
+            continue;
+        }
+        if (old.hash != entry.hash || old.size != entry.size) {
+            diff.changed.push_back(i);
+        } else {
+            diff.unchanged_files++;
+        }
+    }
+
+    // Reverse plan order visits children before their parents
+    for (size_t i = previous.entries().size(); i-- > 0;) {
+        if (!kept[i]) {
+            diff.removed.push_back(i);
+        }
+    }
+
+    return diff;
+}
+
+} // namespace yaqeen::core
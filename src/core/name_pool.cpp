@@ -0,0 +1,63 @@
+#include "yaqeen/core/name_pool.hpp"
+#include "yaqeen/utils/hash.hpp"
+#include <algorithm>
+
+namespace yaqeen::core {
+
+uint32_t NamePool::hash_of(std::string_view name) {
+    uint64_t hash = Hash::fnv1a(name);
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+NameId NamePool::find(std::string_view name, uint32_t hash) const {
+    if (slots_.empty()) {
+        return kNone;
+    }
+    size_t mask = slots_.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        NameId id = slots_[i];
+        if (id == kNone) {
+            return kNone;
+        }
+        if (hashes_[id] == hash && strings_[id] == name) {
+            return id;
+        }
+    }
+}
+
+NameId NamePool::find(std::string_view name) const {
+    return find(name, hash_of(name));
+}
+
+void NamePool::insert(NameId id, uint32_t hash) {
+    size_t mask = slots_.size() - 1;
+    size_t i = hash & mask;
+    while (slots_[i] != kNone) {
+        i = (i + 1) & mask;
+    }
+    slots_[i] = id;
+}
+
+NameId NamePool::intern(std::string_view name) {
+    uint32_t hash = hash_of(name);
+    NameId id = find(name, hash);
+    if (id != kNone) {
+        return id;
+    }
+
+    // Linear probing stays short below half full
+    id = static_cast<NameId>(strings_.size());
+    if ((strings_.size() + 1) * 2 > slots_.size()) {
+        slots_.assign(std::max<size_t>(256, slots_.size() * 2), kNone);
+        for (NameId existing = 0; existing < id; ++existing) {
+            insert(existing, hashes_[existing]);
+        }
+    }
+
+    strings_.emplace_back(name);
+    hashes_.push_back(hash);
+    insert(id, hash);
+    return id;
+}
+
+} // namespace yaqeen::core
@@ -0,0 +1,263 @@
+#include "yaqeen/core/node_store.hpp"
+#include "yaqeen/core/parser.hpp"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace yaqeen::core {
+
+NodeStore::NodeStore(std::shared_ptr<NamePool> names)
+    : names_(names ? std::move(names) : std::make_shared<NamePool>()),
+      arena_(std::make_unique<std::pmr::monotonic_buffer_resource>()) {
+}
+
+NodeStore::NodeStore(NodeStore&& other) noexcept
+    : blocks_(std::move(other.blocks_)),
+      size_(std::exchange(other.size_, 0)),
+      indexes_(std::move(other.indexes_)),
+      names_(std::move(other.names_)),
+      arena_(std::move(other.arena_)),
+      source_(std::move(other.source_)) {
+}
+
+NodeStore& NodeStore::operator=(NodeStore&& other) noexcept {
+    blocks_ = std::move(other.blocks_);
+    size_ = std::exchange(other.size_, 0);
+    indexes_ = std::move(other.indexes_);
+    names_ = std::move(other.names_);
+    arena_ = std::move(other.arena_);
+    source_ = std::move(other.source_);
+    return *this;
+}
+
+NodeStore::~NodeStore() = default;
+
+NodeId NodeStore::append(NodeId parent, NameId name, bool is_directory) {
+    auto id = static_cast<NodeId>(size_);
+    if ((id & kBlockMask) == 0) {
+        blocks_.push_back(std::make_unique<Record[]>(size_t(1) << kBlockBits));
+    }
+    size_++;
+
+    Record& added = record(id);
+    added.parent = parent;
+    added.name = name;
+    added.is_directory = is_directory;
+    return id;
+}
+
+NodeId NodeStore::add_root(std::string_view name, bool is_directory) {
+    return append(kNone, names_->intern(name), is_directory);
+}
+
+NodeId NodeStore::add_child(NodeId parent, std::string_view name, bool is_directory) {
+    return link_child(parent, names_->intern(name), is_directory);
+}
+
+NodeId NodeStore::link_child(NodeId parent, NameId name, bool is_directory) {
+    NodeId id = append(parent, name, is_directory);
+    Record& dir = record(parent);
+    if (dir.last_child == kNone) {
+        dir.first_child = id;
+    } else {
+        record(dir.last_child).next_sibling = id;
+    }
+    dir.last_child = id;
+    dir.child_count++;
+
+    if (dir.index != kNone) {
+        insert_indexed(indexes_[dir.index], name, id);
+    }
+    return id;
+}
+
+NodeStore::Placement NodeStore::place_child(NodeId parent, std::string_view name, bool is_directory) {
+    if (record(parent).index == kNone && record(parent).child_count > kIndexThreshold) {
+        index_children(parent);
+    }
+
+    NameId interned = names_->intern(name);
+    NodeId existing = find_child(parent, interned);
+    if (existing == kNone) {
+        return Placement{link_child(parent, interned, is_directory), Placement::Added};
+    }
+    if (is_directory && record(existing).is_directory) {
+        return Placement{existing, Placement::Merged};
+    }
+    return Placement{existing, Placement::Conflict};
+}
+
+Error NodeStore::conflict(const Placement& placed, bool is_directory, ErrorCode code) const {
+    if (!is_directory && is_file(placed.id)) {
+        return Error(code, "File listed more than once", path(placed.id));
+    }
+    return Error(code, "Name used for both a file and a directory", path(placed.id));
+}
+
+void NodeStore::index_children(NodeId parent) {
+    record(parent).index = static_cast<uint32_t>(indexes_.size());
+    ChildIndex& index = indexes_.emplace_back();
+    for (NodeId child = record(parent).first_child; child != kNone; child = record(child).next_sibling) {
+        insert_indexed(index, record(child).name, child);
+    }
+}
+
+void NodeStore::insert_indexed(ChildIndex& index, NameId name, NodeId node) {
+    // Linear probing stays short below half full
+    if ((index.used + 1) * 2 > index.slots.size()) {
+        std::vector<ChildIndex::Slot> old(std::max<size_t>(4 * kIndexThreshold, index.slots.size() * 2));
+        old.swap(index.slots);
+        index.used = 0;
+        for (const auto& slot : old) {
+            if (slot.node != kNone) {
+                insert_indexed(index, slot.name, slot.node);
+            }
+        }
+    }
+
+    size_t mask = index.slots.size() - 1;
+    size_t i = names_->hash(name) & mask;
+    while (index.slots[i].node != kNone) {
+        i = (i + 1) & mask;
+    }
+    index.slots[i] = ChildIndex::Slot{name, node};
+    index.used++;
+}
+
+void NodeStore::set_content(NodeId id, std::string_view content) {
+    Record& target = record(id);
+    target.content_size = content.size();
+    if (content.empty()) {
+        target.content = nullptr;
+        return;
+    }
+    if (!arena_) {
+        arena_ = std::make_unique<std::pmr::monotonic_buffer_resource>();
+    }
+    auto copy = static_cast<char*>(arena_->allocate(content.size(), 1));
+    std::memcpy(copy, content.data(), content.size());
+    target.content = copy;
+}
+
+void NodeStore::set_source_content(NodeId id, std::string_view content) {
+    record(id).content = content.data();
+    record(id).content_size = content.size();
+}
+
+NodeId NodeStore::find_child(NodeId parent, std::string_view name) const {
+    // A name the pool has never seen is nobody's child
+    NameId interned = names_->find(name);
+    return interned == NamePool::kNone ? kNone : find_child(parent, interned);
+}
+
+NodeId NodeStore::find_child(NodeId parent, NameId name) const {
+    if (record(parent).index != kNone) {
+        const ChildIndex& index = indexes_[record(parent).index];
+        size_t mask = index.slots.size() - 1;
+        for (size_t i = names_->hash(name) & mask;; i = (i + 1) & mask) {
+            const auto& slot = index.slots[i];
+            if (slot.node == kNone || slot.name == name) {
+                return slot.node;
+            }
+        }
+    }
+
+    for (NodeId child = record(parent).first_child; child != kNone; child = record(child).next_sibling) {
+        if (record(child).name == name) {
+            return child;
+        }
+    }
+    return kNone;
+}
+
+std::string NodeStore::path(NodeId id) const {
+    std::vector<NodeId> chain;
+    for (NodeId node = id; node != kNone && node != root(); node = record(node).parent) {
+        chain.push_back(node);
+    }
+
+    std::string joined;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (!joined.empty()) {
+            joined += '/';
+        }
+        joined += name(*it);
+    }
+    return joined;
+}
+
+NodeStore NodeStore::from_node(const Node& root, std::shared_ptr<NamePool> names) {
+    NodeStore store(std::move(names));
+    store.source_ = root.source;
+    std::string_view source = root.source ? root.source->view() : std::string_view();
+
+    auto copy_content = [&](const Node& node, NodeId id) {
+        if (node.is_directory()) {
+            return;
+        }
+        if (node.content) {
+            store.set_content(id, *node.content);
+        } else if (node.content_span.length != 0 && node.content_span.offset < source.size()) {
+            store.set_source_content(id, source.substr(node.content_span.offset, node.content_span.length));
+        }
+    };
+
+    copy_content(root, store.add_root(root.name, root.is_directory()));
+
+    std::vector<std::pair<const Node*, NodeId>> pending{{&root, 0}};
+    while (!pending.empty()) {
+        auto [node, id] = pending.back();
+        pending.pop_back();
+
+        for (const auto& child : node->children) {
+            NodeId child_id = store.add_child(id, child->name, child->is_directory());
+            copy_content(*child, child_id);
+            if (!child->children.empty()) {
+                pending.emplace_back(child.get(), child_id);
+            }
+        }
+    }
+
+    return store;
+}
+
+std::unique_ptr<Node> NodeStore::to_node() const {
+    if (size_ == 0) {
+        return nullptr;
+    }
+
+    std::string_view source = source_ ? source_->view() : std::string_view();
+    auto make = [&](NodeId id) {
+        const Record& from = record(id);
+        auto node = std::make_unique<Node>(from.is_directory ? Node::Type::Directory : Node::Type::File, name(id));
+        if (from.content_size != 0) {
+            if (!source.empty() && from.content >= source.data() && from.content < source.data() + source.size()) {
+                node->content_span = ContentSpan{static_cast<size_t>(from.content - source.data()), from.content_size};
+            } else {
+                node->content = std::string(from.content, from.content_size);
+            }
+        }
+        return node;
+    };
+
+    auto root = make(0);
+    root->source = source_;
+
+    std::vector<std::pair<NodeId, Node*>> pending{{0, root.get()}};
+    while (!pending.empty()) {
+        auto [id, node] = pending.back();
+        pending.pop_back();
+
+        node->children.reserve(record(id).child_count);
+        for (NodeId child = record(id).first_child; child != kNone; child = record(child).next_sibling) {
+            node->add_child(make(child));
+            if (record(child).first_child != kNone) {
+                pending.emplace_back(child, node->children.back().get());
+            }
+        }
+    }
+
+    return root;
+}
+
+} // namespace yaqeen::core
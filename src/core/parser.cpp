@@ -1,15 +1,38 @@
 #include "yaqeen/core/parser.hpp"
-#include "yaqeen/utils/validators.hpp"
+#include "yaqeen/core/glyph_scan.hpp"
+#include "yaqeen/core/tree_walk.hpp"
+#include "yaqeen/utils/mapped_file.hpp"
 #include "yaqeen/utils/logger.hpp"
-#include <fstream>
-#include <sstream>
+#include <md4c.h>
 #include <algorithm>
-#include <stack>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
+#include <limits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
 
 namespace yaqeen::core {
 
 // Node implementation
+Node::~Node() {
+    // Detach descendants onto a list first, so that a deep tree is not
+    // freed by one nested destructor call per level
+    std::vector<std::unique_ptr<Node>> pending = std::move(children);
+    while (!pending.empty()) {
+        std::unique_ptr<Node> node = std::move(pending.back());
+        pending.pop_back();
+        for (auto& child : node->children) {
+            pending.push_back(std::move(child));
+        }
+        node->children.clear();
+    }
+}
+
 void Node::add_child(std::unique_ptr<Node> child) {
     children.push_back(std::move(child));
 }
@@ -32,252 +55,753 @@ const Node* Node::find_child(const std::string& name) const {
 
 std::string Node::to_string(int indent) const {
     std::string result;
-    std::string prefix(indent * 2, ' ');
-    result += prefix + name;
-    if (is_directory()) {
-        result += "/";
-    }
-    result += "\n";
-
-    for (const auto& child : children) {
-        result += child->to_string(indent + 1);
-    }
-
+    walk_tree(NodeTree{}, this, [&](const Node* node, size_t depth) {
+        result.append((indent + depth) * 2, ' ');
+        result += node->name;
+        if (node->is_directory()) {
+            result += "/";
+        }
+        result += "\n";
+        return WalkAction::Continue;
+    });
     return result;
 }
 
 // MarkdownParser implementation
-struct MarkdownParser::Impl {
-    // Implementation details
-};
+namespace {
 
-MarkdownParser::MarkdownParser() : impl_(std::make_unique<Impl>()) {
+// Fenced blocks that may hold a tree: untagged, tagged `tree`, or plain text
+bool is_tree_language(std::string_view lang) {
+    return lang.empty() || lang == "tree" || lang == "text" || lang == "txt" || lang == "plaintext";
 }
 
-MarkdownParser::~MarkdownParser() = default;
+std::string_view trim_blanks(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
 
-Result<std::unique_ptr<Node>> MarkdownParser::parse(const std::filesystem::path& md_file) {
-    // Validate file exists and is readable
-    auto validation = Validator::validate_file_readable(md_file);
-    if (validation.is_error()) {
-        return validation.error();
+// The path of a `file=<path>` word in an info string, quotes removed
+std::optional<std::string_view> file_attribute(std::string_view info) {
+    while (!info.empty()) {
+        size_t end = info.find_first_of(" \t");
+        auto word = info.substr(0, end);
+        if (word.substr(0, 5) == "file=") {
+            auto path = word.substr(5);
+            if (path.size() >= 2 && path.front() == '"' && path.back() == '"') {
+                path = path.substr(1, path.size() - 2);
+            }
+            return path;
+        }
+        info = end == std::string_view::npos ? std::string_view() : trim_blanks(info.substr(end));
+    }
+    return std::nullopt;
+}
+
+bool is_tree_block(std::string_view info) {
+    return !file_attribute(info) && is_tree_language(info.substr(0, info.find_first_of(" \t")));
+}
+
+// An opening code fence, following CommonMark outside containers: up to
+// three spaces of indent and a run of three or more '`' or '~'
+struct Fence {
+    char marker = 0;
+    size_t indent = 0;
+    size_t length = 0;
+    std::string_view info;
+};
+
+std::optional<Fence> opening_fence(std::string_view line) {
+    Fence fence;
+    while (fence.indent < 4 && fence.indent < line.size() && line[fence.indent] == ' ') {
+        ++fence.indent;
+    }
+    if (fence.indent == 4 || fence.indent == line.size() ||
+        (line[fence.indent] != '`' && line[fence.indent] != '~')) {
+        return std::nullopt;
     }
 
-    // Read file content
-    std::ifstream file(md_file);
-    if (!file) {
-        return Error(ErrorCode::FileNotFound, "Cannot open markdown file: " + md_file.string());
+    fence.marker = line[fence.indent];
+    while (fence.indent + fence.length < line.size() && line[fence.indent + fence.length] == fence.marker) {
+        ++fence.length;
     }
+    fence.info = trim_blanks(line.substr(fence.indent + fence.length));
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string content = buffer.str();
+    // A backtick in the info string makes this inline code
+    if (fence.length < 3 || (fence.marker == '`' && fence.info.find('`') != std::string_view::npos)) {
+        return std::nullopt;
+    }
+    return fence;
+}
 
-    return parse_string(content);
+// A run of the same character at least as long, with nothing after it
+bool closes_fence(std::string_view line, const Fence& fence) {
+    auto closing = opening_fence(line);
+    return closing && closing->marker == fence.marker && closing->length >= fence.length && closing->info.empty();
 }
 
-Result<std::unique_ptr<Node>> MarkdownParser::parse_string(const std::string& markdown) {
-    LOG_DEBUG("Parsing markdown structure");
+// Recognizes fenced blocks line by line, for input that cannot be handed to
+// md4c whole
+class FenceTracker {
+public:
+    // True when line is inside a tree block; the opening fence's indent is
+    // stripped from it, as CommonMark does
+    bool content(std::string_view& line) {
+        if (!open_) {
+            if (auto fence = opening_fence(line)) {
+                open_ = true;
+                fence_ = *fence;
+                selected_ = is_tree_block(fence->info);
+                file_block_ = file_block_ || file_attribute(fence->info).has_value();
+            }
+            return false;
+        }
+        if (closes_fence(line, fence_)) {
+            open_ = false;
+            return false;
+        }
+        if (!selected_) {
+            return false;
+        }
 
-    // Extract tree structure from markdown
-    return parse_tree_structure(markdown);
-}
+        size_t strip = 0;
+        while (strip < fence_.indent && strip < line.size() && line[strip] == ' ') {
+            ++strip;
+        }
+        line.remove_prefix(strip);
+        return true;
+    }
 
-Result<std::unique_ptr<Node>> MarkdownParser::parse_tree_structure(const std::string& content) {
-    // Split into lines
-    std::vector<std::string> lines;
-    std::istringstream stream(content);
-    std::string line;
+    // Whether a `file=` block has been opened
+    bool saw_file_block() const { return file_block_; }
 
-    bool in_code_block = false;
-    std::vector<std::string> tree_lines;
+private:
+    Fence fence_;
+    bool open_ = false;
+    bool selected_ = false;
+    bool file_block_ = false;
+};
 
-    while (std::getline(stream, line)) {
-        // Check for code block markers
-        if (line.find("```") != std::string::npos) {
-            in_code_block = !in_code_block;
-            continue;
+// A `file=` block found by the md4c front end
+struct FileBlock {
+    std::string path;
+    ContentSpan span;
+};
+
+// Points each block's file at its span of the store's source; the path
+// runs from the top of the tree, '/'-separated
+Result<void> attach_file_blocks(NodeStore& store, const std::vector<FileBlock>& blocks) {
+    std::string_view source = store.source()->view();
+    for (const auto& block : blocks) {
+        NodeId node = store.root();
+        std::string_view rest = block.path;
+        while (node != NodeStore::kNone && !rest.empty()) {
+            size_t slash = rest.find('/');
+            auto part = rest.substr(0, slash);
+            rest = slash == std::string_view::npos ? std::string_view() : rest.substr(slash + 1);
+            if (!part.empty() && part != ".") {
+                node = store.find_child(node, part);
+            }
         }
 
-        // Collect lines that look like tree structure
-        if (in_code_block || is_tree_line(line)) {
-            tree_lines.push_back(line);
+        if (node == NodeStore::kNone || node == store.root()) {
+            return Error(ErrorCode::InvalidMarkdownFormat, "Content block does not match a file in the tree", block.path);
+        }
+        if (store.is_directory(node)) {
+            return Error(ErrorCode::InvalidMarkdownFormat, "Content block targets a directory", block.path);
+        }
+        if (!store.content(node).empty()) {
+            return Error(ErrorCode::InvalidMarkdownFormat, "More than one content block for a file", block.path);
         }
+        store.set_source_content(node, source.substr(block.span.offset, block.span.length));
     }
+    return Result<void>();
+}
 
-    if (tree_lines.empty()) {
-        return Error(ErrorCode::InvalidMarkdownFormat, "No tree structure found in markdown");
+} // namespace
+
+// Front end over md4c's SAX callbacks. md4c skips prose, headings and lists
+// itself; only the lines of tree blocks come back, each as indentation (in
+// columns, from md4c's own buffer) followed by a view into the document.
+// `file=` blocks are only located, as spans of the document.
+struct MarkdownParser::Impl {
+    std::shared_ptr<NamePool> names;  // null: every tree gets its own pool
+    std::string scratch;  // a line md4c delivered in more than one piece
+    std::vector<FileBlock> file_blocks;
+    std::optional<Error> failure;  // why a walk was aborted
+
+    // Calls on_line(line, readable, leading_columns) for every line of every
+    // tree block, in document order, and collects file_blocks. Returns
+    // md4c's status, 0 on success.
+    template <typename OnLine>
+    int for_each_tree_line(std::string_view content, OnLine& on_line);
+
+    // Records the body of the `file=` block whose info string md4c reports
+    // at info, which must point into content; false sets failure
+    bool add_file_block(std::string_view content, const MD_ATTRIBUTE& info, char marker);
+};
+
+bool MarkdownParser::Impl::add_file_block(std::string_view content, const MD_ATTRIBUTE& info, char marker) {
+    std::string_view info_text(info.text, info.size);
+    std::string path(file_attribute(info_text).value_or(std::string_view()));
+
+    // md4c copies info strings with escapes out of the document, and then
+    // the fence cannot be found from them
+    const char* begin = content.data();
+    const char* end = content.data() + content.size();
+    if (info.text < begin || info.text >= end) {
+        failure = Error(ErrorCode::InvalidMarkdownFormat, "Content block info string cannot contain escapes", path);
+        return false;
+    }
+    if (path.empty()) {
+        failure = Error(ErrorCode::InvalidMarkdownFormat, "Content block has an empty file= path");
+        return false;
     }
 
-    return parse_tree_lines(tree_lines);
+    // The body is copied byte for byte, so the fence must not be indented
+    // or inside a list or block quote
+    auto info_offset = static_cast<size_t>(info.text - begin);
+    size_t line_start = content.rfind('\n', info_offset);
+    line_start = line_start == std::string_view::npos ? 0 : line_start + 1;
+    auto fence = opening_fence(content.substr(line_start, info_offset - line_start + info.size));
+    if (!fence || fence->indent != 0 || fence->marker != marker) {
+        failure = Error(ErrorCode::InvalidMarkdownFormat, "Content block fence must start its line", path);
+        return false;
+    }
+
+    auto newline = static_cast<const char*>(std::memchr(info.text, '\n', static_cast<size_t>(end - info.text)));
+    const char* body = newline ? newline + 1 : end;
+    const char* cursor = body;
+    const char* body_end = end;
+    while (cursor < end) {
+        newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+        const char* line_end = newline ? newline : end;
+        if (closes_fence(std::string_view(cursor, static_cast<size_t>(line_end - cursor)), *fence)) {
+            body_end = cursor;
+            break;
+        }
+        cursor = newline ? newline + 1 : end;
+    }
+
+    file_blocks.push_back({std::move(path), ContentSpan{static_cast<size_t>(body - begin), static_cast<size_t>(body_end - body)}});
+    return true;
 }
 
-std::unique_ptr<Node> MarkdownParser::parse_tree_lines(const std::vector<std::string>& lines) {
-    auto root = std::make_unique<Node>(Node::Type::Directory, "root");
-    std::stack<std::pair<int, Node*>> node_stack;
-    node_stack.push({-1, root.get()});
+namespace {
+
+// Owner is MarkdownParser::Impl, which keeps the state that outlives a line
+template <typename Owner, typename OnLine>
+struct TreeBlockWalk {
+    Owner& impl;
+    OnLine& on_line;
+    std::string_view content;
+
+    bool in_block = false;
+    size_t leading = 0;        // columns of indentation md4c reported
+    const char* piece = nullptr;
+    size_t piece_size = 0;
+    bool assembled = false;    // the line lives in impl.scratch, not the document
+
+    bool in_document(const char* text) const {
+        return text >= content.data() && text < content.data() + content.size();
+    }
 
-    for (const auto& line : lines) {
-        if (line.empty() || line.find_first_not_of(" \t\r\n") == std::string::npos) {
-            continue;
+    static int enter_block(MD_BLOCKTYPE type, void* detail, void* userdata) {
+        auto& walk = *static_cast<TreeBlockWalk*>(userdata);
+        if (type != MD_BLOCK_CODE) {
+            return 0;
         }
 
-        auto line_info = parse_line(line);
-        if (!line_info.has_value()) {
-            continue;
+        auto& code = *static_cast<const MD_BLOCK_CODE_DETAIL*>(detail);
+        std::string_view info(code.info.text, code.info.text ? code.info.size : 0);
+        if (code.fence_char == 0) {
+            walk.in_block = false;
+        } else if (file_attribute(info)) {
+            walk.in_block = false;
+            if (!walk.impl.add_file_block(walk.content, code.info, code.fence_char)) {
+                return 1;
+            }
+        } else {
+            walk.in_block = is_tree_block(info);
         }
+        return 0;
+    }
 
-        // Pop nodes from stack until we find the parent
-        while (!node_stack.empty() && node_stack.top().first >= line_info->indent_level) {
-            node_stack.pop();
+    static int leave_block(MD_BLOCKTYPE type, void*, void* userdata) {
+        if (type == MD_BLOCK_CODE) {
+            static_cast<TreeBlockWalk*>(userdata)->in_block = false;
         }
+        return 0;
+    }
+
+    static int span(MD_SPANTYPE, void*, void*) {
+        return 0;
+    }
 
-        if (node_stack.empty()) {
-            LOG_WARN("Invalid tree structure: no parent found");
-            continue;
+    static int text(MD_TEXTTYPE type, const MD_CHAR* text, MD_SIZE size, void* userdata) {
+        auto& walk = *static_cast<TreeBlockWalk*>(userdata);
+        if (!walk.in_block) {
+            return 0;
         }
 
-        Node* parent = node_stack.top().second;
+        // Code lines never contain a newline, so a lone one ends the line
+        if (size == 1 && text[0] == '\n') {
+            walk.finish_line();
+        } else if (type == MD_TEXT_NULLCHAR) {
+            walk.append("\xEF\xBF\xBD", 3);
+        } else if (!walk.piece && !walk.assembled && !walk.in_document(text)) {
+            walk.leading += size;
+        } else {
+            walk.append(text, size);
+        }
+        return 0;
+    }
 
-        // Create new node
-        auto node_type = line_info->is_directory ? Node::Type::Directory : Node::Type::File;
-        auto new_node = std::make_unique<Node>(node_type, line_info->name);
-        Node* new_node_ptr = new_node.get();
+    void append(const char* text, size_t size) {
+        if (!assembled) {
+            if (!piece && in_document(text)) {
+                piece = text;
+                piece_size = size;
+                return;
+            }
+            if (piece && piece + piece_size == text) {
+                piece_size += size;
+                return;
+            }
+            impl.scratch.assign(piece ? piece : "", piece_size);
+            assembled = true;
+        }
+        impl.scratch.append(text, size);
+    }
 
-        parent->add_child(std::move(new_node));
-        node_stack.push({line_info->indent_level, new_node_ptr});
+    void finish_line() {
+        if (assembled) {
+            on_line(std::string_view(impl.scratch), impl.scratch.size(), leading);
+        } else if (piece) {
+            on_line(std::string_view(piece, piece_size), static_cast<size_t>(content.data() + content.size() - piece), leading);
+        } else {
+            on_line(std::string_view(), 0, leading);
+        }
+        leading = 0;
+        piece = nullptr;
+        piece_size = 0;
+        assembled = false;
     }
+};
+
+} // namespace
+
+template <typename OnLine>
+int MarkdownParser::Impl::for_each_tree_line(std::string_view content, OnLine& on_line) {
+    using Walk = TreeBlockWalk<Impl, OnLine>;
+    Walk walk{*this, on_line, content};
 
-    return root;
+    MD_PARSER parser{};
+    parser.abi_version = 0;
+    parser.flags = MD_DIALECT_COMMONMARK;
+    parser.enter_block = &Walk::enter_block;
+    parser.leave_block = &Walk::leave_block;
+    parser.enter_span = &Walk::span;
+    parser.leave_span = &Walk::span;
+    parser.text = &Walk::text;
+
+    return md_parse(content.data(), static_cast<MD_SIZE>(content.size()), &parser, &walk);
 }
 
-std::optional<MarkdownParser::LineInfo> MarkdownParser::parse_line(const std::string& line) {
-    int indent = calculate_indent(line);
+MarkdownParser::MarkdownParser(std::shared_ptr<NamePool> names) : impl_(std::make_unique<Impl>()) {
+    impl_->names = std::move(names);
+}
 
-    bool is_directory = false;
-    std::string name = extract_name(line, is_directory);
+MarkdownParser::~MarkdownParser() = default;
 
-    if (name.empty()) {
-        return std::nullopt;
+Result<std::unique_ptr<Node>> MarkdownParser::parse(const std::filesystem::path& md_file) {
+    auto store = parse_store(md_file);
+    if (store.is_error()) {
+        return store.error();
     }
+    return store.value().to_node();
+}
 
-    LineInfo info;
-    info.indent_level = indent;
-    info.name = name;
-    info.is_directory = is_directory;
-
-    return info;
+Result<std::unique_ptr<Node>> MarkdownParser::parse_string(std::string_view markdown) {
+    auto store = parse_string_store(markdown);
+    if (store.is_error()) {
+        return store.error();
+    }
+    return store.value().to_node();
 }
 
-int MarkdownParser::calculate_indent(const std::string& line) {
-    // Count leading spaces, considering tree characters
-    int indent = 0;
-    for (char c : line) {
-        if (c == ' ' || c == '\t' || c == '|' || c == '├' || c == '└' ||
-            c == '─' || c == '│' || c == '/' || c == '\\') {
-            indent++;
-        } else {
-            break;
-        }
+Result<NodeStore> MarkdownParser::parse_store(const std::filesystem::path& md_file) {
+    // One open both checks the file and maps it; nodes copy their names
+    // out, and a tree with file contents keeps the mapping
+    auto file = MappedFile::open(md_file);
+    if (file.is_error()) {
+        return file.error();
     }
-    return indent / 4; // Convert to indent level
+
+    LOG_DEBUG("Parsing markdown structure");
+    auto source = std::make_shared<const MappedFile>(std::move(file.value()));
+    auto content = source->view();
+    return parse_tree_structure(content, std::move(source));
+}
+
+Result<NodeStore> MarkdownParser::parse_string_store(std::string_view markdown) {
+    LOG_DEBUG("Parsing markdown structure");
+
+    // Extract tree structure from markdown
+    return parse_tree_structure(markdown, nullptr);
 }
 
-bool MarkdownParser::is_tree_line(const std::string& line) {
-    // Check if line contains tree-like characters or proper indentation
-    if (line.empty()) return false;
-
-    // Look for common tree characters
-    return line.find("├") != std::string::npos ||
-           line.find("└") != std::string::npos ||
-           line.find("│") != std::string::npos ||
-           line.find("─") != std::string::npos ||
-           line.find("/") != std::string::npos ||
-           (line.find_first_not_of(" \t") != std::string::npos &&
-            (line.find(".") != std::string::npos || line.find("/") != std::string::npos));
+size_t MarkdownParser::TreeCursor::place(const LineInfo& info) {
+    if (info.name.empty()) {
+        return 0;
+    }
+
+    // Close entries until we find the parent
+    while (!indents.empty() && indents.back() >= info.indent_level) {
+        indents.pop_back();
+    }
+    indents.push_back(info.indent_level);
+    return indents.size();
 }
 
-std::string MarkdownParser::extract_name(const std::string& line, bool& is_directory) {
-    // Remove tree characters and extract name
-    std::string cleaned = line;
+Result<NodeStore> MarkdownParser::parse_tree_structure(
+    std::string_view content,
+    std::shared_ptr<const MappedFile> source
+) {
+    if (content.size() > std::numeric_limits<MD_SIZE>::max()) {
+        return Error(ErrorCode::ParsingFailed, "Markdown input too large",
+            std::to_string(content.size()) + " bytes");
+    }
+
+    NodeStore store(impl_->names);
+    store.add_root("root");
+
+    // Open nodes by depth; the root sits above every entry
+    std::vector<NodeId> open{store.root()};
+    TreeCursor placement;
+    bool found_tree = false;
+    std::optional<Error> duplicate;
+
+    // A directory listed again is the same directory; a file listed again
+    // is an error, reported once the walk is over
+    auto on_line = [&](std::string_view line, size_t readable, size_t leading_columns) {
+        auto info = scan_line(line, readable, leading_columns);
+        size_t depth = placement.place(info);
+        if (depth == 0 || duplicate) {
+            return;
+        }
+        found_tree = true;
 
-    // Remove common tree drawing characters
-    const std::vector<std::string> tree_chars = {
-        "├──", "└──", "│", "├─", "└─", "├", "└", "─", "│  ", "|"
+        open.resize(depth);
+        auto placed = store.place_child(open.back(), info.name, info.is_directory);
+        if (placed.kind == NodeStore::Placement::Conflict) {
+            duplicate = store.conflict(placed, info.is_directory, ErrorCode::InvalidMarkdownFormat);
+        }
+        open.push_back(placed.id);
     };
 
-    for (const auto& tc : tree_chars) {
-        size_t pos;
-        while ((pos = cleaned.find(tc)) != std::string::npos) {
-            cleaned.replace(pos, tc.length(), " ");
+    impl_->file_blocks.clear();
+    impl_->failure.reset();
+    if (impl_->for_each_tree_line(content, on_line) != 0) {
+        if (impl_->failure) {
+            return *impl_->failure;
+        }
+        return Error(ErrorCode::ParsingFailed, "Failed to parse markdown");
+    }
+
+    if (!found_tree) {
+        return Error(ErrorCode::InvalidMarkdownFormat, "No tree structure found in markdown");
+    }
+    if (duplicate) {
+        return *duplicate;
+    }
+
+    if (!impl_->file_blocks.empty()) {
+        // Spans are offsets, so a copy of a borrowed document serves as well
+        store.set_source(source ? std::move(source)
+                                : std::make_shared<const MappedFile>(MappedFile::from_buffer(std::string(content))));
+
+        auto attached = attach_file_blocks(store, impl_->file_blocks);
+        if (attached.is_error()) {
+            return attached.error();
         }
     }
 
-    // Trim whitespace
-    auto start = cleaned.find_first_not_of(" \t");
-    auto end = cleaned.find_last_not_of(" \t\r\n");
+    return store;
+}
+
+Result<void> MarkdownParser::parse_stream(std::istream& in, const std::function<bool(StreamEntry&&)>& emit) {
+    LOG_DEBUG("Streaming markdown structure");
+
+    constexpr size_t kChunkSize = 64 * 1024;
+    FenceTracker fences;
+    TreeCursor placement;
+    bool found_tree = false;
+
+    // Unconsumed input: at most one chunk plus the start of a line
+    std::string buffer;
+    bool at_end = false;
+    while (!at_end) {
+        size_t kept = buffer.size();
+        buffer.resize(kept + kChunkSize);
+        in.read(&buffer[kept], static_cast<std::streamsize>(kChunkSize));
+        buffer.resize(kept + static_cast<size_t>(in.gcount()));
+        if (in.bad()) {
+            return Error(ErrorCode::ParsingFailed, "Failed to read markdown input");
+        }
+        at_end = !in;
+
+        const char* cursor = buffer.data();
+        const char* end = buffer.data() + buffer.size();
+        while (cursor < end) {
+            auto newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+            if (!newline && !at_end) {
+                break;
+            }
+            const char* line_end = newline ? newline : end;
+            std::string_view line(cursor, static_cast<size_t>(line_end - cursor));
+            cursor = newline ? newline + 1 : end;
+            if (!fences.content(line)) {
+                if (fences.saw_file_block()) {
+                    return Error(ErrorCode::InvalidMarkdownFormat,
+                        "Content blocks need the whole document; read the spec from a file");
+                }
+                continue;
+            }
+
+            auto info = scan_line(line, static_cast<size_t>(end - line.data()));
+            size_t depth = placement.place(info);
+            if (depth == 0) {
+                continue;
+            }
+            found_tree = true;
+
+            StreamEntry entry{static_cast<uint32_t>(depth), std::string(info.name), info.is_directory};
+            if (!emit(std::move(entry))) {
+                return Result<void>();
+            }
+        }
 
-    if (start == std::string::npos) {
-        return "";
+        buffer.erase(0, static_cast<size_t>(cursor - buffer.data()));
     }
 
-    std::string name = cleaned.substr(start, end - start + 1);
+    if (!found_tree) {
+        return Error(ErrorCode::InvalidMarkdownFormat, "No tree structure found in markdown");
+    }
 
-    // Check if it's a directory (ends with / or has trailing /)
-    if (!name.empty() && name.back() == '/') {
-        is_directory = true;
-        name.pop_back();
+    return Result<void>();
+}
+
+MarkdownParser::LineInfo MarkdownParser::scan_line(std::string_view line, size_t readable, size_t leading_columns) {
+    LineInfo info;
+
+    // Depth is the display width of the leading tree prefix, so "├── ",
+    // "|-- " and four spaces each add one level
+    auto line_class = classify_line(line, readable);
+    info.indent_level = static_cast<int>((leading_columns + line_class.prefix_columns) / 4);
+
+    auto name = line.substr(line_class.prefix_bytes, line_class.name_end - line_class.prefix_bytes);
+    if (name.empty()) {
+        return info;
+    }
+
+    // A trailing '/' marks a directory; otherwise anything without an
+    // extension is taken to be one
+    if (name.back() == '/') {
+        info.is_directory = true;
+        name.remove_suffix(1);
     } else {
-        // Check if it looks like a file (has extension)
-        is_directory = (name.find('.') == std::string::npos);
+        info.is_directory = !line_class.has_dot;
     }
+    info.name = name;
 
-    return name;
+    return info;
 }
 
 // TreeVisualizer implementation
-std::string TreeVisualizer::visualize(const Node& root, bool use_unicode) {
-    std::string output;
-    output += root.name;
-    if (root.is_directory()) {
-        output += "/";
+namespace {
+
+// Collects rendered lines. With an fd, holds at most kCapacity bytes and
+// writes them out whenever the next piece would not fit.
+class RenderOutput {
+public:
+    static constexpr size_t kCapacity = 64 * 1024;
+
+    RenderOutput() = default;
+    explicit RenderOutput(int fd) : fd_(fd) { buffer_.reserve(kCapacity); }
+
+    void append(std::string_view text) {
+        if (fd_ >= 0 && buffer_.size() + text.size() > kCapacity) {
+            flush();
+            if (text.size() > kCapacity) {
+                write_out(text);
+                return;
+            }
+        }
+        buffer_ += text;
+    }
+
+    void flush() {
+        write_out(buffer_);
+        buffer_.clear();
+    }
+
+    std::string& text() { return buffer_; }
+    int error() const { return error_; }
+
+private:
+    void write_out(std::string_view text) {
+        while (!text.empty() && error_ == 0) {
+#if defined(__unix__) || defined(__APPLE__)
+            ssize_t written = ::write(fd_, text.data(), text.size());
+#else
+            int written = ::_write(fd_, text.data(), static_cast<unsigned>(text.size()));
+#endif
+            if (written < 0) {
+                if (errno != EINTR) {
+                    error_ = errno;
+                }
+                continue;
+            }
+            text.remove_prefix(static_cast<size_t>(written));
+        }
     }
-    output += "\n";
 
-    for (size_t i = 0; i < root.children.size(); ++i) {
-        bool is_last = (i == root.children.size() - 1);
-        visualize_recursive(*root.children[i], output, "", is_last, use_unicode);
+    std::string buffer_;
+    int fd_ = -1;
+    int error_ = 0;
+};
+
+// One prefix buffer serves the whole walk: a directory pushes its extension
+// on entry and cuts it back on exit
+void render(const NodeStore& tree, const TreeVisualizer::Options& options, RenderOutput& out) {
+    if (tree.empty()) {
+        return;
     }
 
-    return output;
+    const bool unicode = options.use_unicode;
+    const size_t max_entries = options.max_entries_per_dir;
+    std::string prefix;
+    std::vector<size_t> marks;
+    std::string count;
+
+    // Children of node that the limits leave out
+    auto hidden = [&](NodeId node, size_t depth) -> size_t {
+        size_t children = tree.child_count(node);
+        if (options.max_depth != 0 && depth >= options.max_depth) {
+            return children;
+        }
+        return max_entries != 0 && children > max_entries ? children - max_entries : 0;
+    };
+    auto opens = [&tree](NodeId node, size_t depth) {
+        return depth != 0 && tree.first_child(node) != NodeStore::kNone;
+    };
+
+    // Children past max_entries are never reached
+    struct LimitedTree {
+        const NodeStore& store;
+        size_t limit;
+
+        using Node = NodeId;
+        struct Cursor {
+            NodeId next;
+            size_t left;
+        };
+
+        Cursor children(Node node) const { return Cursor{store.first_child(node), limit}; }
+
+        bool next(Cursor& cursor, Node& child) const {
+            if (cursor.next == NodeStore::kNone || cursor.left == 0) {
+                return false;
+            }
+            child = cursor.next;
+            cursor.next = store.next_sibling(cursor.next);
+            cursor.left--;
+            return true;
+        }
+    };
+    LimitedTree limited{tree, max_entries != 0 ? max_entries : std::numeric_limits<size_t>::max()};
+
+    walk_tree(limited, tree.root(),
+        [&](NodeId node, size_t depth) {
+            // An entry followed by elided siblings is not last: the
+            // "… N more" line is
+            bool is_last = tree.next_sibling(node) == NodeStore::kNone;
+            if (depth != 0) {
+                out.append(prefix);
+                out.append(unicode ? (is_last ? "└── " : "├── ") : (is_last ? "`-- " : "|-- "));
+            }
+            out.append(tree.name(node));
+            out.append(tree.is_directory(node) ? "/\n" : "\n");
+
+            if (opens(node, depth)) {
+                marks.push_back(prefix.size());
+                prefix += unicode ? (is_last ? "    " : "│   ") : (is_last ? "    " : "|   ");
+            }
+            bool at_limit = options.max_depth != 0 && depth >= options.max_depth;
+            return at_limit ? WalkAction::Skip : WalkAction::Continue;
+        },
+        [&](NodeId node, size_t depth) {
+            if (size_t more = hidden(node, depth)) {
+                count = std::to_string(more);
+                out.append(prefix);
+                out.append(unicode ? "└── … " : "`-- ... ");
+                out.append(count);
+                out.append(" more\n");
+            }
+            if (opens(node, depth)) {
+                prefix.resize(marks.back());
+                marks.pop_back();
+            }
+            return WalkAction::Continue;
+        });
 }
 
-void TreeVisualizer::print(const Node& root, bool use_unicode) {
-    std::cout << visualize(root, use_unicode);
+} // namespace
+
+std::string TreeVisualizer::visualize(const Node& root, bool use_unicode) {
+    return visualize(NodeStore::from_node(root), use_unicode);
 }
 
-void TreeVisualizer::visualize_recursive(
-    const Node& node,
-    std::string& output,
-    const std::string& prefix,
-    bool is_last,
-    bool use_unicode
-) {
-    std::string branch = use_unicode ? (is_last ? "└── " : "├── ") : (is_last ? "`-- " : "|-- ");
-    std::string extension = use_unicode ? (is_last ? "    " : "│   ") : (is_last ? "    " : "|   ");
+std::string TreeVisualizer::visualize(const NodeStore& tree, bool use_unicode) {
+    Options options;
+    options.use_unicode = use_unicode;
+    return visualize(tree, options);
+}
+
+std::string TreeVisualizer::visualize(const NodeStore& tree, const Options& options) {
+    RenderOutput out;
+    render(tree, options, out);
+    return std::move(out.text());
+}
 
-    output += prefix + branch + node.name;
-    if (node.is_directory()) {
-        output += "/";
+Result<void> TreeVisualizer::write(const NodeStore& tree, int fd, const Options& options) {
+    RenderOutput out(fd);
+    render(tree, options, out);
+    out.flush();
+    if (out.error() != 0) {
+        return Error(ErrorCode::CannotCreateFile, "Cannot write tree", std::strerror(out.error()));
     }
-    output += "\n";
+    return Result<void>();
+}
 
-    std::string child_prefix = prefix + extension;
+void TreeVisualizer::print(const Node& root, bool use_unicode) {
+    print(NodeStore::from_node(root), use_unicode);
+}
 
-    for (size_t i = 0; i < node.children.size(); ++i) {
-        bool child_is_last = (i == node.children.size() - 1);
-        visualize_recursive(*node.children[i], output, child_prefix, child_is_last, use_unicode);
-    }
+void TreeVisualizer::print(const NodeStore& tree, bool use_unicode) {
+    Options options;
+    options.use_unicode = use_unicode;
+    print(tree, options);
+}
+
+void TreeVisualizer::print(const NodeStore& tree, const Options& options) {
+    std::cout.flush();
+    write(tree, 1, options);
 }
 
 } // namespace yaqeen::core
@@ -0,0 +1,139 @@
+#include "yaqeen/core/path_list.hpp"
+#include "yaqeen/utils/mapped_file.hpp"
+#include "yaqeen/utils/logger.hpp"
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace yaqeen::core {
+
+Result<std::unique_ptr<Node>> PathListParser::parse(const std::filesystem::path& list_file) {
+    auto tree = parse_store(list_file);
+    if (tree.is_error()) {
+        return tree.error();
+    }
+    return tree.value().to_node();
+}
+
+Result<std::unique_ptr<Node>> PathListParser::parse_string(std::string_view list) {
+    auto tree = parse_string_store(list);
+    if (tree.is_error()) {
+        return tree.error();
+    }
+    return tree.value().to_node();
+}
+
+Result<NodeStore> PathListParser::parse_store(const std::filesystem::path& list_file) {
+    auto file = MappedFile::open(list_file);
+    if (file.is_error()) {
+        return file.error();
+    }
+    return parse_string_store(file.value().view());
+}
+
+NodeId PathListParser::child(NodeStore& tree, NodeId parent, std::string_view name, bool is_directory) {
+    // While a directory's children arrive in order, its last child is the
+    // greatest, so anything greater is new and only an equal name repeats
+    bool unordered = !unordered_.empty() && unordered_.count(parent) != 0;
+    NodeId last = tree.last_child(parent);
+    if (!unordered && last != NodeStore::kNone) {
+        int order = std::string_view(tree.name(last)).compare(name);
+        if (order == 0) {
+            return last;
+        }
+        if (order > 0) {
+            unordered_.insert(parent);
+            unordered = true;
+        }
+    }
+
+    if (!unordered) {
+        return tree.add_child(parent, name, is_directory);
+    }
+
+    // A repeated file, or a file listed again as a directory, is the entry
+    // already there; the caller promotes it if needed
+    stats_.indexed_lookups++;
+    return tree.place_child(parent, name, is_directory).id;
+}
+
+Result<NodeStore> PathListParser::parse_string_store(std::string_view list) {
+    LOG_DEBUG("Parsing path list");
+
+    unordered_.clear();
+    stats_ = Stats{};
+
+    NodeStore tree(names_);
+    tree.add_root("root");
+
+    // The directories the previous line went through; chain[0] is the root
+    std::vector<NodeId> chain{tree.root()};
+
+    const char* cursor = list.data();
+    const char* end = list.data() + list.size();
+    size_t line_number = 0;
+    while (cursor < end) {
+        auto newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+        const char* line_end = newline ? newline : end;
+        std::string_view line(cursor, static_cast<size_t>(line_end - cursor));
+        cursor = newline ? newline + 1 : end;
+        ++line_number;
+
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        while (line.size() >= 2 && line[0] == '.' && line[1] == '/') {
+            line.remove_prefix(2);
+        }
+        if (line.empty() || line == ".") {
+            continue;
+        }
+        if (line.front() == '/') {
+            return Error(ErrorCode::InvalidInput, "Path list entries must be relative",
+                "line " + std::to_string(line_number) + ": " + std::string(line));
+        }
+        stats_.lines++;
+
+        bool is_directory = line.back() == '/';
+        size_t depth = 0;
+        while (!line.empty()) {
+            size_t slash = line.find('/');
+            auto name = line.substr(0, slash);
+            line = slash == std::string_view::npos ? std::string_view() : line.substr(slash + 1);
+            if (name.empty() || name == ".") {
+                continue;
+            }
+            if (name == "..") {
+                return Error(ErrorCode::InvalidInput, "Path list entries cannot contain '..'",
+                    "line " + std::to_string(line_number));
+            }
+
+            // Every component but the last is a directory
+            bool last = line.find_first_not_of('/') == std::string_view::npos;
+            bool directory = !last || is_directory;
+
+            NodeId node;
+            if (depth + 1 < chain.size() && tree.name(chain[depth + 1]) == name) {
+                node = chain[depth + 1];
+            } else {
+                chain.resize(depth + 1);
+                node = child(tree, chain[depth], name, directory);
+                chain.push_back(node);
+            }
+
+            // `find` prints directories without a slash before their entries
+            if (directory && tree.is_file(node)) {
+                tree.set_directory(node, true);
+            }
+            ++depth;
+        }
+    }
+
+    if (tree.child_count(tree.root()) == 0) {
+        return Error(ErrorCode::InvalidInput, "Path list is empty");
+    }
+
+    return tree;
+}
+
+} // namespace yaqeen::core
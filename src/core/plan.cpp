@@ -0,0 +1,216 @@
+#include "yaqeen/core/plan.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <utility>
+
+namespace yaqeen::core {
+
+namespace {
+    // source is the root's document, which content spans index into
+    PlanEntry entry_for(const Node& node, uint32_t parent, uint32_t depth, std::string_view source) {
+        PlanEntry entry;
+        entry.name = &node.name;
+        entry.is_directory = node.is_directory();
+        entry.parent = parent;
+        entry.depth = depth;
+        if (!entry.is_directory && node.content) {
+            entry.content = *node.content;
+        } else if (!entry.is_directory && node.content_span.offset < source.size()) {
+            entry.content = source.substr(node.content_span.offset, node.content_span.length);
+        }
+        return entry;
+    }
+}
+
+void GenerationPlan::add(const PlanEntry& entry) {
+    entries_.push_back(entry);
+    if (entry.is_directory) {
+        directories_++;
+    } else {
+        files_++;
+        content_bytes_ += entry.content.size();
+    }
+}
+
+GenerationPlan GenerationPlan::compile(const Node& root) {
+    GenerationPlan plan;
+    std::string_view source = root.source ? root.source->view() : std::string_view();
+    plan.add(entry_for(root, PlanEntry::kNoParent, 0, source));
+
+    // Directories whose children still have to be laid out. Child
+    // directories are pushed in reverse so that the first one is expanded
+    // next, which keeps the blocks in depth-first order.
+    std::vector<std::pair<const Node*, uint32_t>> pending;
+    if (root.is_directory()) {
+        pending.emplace_back(&root, 0);
+    }
+
+    while (!pending.empty()) {
+        auto [dir, index] = pending.back();
+        pending.pop_back();
+
+        auto first = static_cast<uint32_t>(plan.entries_.size());
+        auto depth = plan.entries_[index].depth + 1;
+        plan.entries_[index].first_child = first;
+        plan.entries_[index].child_count = static_cast<uint32_t>(dir->children.size());
+
+        for (const auto& child : dir->children) {
+            plan.add(entry_for(*child, index, depth, source));
+        }
+
+        for (size_t i = dir->children.size(); i-- > 0;) {
+            const Node& child = *dir->children[i];
+            if (child.is_directory() && !child.children.empty()) {
+                pending.emplace_back(&child, first + static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+    return plan;
+}
+
+GenerationPlan GenerationPlan::compile(const NodeStore& tree) {
+    GenerationPlan plan;
+    if (tree.empty()) {
+        return plan;
+    }
+
+    auto entry_for = [&tree](NodeId node, uint32_t parent, uint32_t depth) {
+        PlanEntry entry;
+        entry.name = &tree.name(node);
+        entry.is_directory = tree.is_directory(node);
+        entry.parent = parent;
+        entry.depth = depth;
+        if (!entry.is_directory) {
+            entry.content = tree.content(node);
+        }
+        return entry;
+    };
+
+    plan.names_interned_ = true;
+    plan.entries_.reserve(tree.size());
+    plan.add(entry_for(tree.root(), PlanEntry::kNoParent, 0));
+
+    // Laid out as compile(const Node&) does; pending holds store ids
+    std::vector<std::pair<NodeId, uint32_t>> pending;
+    if (tree.is_directory(tree.root())) {
+        pending.emplace_back(tree.root(), 0);
+    }
+
+    std::vector<std::pair<NodeId, uint32_t>> subdirectories;
+    while (!pending.empty()) {
+        auto [dir, index] = pending.back();
+        pending.pop_back();
+
+        auto first = static_cast<uint32_t>(plan.entries_.size());
+        auto depth = plan.entries_[index].depth + 1;
+        plan.entries_[index].first_child = first;
+        plan.entries_[index].child_count = tree.child_count(dir);
+
+        subdirectories.clear();
+        uint32_t position = first;
+        for (NodeId child = tree.first_child(dir); child != NodeStore::kNone; child = tree.next_sibling(child)) {
+            plan.add(entry_for(child, index, depth));
+            if (tree.is_directory(child) && tree.first_child(child) != NodeStore::kNone) {
+                subdirectories.emplace_back(child, position);
+            }
+            ++position;
+        }
+        pending.insert(pending.end(), subdirectories.rbegin(), subdirectories.rend());
+    }
+
+    return plan;
+}
+
+std::string GenerationPlan::relative_path(size_t index) const {
+    std::vector<const std::string*> names;
+    for (size_t i = index; i != 0; i = entries_[i].parent) {
+        names.push_back(entries_[i].name);
+    }
+
+    std::string path;
+    for (auto it = names.rbegin(); it != names.rend(); ++it) {
+        if (!path.empty()) {
+            path += '/';
+        }
+        path += **it;
+    }
+    return path;
+}
+
+GenerationPlan GenerationPlan::subset(const std::vector<bool>& keep) const {
+    GenerationPlan plan;
+    plan.names_interned_ = names_interned_;
+    if (entries_.empty()) {
+        return plan;
+    }
+
+    // Parents precede children, so one backward sweep marks every ancestor
+    std::vector<bool> needed(keep.begin(), keep.end());
+    needed.resize(entries_.size(), false);
+    needed[0] = true;
+    for (size_t i = entries_.size(); i-- > 1;) {
+        if (needed[i]) {
+            needed[entries_[i].parent] = true;
+        }
+    }
+
+    // Dropping entries keeps what remains of each child block contiguous
+    std::vector<uint32_t> remap(entries_.size(), PlanEntry::kNoParent);
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (!needed[i]) {
+            continue;
+        }
+
+        PlanEntry entry = entries_[i];
+        auto index = static_cast<uint32_t>(plan.entries_.size());
+        remap[i] = index;
+        entry.first_child = 0;
+        entry.child_count = 0;
+
+        if (i != 0) {
+            entry.parent = remap[entry.parent];
+            auto& parent = plan.entries_[entry.parent];
+            if (parent.child_count == 0) {
+                parent.first_child = index;
+            }
+            parent.child_count++;
+        }
+        plan.add(entry);
+    }
+
+    return plan;
+}
+
+void GenerationPlan::print(std::ostream& out) const {
+    out << "# " << entries_.size() << " operations: " << directories_ << " directories, "
+        << files_ << " files, " << content_bytes_ << " bytes\n";
+    out << "#  index  parent  type         size  path\n";
+
+    std::string root_name = entries_.empty() ? std::string() : *entries_[0].name;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        const auto& entry = entries_[i];
+
+        out << std::setw(8) << i << "  ";
+        if (entry.parent == PlanEntry::kNoParent) {
+            out << std::setw(6) << "-";
+        } else {
+            out << std::setw(6) << entry.parent;
+        }
+        out << "  " << (entry.is_directory ? "dir " : "file") << "  ";
+        if (entry.is_directory) {
+            out << std::setw(11) << "-";
+        } else {
+            out << std::setw(11) << entry.content.size();
+        }
+
+        auto path = relative_path(i);
+        out << "  " << root_name;
+        if (!path.empty()) {
+            out << '/' << path;
+        }
+        out << (entry.is_directory ? "/\n" : "\n");
+    }
+}
+
+} // namespace yaqeen::core
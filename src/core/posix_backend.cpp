@@ -0,0 +1,366 @@
+#include "yaqeen/core/backend.hpp"
+
+#if YAQEEN_HAS_POSIX_BACKEND
+
+#include "yaqeen/utils/hash.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/fs.h>)
+#include <linux/fs.h>
+#endif
+
+namespace yaqeen::core {
+
+namespace {
+    constexpr int kDirectoryFlags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+
+    // Each remembered source keeps a descriptor open; stay well below RLIMIT_NOFILE
+    constexpr size_t kMaxDedupSources = 256;
+
+    std::string errno_message() {
+        return std::strerror(errno);
+    }
+
+    // Write the whole buffer, retrying on short writes and EINTR.
+    // Returns the number of write(2) calls issued, or -1 on failure.
+    long write_all(int fd, std::string_view content) {
+        const char* data = content.data();
+        size_t remaining = content.size();
+        long calls = 0;
+
+        while (remaining > 0) {
+            ssize_t written = ::write(fd, data, remaining);
+            calls++;
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -1;
+            }
+            data += written;
+            remaining -= static_cast<size_t>(written);
+        }
+
+        return calls;
+    }
+}
+
+PosixBackend::PosixBackend(const BackendOptions& options)
+    : overwrite_(options.overwrite)
+    , dedup_(options.dedup)
+    , dedup_hardlinks_(options.dedup_hardlinks)
+    , dedup_min_size_(std::max<size_t>(options.dedup_min_size, 1)) {
+}
+
+PosixBackend::~PosixBackend() {
+    for (auto& [hash, sources] : sources_) {
+        for (auto& source : sources) {
+            ::close(source.fd);
+        }
+    }
+}
+
+Result<GenerationBackend::DirHandle> PosixBackend::open_root(const std::filesystem::path& path) {
+    int fd = ::open(path.c_str(), kDirectoryFlags);
+    count_syscalls();
+    if (fd >= 0) {
+        return fd;
+    }
+
+    if (errno == ENOTDIR) {
+        return Error(ErrorCode::FileAlreadyExists,
+                    "Path exists but is not a directory: " + path.string());
+    }
+
+    // The output root may need several missing parents; this happens once per run
+    std::error_code ec;
+    std::filesystem::create_directories(path, ec);
+    if (ec) {
+        return Error(ErrorCode::CannotCreateDirectory,
+                    "Cannot create directory: " + path.string(),
+                    ec.message());
+    }
+
+    fd = ::open(path.c_str(), kDirectoryFlags);
+    count_syscalls();
+    if (fd < 0) {
+        return Error(ErrorCode::CannotCreateDirectory,
+                    "Cannot open directory: " + path.string(),
+                    errno_message());
+    }
+
+    return fd;
+}
+
+Result<void> PosixBackend::create_directory(
+    DirHandle parent,
+    const std::string& name,
+    std::string_view path
+) {
+    count_syscalls();
+    if (::mkdirat(parent, name.c_str(), 0777) == 0) {
+        return Result<void>();
+    }
+
+    if (errno != EEXIST) {
+        return Error(ErrorCode::CannotCreateDirectory,
+                    "Cannot create directory: " + std::string(path),
+                    errno_message());
+    }
+
+    return check_existing_directory(parent, name, path);
+}
+
+Result<void> PosixBackend::check_existing_directory(
+    DirHandle parent,
+    const std::string& name,
+    std::string_view path
+) {
+    // Only a conflict costs a stat: reuse directories, reject anything else
+    struct stat st;
+    count_syscalls();
+    if (::fstatat(parent, name.c_str(), &st, 0) == 0 && S_ISDIR(st.st_mode)) {
+        return Result<void>();
+    }
+
+    return Error(ErrorCode::FileAlreadyExists,
+                "Path exists but is not a directory: " + std::string(path));
+}
+
+Result<GenerationBackend::DirHandle> PosixBackend::open_directory(
+    DirHandle parent,
+    const std::string& name,
+    std::string_view path
+) {
+    int fd = ::openat(parent, name.c_str(), kDirectoryFlags);
+    count_syscalls();
+    if (fd < 0) {
+        return Error(ErrorCode::CannotCreateDirectory,
+                    "Cannot open directory: " + std::string(path),
+                    errno_message());
+    }
+    return fd;
+}
+
+Result<FileOutcome> PosixBackend::create_file(
+    DirHandle parent,
+    const std::string& name,
+    std::string_view content,
+    std::string_view path
+) {
+    if (!dedup_candidate(content)) {
+        return write_file(parent, name, content, path, overwrite_);
+    }
+
+    if (auto duplicate = create_duplicate(parent, name, content, path)) {
+        return std::move(*duplicate);
+    }
+
+    auto written = write_file(parent, name, content, path, overwrite_);
+    if (written.is_ok() && !written.value().existed) {
+        remember_source(parent, name, content);
+    }
+    return written;
+}
+
+int PosixBackend::open_new_file(DirHandle parent, const std::string& name, bool replace) {
+    // O_EXCL makes the open itself the collision check
+    constexpr int kFlags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+    int fd = ::openat(parent, name.c_str(), kFlags, 0666);
+    count_syscalls();
+    if (fd >= 0 || errno != EEXIST || !replace) {
+        return fd;
+    }
+
+    // Unlink rather than truncate: the old file may share its inode with
+    // hard links (dedup_hardlinks), which must keep their own content
+    count_syscalls(2);
+    if (::unlinkat(parent, name.c_str(), 0) != 0 && errno != ENOENT) {
+        return -1;
+    }
+    return ::openat(parent, name.c_str(), kFlags, 0666);
+}
+
+Result<FileOutcome> PosixBackend::write_file(
+    DirHandle parent,
+    const std::string& name,
+    std::string_view content,
+    std::string_view path,
+    bool replace
+) {
+    int fd = open_new_file(parent, name, replace);
+    if (fd < 0) {
+        if (errno == EEXIST && !replace) {
+            return FileOutcome{0, true};
+        }
+
+        return Error(ErrorCode::CannotCreateFile,
+                    "Cannot create file: " + std::string(path),
+                    errno_message());
+    }
+
+    long write_calls = write_all(fd, content);
+    int write_errno = errno;
+    count_syscalls(write_calls < 0 ? 1 : static_cast<size_t>(write_calls));
+
+    count_syscalls();
+    if (::close(fd) != 0 && write_calls >= 0) {
+        write_calls = -1;
+        write_errno = errno;
+    }
+
+    if (write_calls < 0) {
+        errno = write_errno;
+        return Error(ErrorCode::CannotCreateFile,
+                    "Cannot write file: " + std::string(path),
+                    errno_message());
+    }
+
+    return FileOutcome{content.size(), false};
+}
+
+void PosixBackend::close_directory(DirHandle dir) {
+    count_syscalls();
+    ::close(dir);
+}
+
+BackendCounters PosixBackend::counters() const {
+    BackendCounters counters;
+    counters.syscalls = syscalls_.load();
+    counters.bytes_saved = bytes_saved_.load();
+    return counters;
+}
+
+int PosixBackend::find_source(std::string_view content) {
+    std::lock_guard<std::mutex> lock(sources_mutex_);
+    auto it = sources_.find(Hash::fnv1a(content));
+    if (it == sources_.end()) {
+        return -1;
+    }
+
+    // The hash only narrows the search; identical bytes are required
+    for (const auto& source : it->second) {
+        if (source.content == content) {
+            return source.fd;
+        }
+    }
+    return -1;
+}
+
+bool PosixBackend::has_source(std::string_view content) {
+    return find_source(content) >= 0;
+}
+
+void PosixBackend::remember_source(DirHandle parent, const std::string& name, std::string_view content) {
+    {
+        std::lock_guard<std::mutex> lock(sources_mutex_);
+        if (source_count_ >= kMaxDedupSources) {
+            return;
+        }
+    }
+
+    int fd = ::openat(parent, name.c_str(), O_RDONLY | O_CLOEXEC);
+    count_syscalls();
+    if (fd < 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(sources_mutex_);
+    auto& sources = sources_[Hash::fnv1a(content)];
+    for (const auto& source : sources) {
+        if (source.content == content || source_count_ >= kMaxDedupSources) {
+            // Another thread got there first
+            count_syscalls();
+            ::close(fd);
+            return;
+        }
+    }
+    sources.push_back(DedupSource{content, fd});
+    source_count_++;
+}
+
+std::optional<Result<FileOutcome>> PosixBackend::create_duplicate(
+    DirHandle parent,
+    const std::string& name,
+    std::string_view content,
+    std::string_view path
+) {
+    int source = find_source(content);
+    if (source < 0) {
+        return std::nullopt;
+    }
+
+#ifdef FICLONE
+    if (clone_supported_.load(std::memory_order_relaxed)) {
+        int fd = open_new_file(parent, name, overwrite_);
+        if (fd < 0) {
+            if (errno == EEXIST && !overwrite_) {
+                return Result<FileOutcome>(FileOutcome{0, true});
+            }
+            return Result<FileOutcome>(Error(ErrorCode::CannotCreateFile,
+                                             "Cannot create file: " + std::string(path),
+                                             errno_message()));
+        }
+
+        int cloned = ::ioctl(fd, FICLONE, source);
+        int clone_errno = errno;
+        count_syscalls(2);  // ioctl and close
+        ::close(fd);
+
+        if (cloned == 0) {
+            bytes_saved_.fetch_add(content.size(), std::memory_order_relaxed);
+            return Result<FileOutcome>(FileOutcome{0, false});
+        }
+
+        // Whole-filesystem answers are remembered; per-file ones are not
+        if (clone_errno == EOPNOTSUPP || clone_errno == ENOTTY || clone_errno == EXDEV) {
+            clone_supported_.store(false, std::memory_order_relaxed);
+        }
+
+        if (!dedup_hardlinks_) {
+            return Result<FileOutcome>(write_file(parent, name, content, path, true));
+        }
+
+        // Make room for the link
+        count_syscalls();
+        ::unlinkat(parent, name.c_str(), 0);
+    }
+#endif
+
+    if (!dedup_hardlinks_) {
+        return std::nullopt;
+    }
+
+#if defined(__linux__)
+    // Link the source descriptor itself; its directory is not known here
+    std::string source_path = "/proc/self/fd/" + std::to_string(source);
+    int linked = ::linkat(AT_FDCWD, source_path.c_str(), parent, name.c_str(), AT_SYMLINK_FOLLOW);
+    count_syscalls();
+    if (linked != 0 && errno == EEXIST) {
+        if (!overwrite_) {
+            return Result<FileOutcome>(FileOutcome{0, true});
+        }
+        count_syscalls(2);
+        ::unlinkat(parent, name.c_str(), 0);
+        linked = ::linkat(AT_FDCWD, source_path.c_str(), parent, name.c_str(), AT_SYMLINK_FOLLOW);
+    }
+
+    if (linked == 0) {
+        bytes_saved_.fetch_add(content.size(), std::memory_order_relaxed);
+        return Result<FileOutcome>(FileOutcome{0, false});
+    }
+#endif
+
+    // Hard links unavailable (no /proc, cross-device, ...): write a plain copy
+    return std::nullopt;
+}
+
+} // namespace yaqeen::core
+
+#endif // YAQEEN_HAS_POSIX_BACKEND
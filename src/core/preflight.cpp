@@ -0,0 +1,430 @@
+#include "yaqeen/core/preflight.hpp"
+#include "yaqeen/core/backend.hpp"
+#include <cerrno>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if YAQEEN_HAS_POSIX_BACKEND
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#endif
+
+namespace yaqeen::core {
+
+namespace {
+    constexpr size_t kMaxNameLength = 255;
+    constexpr size_t kMaxListed = 20;
+
+    // Collects every problem so that one run reports all of them
+    class Problems {
+    public:
+        void add(ErrorCode code, std::string message) {
+            if (count_ == 0) {
+                code_ = code;
+            }
+            count_++;
+            if (messages_.size() < kMaxListed) {
+                messages_.push_back(std::move(message));
+            }
+        }
+
+        bool empty() const { return count_ == 0; }
+
+        Error to_error() const {
+            std::string message = messages_.front();
+            if (count_ > 1) {
+                message += " (and " + std::to_string(count_ - 1) + " more problems)";
+            }
+
+            std::string details;
+            for (const auto& line : messages_) {
+                details += line;
+                details += '\n';
+            }
+            if (count_ > messages_.size()) {
+                details += "...\n";
+            }
+            return Error(code_, message, details);
+        }
+
+    private:
+        ErrorCode code_ = ErrorCode::UnknownError;
+        size_t count_ = 0;
+        std::vector<std::string> messages_;
+    };
+
+    enum class Kind { Missing, Directory, Other };
+
+    using Listing = std::unordered_map<std::string, Kind>;
+
+    struct Space {
+        size_t block_size = 4096;
+        size_t bytes = 0;
+        size_t inodes = 0;  // 0 = no fixed limit
+    };
+
+#if YAQEEN_HAS_POSIX_BACKEND
+    // An existing directory of the output tree, held open so that its
+    // children are looked up without resolving the whole path again
+    using DirRef = int;
+
+    Kind kind_at(int dir, const char* name) {
+        struct stat st;
+        if (::fstatat(dir, name, &st, 0) != 0) {
+            return errno == ENOENT ? Kind::Missing : Kind::Other;
+        }
+        return S_ISDIR(st.st_mode) ? Kind::Directory : Kind::Other;
+    }
+
+    Kind kind_of(const std::filesystem::path& path) {
+        return kind_at(AT_FDCWD, path.c_str());
+    }
+
+    bool writable(const std::filesystem::path& path) {
+        return ::faccessat(AT_FDCWD, path.c_str(), W_OK | X_OK, AT_EACCESS) == 0;
+    }
+
+    bool writable(DirRef dir) {
+        return ::faccessat(dir, ".", W_OK | X_OK, AT_EACCESS) == 0;
+    }
+
+    bool open_output(const std::filesystem::path& path, DirRef& dir) {
+        dir = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        return dir >= 0;
+    }
+
+    bool open_child(DirRef parent, const std::string& name, DirRef& dir) {
+        dir = ::openat(parent, name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        return dir >= 0;
+    }
+
+    void close_dir(DirRef dir) {
+        ::close(dir);
+    }
+
+    // Read every name in dir in one pass; symlinks count as what they point to
+    bool list(DirRef dir, Listing& listing) {
+        // closedir() closes the descriptor it was given, so hand it a copy
+        int copy = ::dup(dir);
+        DIR* stream = copy >= 0 ? ::fdopendir(copy) : nullptr;
+        if (!stream) {
+            if (copy >= 0) {
+                ::close(copy);
+            }
+            return false;
+        }
+
+        while (const dirent* entry = ::readdir(stream)) {
+            std::string_view name = entry->d_name;
+            if (name == "." || name == "..") {
+                continue;
+            }
+
+            Kind kind = Kind::Other;
+#ifdef _DIRENT_HAVE_D_TYPE
+            if (entry->d_type == DT_DIR) {
+                kind = Kind::Directory;
+            } else if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) {
+                kind = kind_at(dir, entry->d_name);
+            }
+#else
+            kind = kind_at(dir, entry->d_name);
+#endif
+            // A dangling symlink still occupies the name
+            listing.emplace(name, kind == Kind::Missing ? Kind::Other : kind);
+        }
+
+        ::closedir(stream);
+        return true;
+    }
+
+    bool available_space(const std::filesystem::path& path, Space& space) {
+        struct statvfs vfs;
+        if (::statvfs(path.c_str(), &vfs) != 0) {
+            return false;
+        }
+        size_t fragment = vfs.f_frsize ? vfs.f_frsize : vfs.f_bsize;
+        space.block_size = fragment ? fragment : space.block_size;
+        space.bytes = static_cast<size_t>(vfs.f_bavail) * fragment;
+        space.inodes = vfs.f_files ? static_cast<size_t>(vfs.f_favail) : 0;
+        return true;
+    }
+#else
+    using DirRef = std::filesystem::path;
+
+    Kind kind_of(const std::filesystem::path& path) {
+        std::error_code ec;
+        auto status = std::filesystem::status(path, ec);
+        if (!std::filesystem::exists(status)) {
+            return Kind::Missing;
+        }
+        return std::filesystem::is_directory(status) ? Kind::Directory : Kind::Other;
+    }
+
+    bool writable(const std::filesystem::path& path) {
+        std::error_code ec;
+        auto perms = std::filesystem::status(path, ec).permissions();
+        return !ec && (perms & std::filesystem::perms::owner_write) != std::filesystem::perms::none;
+    }
+
+    bool open_output(const std::filesystem::path& path, DirRef& dir) {
+        dir = path;
+        return true;
+    }
+
+    bool open_child(const DirRef& parent, const std::string& name, DirRef& dir) {
+        dir = parent / name;
+        return true;
+    }
+
+    void close_dir(const DirRef&) {
+    }
+
+    bool list(const DirRef& dir, Listing& listing) {
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            auto kind = it->is_directory(ec) ? Kind::Directory : Kind::Other;
+            listing.emplace(it->path().filename().string(), kind);
+        }
+        return !ec;
+    }
+
+    bool available_space(const std::filesystem::path& path, Space& space) {
+        std::error_code ec;
+        auto info = std::filesystem::space(path, ec);
+        if (ec) {
+            return false;
+        }
+        space.bytes = static_cast<size_t>(info.available);
+        return true;
+    }
+#endif
+
+    size_t round_up(size_t size, size_t block) {
+        return (size + block - 1) / block * block;
+    }
+
+    std::string display(const GenerationPlan& plan, const std::filesystem::path& target, size_t index) {
+        return index == 0 ? target.string() : (target / plan.relative_path(index)).string();
+    }
+
+    void check_names(const GenerationPlan& plan, const std::filesystem::path& target, Problems& problems) {
+        // Interned names are equal exactly when their pointers are
+        std::unordered_set<std::string_view> siblings;
+        std::unordered_set<const std::string*> interned;
+        for (size_t dir = 0; dir < plan.size(); ++dir) {
+            const auto& owner = plan[dir];
+            if (owner.child_count == 0) {
+                continue;
+            }
+
+            siblings.clear();
+            interned.clear();
+            for (size_t i = owner.first_child; i < owner.first_child + owner.child_count; ++i) {
+                const auto& name = *plan[i].name;
+                if (!is_valid_entry_name(name)) {
+                    problems.add(ErrorCode::InvalidInput,
+                                 "Invalid name \"" + name + "\" in " + display(plan, target, dir));
+                } else if (plan.names_interned() ? !interned.insert(&name).second
+                                                 : !siblings.insert(name).second) {
+                    problems.add(ErrorCode::InvalidInput, "Duplicate entry: " + display(plan, target, i));
+                }
+            }
+        }
+    }
+
+    // Walk the directories that already exist, one listing each, recording
+    // which plan entries are present. Entries below a new directory are new
+    // by construction and never looked up.
+    void sweep(
+        const GenerationPlan& plan,
+        const std::filesystem::path& target,
+        const PreflightOptions& options,
+        std::vector<bool>& existing,
+        PreflightReport& report,
+        Problems& problems
+    ) {
+        struct Pending {
+            uint32_t index;
+            DirRef dir;
+        };
+        std::vector<Pending> pending;
+
+        DirRef root;
+        if (!open_output(target, root)) {
+            problems.add(ErrorCode::PermissionDenied, "Cannot open directory: " + target.string());
+            return;
+        }
+        pending.push_back(Pending{0, root});
+
+        Listing listing;
+        while (!pending.empty()) {
+            auto [index, dir] = pending.back();
+            pending.pop_back();
+            const auto& owner = plan[index];
+
+            listing.clear();
+            if (!list(dir, listing)) {
+                problems.add(ErrorCode::PermissionDenied, "Cannot read directory: " + display(plan, target, index));
+                close_dir(dir);
+                continue;
+            }
+
+            bool writes = false;
+            for (uint32_t i = owner.first_child; i < owner.first_child + owner.child_count; ++i) {
+                const auto& entry = plan[i];
+                auto found = listing.find(*entry.name);
+                if (found == listing.end()) {
+                    writes = true;
+                    continue;
+                }
+
+                existing[i] = true;
+                if (entry.is_directory) {
+                    if (found->second != Kind::Directory) {
+                        problems.add(ErrorCode::FileAlreadyExists,
+                                     "Path exists but is not a directory: " + display(plan, target, i));
+                        continue;
+                    }
+                    report.existing_dirs++;
+                    if (entry.child_count == 0) {
+                        continue;
+                    }
+
+                    DirRef child;
+                    if (open_child(dir, *entry.name, child)) {
+                        pending.push_back(Pending{i, child});
+                    } else {
+                        problems.add(ErrorCode::PermissionDenied,
+                                     "Cannot open directory: " + display(plan, target, i));
+                    }
+                } else if (found->second == Kind::Directory) {
+                    problems.add(ErrorCode::FileAlreadyExists,
+                                 "Path exists as a directory: " + display(plan, target, i));
+                } else {
+                    report.existing_files++;
+                    writes = writes || options.overwrite;
+                }
+            }
+
+            if (writes && !writable(dir)) {
+                problems.add(ErrorCode::PermissionDenied,
+                             "Cannot write to directory: " + display(plan, target, index));
+            }
+            close_dir(dir);
+        }
+    }
+}
+
+bool is_valid_entry_name(std::string_view name) {
+    return !name.empty() && name != "." && name != ".." && name.size() <= kMaxNameLength &&
+           name.find('/') == std::string_view::npos && name.find('\0') == std::string_view::npos;
+}
+
+Result<PreflightReport> preflight(
+    const GenerationPlan& plan,
+    const std::filesystem::path& output_dir,
+    const PreflightOptions& options
+) {
+    PreflightReport report;
+    if (plan.empty()) {
+        return report;
+    }
+
+    auto target = output_dir.empty() ? std::filesystem::path(".") : output_dir.lexically_normal();
+    if (!target.has_filename() && target.has_parent_path()) {
+        target = target.parent_path();
+    }
+    auto parent = target.parent_path();
+    if (parent.empty()) {
+        parent = ".";
+    }
+
+    Problems problems;
+    check_names(plan, target, problems);
+    if (options.names_only) {
+        if (!problems.empty()) {
+            return problems.to_error();
+        }
+        return report;
+    }
+
+    bool root_is_directory = plan[0].is_directory;
+    Kind target_kind = options.fresh ? Kind::Missing : kind_of(target);
+    std::vector<bool> existing(plan.size(), false);
+
+    if (target_kind == Kind::Missing) {
+        // Everything is created below the parent, which must already exist
+        if (kind_of(parent) != Kind::Directory) {
+            problems.add(ErrorCode::DirectoryNotFound, "Parent directory does not exist: " + parent.string());
+            return problems.to_error();
+        }
+        if (!writable(parent)) {
+            problems.add(ErrorCode::PermissionDenied, "Cannot write to directory: " + parent.string());
+        }
+    } else if (!root_is_directory) {
+        existing[0] = true;
+        if (target_kind == Kind::Directory) {
+            problems.add(ErrorCode::FileAlreadyExists, "Path exists as a directory: " + target.string());
+        } else {
+            report.existing_files++;
+            if (options.overwrite && !writable(parent)) {
+                problems.add(ErrorCode::PermissionDenied, "Cannot write to directory: " + parent.string());
+            }
+        }
+    } else if (target_kind != Kind::Directory) {
+        problems.add(ErrorCode::FileAlreadyExists, "Path exists but is not a directory: " + target.string());
+    } else {
+        existing[0] = true;
+        report.existing_dirs++;
+        sweep(plan, target, options, existing, report, problems);
+    }
+
+    // Estimate what the new entries occupy; rewritten files need their
+    // blocks again but no new inode
+    Space space;
+    auto measured = target_kind == Kind::Directory ? target : parent;
+    if (available_space(measured, space)) {
+        for (size_t i = 0; i < plan.size(); ++i) {
+            const auto& entry = plan[i];
+            bool rewrite = existing[i] && !entry.is_directory && options.overwrite;
+            if (existing[i] && !rewrite) {
+                continue;
+            }
+            if (!existing[i]) {
+                report.inodes_needed++;
+            }
+            report.bytes_needed += entry.is_directory
+                ? space.block_size
+                : round_up(entry.content.size(), space.block_size);
+        }
+        report.bytes_available = space.bytes;
+        report.inodes_available = space.inodes;
+
+        if (report.bytes_needed > space.bytes) {
+            problems.add(ErrorCode::CannotCreateFile,
+                         "Not enough space in " + measured.string() + ": need " +
+                         std::to_string(report.bytes_needed) + " bytes, " +
+                         std::to_string(space.bytes) + " available");
+        }
+        if (space.inodes != 0 && report.inodes_needed > space.inodes) {
+            problems.add(ErrorCode::CannotCreateFile,
+                         "Not enough inodes in " + measured.string() + ": need " +
+                         std::to_string(report.inodes_needed) + ", " +
+                         std::to_string(space.inodes) + " available");
+        }
+    }
+
+    if (!problems.empty()) {
+        return problems.to_error();
+    }
+    return report;
+}
+
+} // namespace yaqeen::core
@@ -0,0 +1,305 @@
+#include "yaqeen/core/staging.hpp"
+#include "yaqeen/utils/logger.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+
+#if YAQEEN_HAS_POSIX_BACKEND
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+namespace yaqeen::core {
+
+namespace {
+    std::atomic<unsigned> g_sequence{0};
+
+    unsigned long process_id() {
+#if YAQEEN_HAS_POSIX_BACKEND
+        return static_cast<unsigned long>(::getpid());
+#else
+        return 0;
+#endif
+    }
+
+    // Hidden sibling name, unique per process and call: ".<name>.yaqeen-<tag>-<pid>-<n>"
+    std::filesystem::path sibling_path(const std::filesystem::path& target, const char* tag) {
+        std::string name = "." + target.filename().string() + ".yaqeen-" + tag + "-" +
+                           std::to_string(process_id()) + "-" + std::to_string(g_sequence++);
+        return target.parent_path() / name;
+    }
+
+    std::filesystem::path normalize_target(const std::filesystem::path& target) {
+        auto clean = target.lexically_normal();
+        if (!clean.has_filename() && clean.has_parent_path()) {
+            clean = clean.parent_path();
+        }
+        return clean;
+    }
+
+#if defined(__linux__) && defined(SYS_renameat2)
+    constexpr unsigned kRenameNoReplace = 1 << 0;
+    constexpr unsigned kRenameExchange = 1 << 1;
+
+    // Called directly: the glibc wrapper only exists from 2.28 on
+    int rename2(const std::filesystem::path& from, const std::filesystem::path& to, unsigned flags) {
+        return static_cast<int>(::syscall(SYS_renameat2, AT_FDCWD, from.c_str(), AT_FDCWD, to.c_str(), flags));
+    }
+#endif
+
+    Error write_error(const std::filesystem::path& path, const std::string& details) {
+        return Error(ErrorCode::CannotCreateFile, "Cannot create file: " + path.string(), details);
+    }
+
+#if YAQEEN_HAS_POSIX_BACKEND
+    bool write_all(int fd, std::string_view content) {
+        while (!content.empty()) {
+            ssize_t written = ::write(fd, content.data(), content.size());
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            content.remove_prefix(static_cast<size_t>(written));
+        }
+        return true;
+    }
+#endif
+
+#if defined(__linux__) && defined(O_TMPFILE)
+    // Write content to an unnamed file in the target's directory and link it
+    // in. Returns nullopt when O_TMPFILE or /proc is unavailable, so that the
+    // caller can fall back to a named temporary.
+    std::optional<Result<FileOutcome>> write_via_tmpfile(
+        const std::filesystem::path& path,
+        std::string_view content,
+        bool overwrite
+    ) {
+        auto parent = path.parent_path();
+        int fd = ::open(parent.empty() ? "." : parent.c_str(), O_TMPFILE | O_WRONLY | O_CLOEXEC, 0666);
+        if (fd < 0) {
+            if (errno == EOPNOTSUPP || errno == EISDIR || errno == EINVAL) {
+                return std::nullopt;
+            }
+            return Result<FileOutcome>(write_error(path, std::strerror(errno)));
+        }
+
+        if (!write_all(fd, content)) {
+            auto error = write_error(path, std::strerror(errno));
+            ::close(fd);
+            return Result<FileOutcome>(error);
+        }
+
+        // An O_TMPFILE is linked into place through its /proc entry;
+        // AT_EMPTY_PATH would need CAP_DAC_READ_SEARCH
+        std::string proc_path = "/proc/self/fd/" + std::to_string(fd);
+        auto link_name = overwrite ? sibling_path(path, "tmp") : path;
+        int linked = ::linkat(AT_FDCWD, proc_path.c_str(), AT_FDCWD, link_name.c_str(), AT_SYMLINK_FOLLOW);
+        int link_errno = errno;
+        ::close(fd);
+
+        if (linked != 0) {
+            if (!overwrite && link_errno == EEXIST) {
+                return Result<FileOutcome>(FileOutcome{0, true});
+            }
+            if (link_errno == ENOENT && std::filesystem::exists(parent.empty() ? "." : parent)) {
+                return std::nullopt;  // no /proc
+            }
+            return Result<FileOutcome>(write_error(path, std::strerror(link_errno)));
+        }
+
+        if (overwrite && ::rename(link_name.c_str(), path.c_str()) != 0) {
+            auto error = write_error(path, std::strerror(errno));
+            ::unlink(link_name.c_str());
+            return Result<FileOutcome>(error);
+        }
+
+        return Result<FileOutcome>(FileOutcome{content.size(), false});
+    }
+#endif
+}
+
+// StagingDirectory implementation
+Result<StagingDirectory> StagingDirectory::create(const std::filesystem::path& target) {
+    auto clean = normalize_target(target);
+    auto name = clean.filename();
+    if (name.empty() || name == "." || name == "..") {
+        return Error(ErrorCode::InvalidInput,
+                    "Atomic generation needs a named output directory: " + target.string());
+    }
+
+    // A name can only collide with leftovers of an earlier process with the same pid
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        auto path = sibling_path(clean, "staging");
+
+        std::error_code ec;
+        bool created = std::filesystem::create_directory(path, ec);
+        if (ec) {
+            return Error(ErrorCode::CannotCreateDirectory,
+                        "Cannot create staging directory: " + path.string(),
+                        ec.message());
+        }
+        if (created) {
+            return StagingDirectory(std::move(path), std::move(clean));
+        }
+    }
+
+    return Error(ErrorCode::CannotCreateDirectory,
+                "Cannot find a free staging directory name next to: " + clean.string());
+}
+
+StagingDirectory::StagingDirectory(StagingDirectory&& other) noexcept
+    : path_(std::move(other.path_))
+    , target_(std::move(other.target_))
+    , active_(other.active_) {
+    other.active_ = false;
+}
+
+StagingDirectory::~StagingDirectory() {
+    discard();
+}
+
+void StagingDirectory::discard() {
+    if (!active_) {
+        return;
+    }
+    active_ = false;
+
+    std::error_code ec;
+    std::filesystem::remove_all(path_, ec);
+    if (ec) {
+        LOG_WARN("Cannot remove staging directory " + path_.string() + ": " + ec.message());
+    }
+}
+
+Result<void> StagingDirectory::publish(bool overwrite) {
+    if (!active_) {
+        return Error(ErrorCode::InvalidInput, "Staging directory already published or discarded");
+    }
+
+#if defined(__linux__) && defined(SYS_renameat2)
+    if (rename2(path_, target_, kRenameNoReplace) == 0) {
+        active_ = false;
+        return Result<void>();
+    }
+
+    // Someone else may have created target since the caller checked
+    if (errno == EEXIST && !overwrite) {
+        return Error(ErrorCode::FileAlreadyExists, "Output directory already exists: " + target_.string());
+    }
+
+    if (errno == EEXIST && rename2(path_, target_, kRenameExchange) == 0) {
+        // path_ now holds the previous tree
+        discard();
+        return Result<void>();
+    }
+
+    // Filesystems without renameat2 flags take the portable route below
+    if (errno != EINVAL && errno != ENOSYS) {
+        return Error(ErrorCode::CannotCreateDirectory,
+                    "Cannot move staged tree into place: " + target_.string(),
+                    std::strerror(errno));
+    }
+#endif
+
+    std::error_code ec;
+    if (!std::filesystem::exists(target_, ec)) {
+        std::filesystem::rename(path_, target_, ec);
+        if (ec) {
+            return Error(ErrorCode::CannotCreateDirectory,
+                        "Cannot move staged tree into place: " + target_.string(),
+                        ec.message());
+        }
+        active_ = false;
+        return Result<void>();
+    }
+
+    if (!overwrite) {
+        return Error(ErrorCode::FileAlreadyExists, "Output directory already exists: " + target_.string());
+    }
+
+    // No atomic exchange: set the old tree aside, then move the new one in
+    auto previous = sibling_path(target_, "old");
+    std::filesystem::rename(target_, previous, ec);
+    if (ec) {
+        return Error(ErrorCode::CannotCreateDirectory,
+                    "Cannot replace: " + target_.string(),
+                    ec.message());
+    }
+
+    std::filesystem::rename(path_, target_, ec);
+    if (ec) {
+        std::error_code restore_ec;
+        std::filesystem::rename(previous, target_, restore_ec);
+        return Error(ErrorCode::CannotCreateDirectory,
+                    "Cannot move staged tree into place: " + target_.string(),
+                    ec.message());
+    }
+
+    active_ = false;
+    std::filesystem::remove_all(previous, ec);
+    return Result<void>();
+}
+
+Result<FileOutcome> write_file_atomically(
+    const std::filesystem::path& path,
+    std::string_view content,
+    bool overwrite
+) {
+#if defined(__linux__) && defined(O_TMPFILE)
+    if (auto result = write_via_tmpfile(path, content, overwrite)) {
+        return std::move(*result);
+    }
+#endif
+
+    auto temporary = sibling_path(path, "tmp");
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file || !file.write(content.data(), static_cast<std::streamsize>(content.size())).flush()) {
+            std::error_code ec;
+            std::filesystem::remove(temporary, ec);
+            return write_error(path, "cannot write temporary file " + temporary.string());
+        }
+    }
+
+    std::error_code ec;
+    if (!overwrite) {
+#if YAQEEN_HAS_POSIX_BACKEND
+        // link() refuses to replace, which makes the existence check atomic
+        int linked = ::link(temporary.c_str(), path.c_str());
+        int link_errno = errno;
+        std::filesystem::remove(temporary, ec);
+        if (linked == 0) {
+            return FileOutcome{content.size(), false};
+        }
+        if (link_errno == EEXIST) {
+            return FileOutcome{0, true};
+        }
+        return write_error(path, std::strerror(link_errno));
+#else
+        if (std::filesystem::exists(path, ec)) {
+            std::filesystem::remove(temporary, ec);
+            return FileOutcome{0, true};
+        }
+#endif
+    }
+
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) {
+        std::error_code cleanup_ec;
+        std::filesystem::remove(temporary, cleanup_ec);
+        return write_error(path, ec.message());
+    }
+
+    return FileOutcome{content.size(), false};
+}
+
+} // namespace yaqeen::core
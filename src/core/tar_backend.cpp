@@ -0,0 +1,282 @@
+#include "yaqeen/core/tar_backend.hpp"
+#include "yaqeen/core/preflight.hpp"
+
+#if YAQEEN_HAS_POSIX_BACKEND
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace yaqeen::core {
+
+namespace {
+    constexpr size_t kBlockSize = 512;
+    constexpr size_t kNameSize = 100;
+    constexpr size_t kPrefixSize = 155;
+    constexpr uint64_t kMaxOctalSize = 077777777777ULL;  // 11 octal digits
+
+    const char kZeros[2 * kBlockSize] = {};
+
+    size_t padding_for(size_t size) {
+        return (kBlockSize - size % kBlockSize) % kBlockSize;
+    }
+
+    // Zero-padded octal, NUL-terminated, filling width bytes
+    void put_octal(char* field, size_t width, uint64_t value) {
+        field[width - 1] = '\0';
+        for (size_t i = width - 1; i-- > 0;) {
+            field[i] = static_cast<char>('0' + (value & 7));
+            value >>= 3;
+        }
+    }
+
+    // Split a member name into ustar prefix and name fields, if it fits
+    bool split_name(std::string_view member, std::string_view& prefix, std::string_view& name) {
+        if (member.size() <= kNameSize) {
+            prefix = {};
+            name = member;
+            return true;
+        }
+
+        // The prefix ends at a '/', which is not stored
+        size_t limit = std::min(member.size() - 1, kPrefixSize);
+        for (size_t slash = member.rfind('/', limit); slash != std::string_view::npos && slash > 0;
+             slash = member.rfind('/', slash - 1)) {
+            if (member.size() - slash - 1 > kNameSize) {
+                break;
+            }
+            if (member.size() - slash - 1 > 0) {
+                prefix = member.substr(0, slash);
+                name = member.substr(slash + 1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void append_header(
+        std::string& out,
+        std::string_view prefix,
+        std::string_view name,
+        char type,
+        uint64_t size,
+        uint64_t mtime
+    ) {
+        char block[kBlockSize] = {};
+        std::memcpy(block, name.data(), std::min(name.size(), kNameSize));
+        put_octal(block + 100, 8, type == '5' ? 0755 : 0644);
+        put_octal(block + 108, 8, 0);  // uid
+        put_octal(block + 116, 8, 0);  // gid
+        put_octal(block + 124, 12, size);
+        put_octal(block + 136, 12, mtime);
+        block[156] = type;
+        std::memcpy(block + 257, "ustar", 6);
+        std::memcpy(block + 263, "00", 2);
+        std::memcpy(block + 345, prefix.data(), std::min(prefix.size(), kPrefixSize));
+
+        // The checksum is computed with its own field read as spaces
+        std::memset(block + 148, ' ', 8);
+        unsigned checksum = 0;
+        for (unsigned char c : block) {
+            checksum += c;
+        }
+        put_octal(block + 148, 7, checksum);
+        block[155] = ' ';
+
+        out.append(block, kBlockSize);
+    }
+
+    // One pax record: "<length> <key>=<value>\n", where length counts itself
+    void append_pax_record(std::string& out, std::string_view key, std::string_view value) {
+        size_t body = 1 + key.size() + 1 + value.size() + 1;
+        size_t length = body + 1;
+        while (std::to_string(length).size() + body != length) {
+            length = std::to_string(length).size() + body;
+        }
+        out += std::to_string(length);
+        out += ' ';
+        out += key;
+        out += '=';
+        out += value;
+        out += '\n';
+    }
+}
+
+Result<GenerationBackend::DirHandle> TarBackend::open_root(const std::filesystem::path& path) {
+    // The prefix names every member, so it must stay inside the directory
+    // the archive is extracted into
+    auto normal = path.lexically_normal();
+    if (normal.has_root_path()) {
+        return Error(ErrorCode::InvalidInput, "Archive prefix must be a relative path: " + path.string());
+    }
+    for (const auto& component : normal) {
+        auto name = component.string();
+        if (!name.empty() && name != "." && !is_valid_entry_name(name)) {
+            return Error(ErrorCode::InvalidInput, "Invalid archive prefix: " + path.string());
+        }
+    }
+
+    std::string prefix = normal.generic_string();
+    if (prefix == ".") {
+        prefix.clear();
+    }
+    while (!prefix.empty() && prefix.back() == '/') {
+        prefix.pop_back();
+    }
+    if (!prefix.empty()) {
+        prefix += '/';
+        auto written = write_entry(prefix, '5', {});
+        if (written.is_error()) {
+            return written.error();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_.push_back(std::move(prefix));
+    return static_cast<DirHandle>(slots_.size() - 1);
+}
+
+std::string TarBackend::member_name(DirHandle parent, const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_[static_cast<size_t>(parent)] + name;
+}
+
+Result<void> TarBackend::create_directory(
+    DirHandle parent,
+    const std::string& name,
+    std::string_view /*path*/
+) {
+    return write_entry(member_name(parent, name) + '/', '5', {});
+}
+
+Result<GenerationBackend::DirHandle> TarBackend::open_directory(
+    DirHandle parent,
+    const std::string& name,
+    std::string_view /*path*/
+) {
+    std::string prefix = member_name(parent, name) + '/';
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_slots_.empty()) {
+        DirHandle handle = free_slots_.back();
+        free_slots_.pop_back();
+        slots_[static_cast<size_t>(handle)] = std::move(prefix);
+        return handle;
+    }
+    slots_.push_back(std::move(prefix));
+    return static_cast<DirHandle>(slots_.size() - 1);
+}
+
+Result<FileOutcome> TarBackend::create_file(
+    DirHandle parent,
+    const std::string& name,
+    std::string_view content,
+    std::string_view /*path*/
+) {
+    auto written = write_entry(member_name(parent, name), '0', content);
+    if (written.is_error()) {
+        return written.error();
+    }
+    return FileOutcome{content.size(), false};
+}
+
+void TarBackend::close_directory(DirHandle dir) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_[static_cast<size_t>(dir)].clear();
+    free_slots_.push_back(dir);
+}
+
+Result<void> TarBackend::write_entry(const std::string& member, char type, std::string_view content) {
+    std::string headers;
+    std::string_view prefix;
+    std::string_view name;
+    bool fits = split_name(member, prefix, name);
+    bool huge = content.size() > kMaxOctalSize;
+
+    if (!fits || huge) {
+        // pax extended header carrying what ustar cannot represent
+        std::string records;
+        if (!fits) {
+            append_pax_record(records, "path", member);
+            prefix = {};
+            name = std::string_view(member).substr(0, kNameSize);
+        }
+        if (huge) {
+            append_pax_record(records, "size", std::to_string(content.size()));
+        }
+
+        append_header(headers, {}, "././@PaxHeader", 'x', records.size(), mtime_);
+        headers += records;
+        headers.append(padding_for(records.size()), '\0');
+    }
+    append_header(headers, prefix, name, type, huge ? 0 : content.size(), mtime_);
+
+    iovec iov[3];
+    iov[0] = {const_cast<char*>(headers.data()), headers.size()};
+    iov[1] = {const_cast<char*>(content.data()), content.size()};
+    iov[2] = {const_cast<char*>(kZeros), padding_for(content.size())};
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // writev may stop short on pipes; advance through the vectors and retry
+    iovec* current = iov;
+    int remaining = 3;
+    while (remaining > 0) {
+        ssize_t written = ::writev(fd_, current, remaining);
+        syscalls_++;
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return Error(ErrorCode::CannotCreateFile,
+                        "Cannot write archive entry: " + member,
+                        std::strerror(errno));
+        }
+
+        auto left = static_cast<size_t>(written);
+        while (remaining > 0 && left >= current->iov_len) {
+            left -= current->iov_len;
+            ++current;
+            --remaining;
+        }
+        if (remaining > 0) {
+            current->iov_base = static_cast<char*>(current->iov_base) + left;
+            current->iov_len -= left;
+        }
+    }
+
+    return Result<void>();
+}
+
+Result<void> TarBackend::finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t offset = 0;
+    while (offset < sizeof(kZeros)) {
+        ssize_t written = ::write(fd_, kZeros + offset, sizeof(kZeros) - offset);
+        syscalls_++;
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return Error(ErrorCode::CannotCreateFile,
+                        "Cannot finish archive",
+                        std::strerror(errno));
+        }
+        offset += static_cast<size_t>(written);
+    }
+
+    return Result<void>();
+}
+
+BackendCounters TarBackend::counters() const {
+    BackendCounters counters;
+    counters.syscalls = syscalls_;
+    return counters;
+}
+
+} // namespace yaqeen::core
+
+#endif // YAQEEN_HAS_POSIX_BACKEND
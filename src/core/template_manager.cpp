@@ -1,14 +1,130 @@
 #include "yaqeen/core/template_manager.hpp"
+#include "yaqeen/core/template_pack.hpp"
+#include "yaqeen/core/thread_pool.hpp"
 #include "yaqeen/utils/logger.hpp"
-#include "yaqeen/utils/validators.hpp"
-#include <fstream>
+#include "yaqeen/utils/mapped_file.hpp"
 #include <algorithm>
+#include <array>
+#include <functional>
 #include <iostream>
 #include <iomanip>
+#include <mutex>
 #include <set>
+#include <string_view>
 
 namespace yaqeen::core {
 
+namespace {
+
+// Reads the header keys of a template file into a small JSON object and
+// skips everything else, so listing templates builds no DOM for their
+// structures. Stops once every header key and the structure have been seen.
+class HeaderReader {
+public:
+    using json = nlohmann::json;
+
+    json header = json::object();
+    bool has_structure = false;
+    std::string error;
+
+    bool done() const { return has_structure && seen_ == kHeaderKeys.size(); }
+
+    bool null() { return value(nullptr); }
+    bool boolean(bool flag) { return value(flag); }
+    bool number_integer(json::number_integer_t number) { return value(number); }
+    bool number_unsigned(json::number_unsigned_t number) { return value(number); }
+    bool number_float(json::number_float_t number, const json::string_t&) { return value(number); }
+    bool string(json::string_t& text) { return value(std::move(text)); }
+    bool binary(json::binary_t&) { return value(nullptr); }
+
+    bool start_object(std::size_t) {
+        if (depth_ == 1 && capture_) {
+            header[key_] = json::object();
+        }
+        depth_++;
+        return true;
+    }
+
+    bool end_object() {
+        depth_--;
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        if (depth_ == 1 && capture_) {
+            header[key_] = json::array();
+        }
+        depth_++;
+        return true;
+    }
+
+    bool end_array() {
+        depth_--;
+        return true;
+    }
+
+    bool key(json::string_t& name) {
+        if (depth_ != 1) {
+            return true;
+        }
+        if (name == "structure") {
+            has_structure = true;
+            capture_ = false;
+            return !done();
+        }
+        capture_ = std::find(kHeaderKeys.begin(), kHeaderKeys.end(), name) != kHeaderKeys.end();
+        if (capture_) {
+            if (!header.contains(name)) {
+                seen_++;
+            }
+            key_ = std::move(name);
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) {
+        error = e.what();
+        return false;
+    }
+
+private:
+    static constexpr std::array<std::string_view, 7> kHeaderKeys = {
+        "name", "description", "version", "category", "tags", "author", "repository"
+    };
+
+    // Keeps header values and the strings of header arrays (tags)
+    bool value(json&& item) {
+        if (capture_ && depth_ == 1) {
+            header[key_] = std::move(item);
+        } else if (capture_ && depth_ == 2 && header[key_].is_array()) {
+            header[key_].push_back(std::move(item));
+        }
+        return true;
+    }
+
+    size_t depth_ = 0;  // 1 inside the top-level object
+    size_t seen_ = 0;
+    bool capture_ = false;
+    std::string key_;
+};
+
+} // namespace
+
+// Structures read by get_template(), by template name, and the compiled
+// pack they come from when the templates directory has a current one
+struct TemplateManager::StructureCache {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const nlohmann::json>> loaded;
+
+    std::unique_ptr<TemplatePack> pack;
+    std::unordered_map<std::string, size_t> packed;  // name -> pack index
+
+    const size_t* find_packed(const std::string& name) const {
+        auto it = packed.find(name);
+        return it == packed.end() ? nullptr : &it->second;
+    }
+};
+
 // TemplateInfo implementation
 Result<TemplateInfo> TemplateInfo::from_json(const nlohmann::json& json) {
     try {
@@ -38,6 +154,29 @@ Result<TemplateInfo> TemplateInfo::from_json(const nlohmann::json& json) {
     }
 }
 
+Result<TemplateInfo> TemplateInfo::read_from_file(const std::filesystem::path& path) {
+    auto file = MappedFile::open(path);
+    if (file.is_error()) {
+        return file.error();
+    }
+
+    HeaderReader reader;
+    auto text = file.value().view();
+    bool finished = nlohmann::json::sax_parse(text.begin(), text.end(), &reader);
+    if (!finished && !reader.done()) {
+        return Error(ErrorCode::InvalidJSONFormat,
+                    "Failed to parse template JSON: " + path.string(),
+                    reader.error);
+    }
+
+    if (!reader.has_structure) {
+        return Error(ErrorCode::InvalidTemplateStructure,
+                    "Template missing 'structure' field: " + path.string());
+    }
+
+    return from_json(reader.header);
+}
+
 nlohmann::json TemplateInfo::to_json() const {
     nlohmann::json j;
     j["name"] = name;
@@ -59,22 +198,16 @@ nlohmann::json TemplateInfo::to_json() const {
 
 // Template implementation
 Result<Template> Template::load_from_file(const std::filesystem::path& path) {
-    // Validate file
-    auto validation = Validator::validate_file_readable(path);
-    if (validation.is_error()) {
-        return validation.error();
+    // Map the file and parse straight from it
+    auto file = MappedFile::open(path);
+    if (file.is_error()) {
+        return file.error();
     }
 
-    // Read file
-    std::ifstream file(path);
-    if (!file) {
-        return Error(ErrorCode::FileNotFound, "Cannot open template file: " + path.string());
-    }
-
-    // Parse JSON
     nlohmann::json json;
     try {
-        file >> json;
+        auto text = file.value().view();
+        json = nlohmann::json::parse(text.begin(), text.end());
     } catch (const nlohmann::json::parse_error& e) {
         return Error(ErrorCode::InvalidJSONFormat,
                     "Failed to parse template JSON: " + path.string(),
@@ -110,11 +243,13 @@ bool Template::is_valid() const {
 // TemplateManager implementation
 TemplateManager::TemplateManager()
     : templates_dir_(get_default_templates_directory())
+    , structures_(std::make_shared<StructureCache>())
     , initialized_(false) {
 }
 
 TemplateManager::TemplateManager(const std::filesystem::path& templates_dir)
     : templates_dir_(templates_dir)
+    , structures_(std::make_shared<StructureCache>())
     , initialized_(false) {
 }
 
@@ -135,9 +270,36 @@ Result<void> TemplateManager::load_templates() {
     LOG_INFO("Loading templates from: " + templates_dir_.string());
 
     templates_.clear();
+    {
+        std::lock_guard<std::mutex> lock(structures_->mutex);
+        structures_->loaded.clear();
+        structures_->pack.reset();
+        structures_->packed.clear();
+    }
 
-    // Scan directory recursively
-    scan_directory(templates_dir_);
+    // A current pack replaces reading the JSON files
+    auto pack = TemplatePack::open(templates_dir_, TemplatePack::default_path(templates_dir_));
+    if (pack.is_ok()) {
+        auto& packed = *(structures_->pack = std::make_unique<TemplatePack>(std::move(pack.value())));
+        for (size_t i = 0; i < packed.size(); ++i) {
+            Template tmpl;
+            tmpl.info = packed.info(i);
+            tmpl.source_path = packed.source_path(i);
+            // Without a packed structure, the template is read from JSON
+            if (packed.has_structure(i)) {
+                structures_->packed.emplace(tmpl.info.name, i);
+            }
+            templates_.emplace(tmpl.info.name, std::move(tmpl));
+        }
+        LOG_DEBUG("Read templates from pack: " + TemplatePack::default_path(templates_dir_).string());
+    } else {
+        if (pack.error().code != ErrorCode::FileNotFound) {
+            LOG_DEBUG(pack.error().message + ": " + pack.error().details.value_or(""));
+        }
+
+        // Scan directory recursively
+        scan_directory(templates_dir_);
+    }
 
     LOG_INFO("Loaded " + std::to_string(templates_.size()) + " templates");
     initialized_ = true;
@@ -209,16 +371,46 @@ Result<Template> TemplateManager::get_template(const std::string& name) const {
         return Error(ErrorCode::TemplateNotFound, "Template not found: " + name);
     }
 
-    return it->second;
+    // The scan kept only metadata; the structure is read on first use
+    Template tmpl = it->second;
+    std::shared_ptr<const nlohmann::json> structure;
+    {
+        std::lock_guard<std::mutex> lock(structures_->mutex);
+        auto cached = structures_->loaded.find(name);
+        if (cached != structures_->loaded.end()) {
+            structure = cached->second;
+        }
+    }
+
+    if (!structure) {
+        // Parsed outside the lock; a thread that loses a race for the same
+        // template adopts the winner's copy
+        std::shared_ptr<const nlohmann::json> parsed;
+        if (const size_t* index = structures_->find_packed(name)) {
+            parsed = std::make_shared<const nlohmann::json>(structures_->pack->structure_json(*index));
+        } else {
+            auto loaded = Template::load_from_file(tmpl.source_path);
+            if (loaded.is_error()) {
+                return loaded.error();
+            }
+            parsed = std::make_shared<const nlohmann::json>(std::move(loaded.value().structure));
+        }
+
+        std::lock_guard<std::mutex> lock(structures_->mutex);
+        structure = structures_->loaded.emplace(name, std::move(parsed)).first->second;
+    }
+
+    tmpl.structure = *structure;
+    return tmpl;
 }
 
 Result<TemplateInfo> TemplateManager::get_template_info(const std::string& name) const {
-    auto result = get_template(name);
-    if (result.is_error()) {
-        return result.error();
+    auto it = templates_.find(name);
+    if (it == templates_.end()) {
+        return Error(ErrorCode::TemplateNotFound, "Template not found: " + name);
     }
 
-    return result.value().info;
+    return it->second.info;
 }
 
 bool TemplateManager::has_template(const std::string& name) const {
@@ -233,6 +425,14 @@ Result<GenerationStats> TemplateManager::generate_from_template(
 ) {
     LOG_INFO("Generating project from template: " + template_name);
 
+    // Packed templates were validated when compiled and convert straight
+    // from the mapped pack
+    TemplateGenerator generator;
+    if (const size_t* index = structures_->find_packed(template_name)) {
+        auto tree = structures_->pack->structure(*index, options.project_name);
+        return generator.generate_from_store(tree, options);
+    }
+
     // Get template
     auto tmpl_result = get_template(template_name);
     if (tmpl_result.is_error()) {
@@ -248,7 +448,6 @@ Result<GenerationStats> TemplateManager::generate_from_template(
     }
 
     // Generate using TemplateGenerator
-    TemplateGenerator generator;
     return generator.generate_from_json(tmpl.structure, options);
 }
 
@@ -266,8 +465,9 @@ Result<void> TemplateManager::validate_template(const Template& tmpl) const {
 }
 
 Result<void> TemplateManager::validate_all_templates() {
-    for (const auto& [name, tmpl] : templates_) {
-        auto result = validate_template(tmpl);
+    for (const auto& [name, _] : templates_) {
+        auto tmpl = get_template(name);
+        auto result = tmpl.is_ok() ? validate_template(tmpl.value()) : Result<void>(tmpl.error());
         if (result.is_error()) {
             LOG_ERROR("Template validation failed: " + name);
             return result;
@@ -300,29 +500,83 @@ std::filesystem::path TemplateManager::get_default_templates_directory() {
 Result<Template> TemplateManager::load_template_file(const std::filesystem::path& file_path) {
     LOG_DEBUG("Loading template: " + file_path.string());
 
-    auto result = Template::load_from_file(file_path);
-    if (result.is_error()) {
+    // Metadata only; get_template() reads the structure
+    auto info = TemplateInfo::read_from_file(file_path);
+    if (info.is_error()) {
         LOG_ERROR("Failed to load template: " + file_path.string());
-        return result;
+        return info.error();
     }
 
-    return result;
+    Template tmpl;
+    tmpl.info = std::move(info.value());
+    tmpl.source_path = file_path;
+    return tmpl;
 }
 
 void TemplateManager::scan_directory(const std::filesystem::path& dir) {
-    try {
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".json") {
-                auto result = load_template_file(entry.path());
-                if (result.is_ok()) {
-                    const auto& tmpl = result.value();
-                    templates_[tmpl.info.name] = std::move(result.value());
-                    LOG_DEBUG("Loaded template: " + tmpl.info.name);
-                }
+    struct Found {
+        std::filesystem::path path;
+        std::string key;  // path below dir, as TemplatePack orders sources
+        Result<Template> result;
+    };
+
+    // Each directory listing and each file is a task. Workers append to
+    // their own list, so nothing is shared until the merge below.
+    WorkStealingPool pool(WorkStealingPool::resolve_thread_count(0));
+    std::vector<std::vector<Found>> found(pool.size() + 1);
+
+    std::function<void(const std::filesystem::path&)> list = [&](const std::filesystem::path& directory) {
+        std::error_code ec;
+        std::filesystem::directory_iterator it(directory, ec), end;
+        for (; !ec && it != end; it.increment(ec)) {
+            const auto& entry = *it;
+            std::error_code status_ec;
+
+            // Like recursive_directory_iterator, symlinked directories are
+            // not descended into
+            if (entry.is_directory(status_ec) && !entry.is_symlink(status_ec)) {
+                pool.submit([&list, path = entry.path()] { list(path); });
+            } else if (entry.path().extension() == ".json" && entry.is_regular_file(status_ec)) {
+                pool.submit([&, path = entry.path()] {
+                    auto result = load_template_file(path);
+                    auto key = path.lexically_relative(dir).generic_string();
+                    found[pool.current_worker()].push_back(Found{path, std::move(key), std::move(result)});
+                });
             }
         }
-    } catch (const std::filesystem::filesystem_error& e) {
-        LOG_ERROR(std::string("Error scanning directory: ") + e.what());
+        if (ec) {
+            LOG_ERROR("Error scanning directory: " + directory.string() + ": " + ec.message());
+        }
+    };
+
+    pool.submit([&] { list(dir); });
+    pool.wait();
+
+    // Merged in order of relative path, the order TemplatePack::compile
+    // uses, so the same tree always yields the same templates with or
+    // without a pack; a name already taken is reported and the later file
+    // ignored
+    std::vector<Found*> merged;
+    for (auto& worker : found) {
+        for (auto& item : worker) {
+            merged.push_back(&item);
+        }
+    }
+    std::sort(merged.begin(), merged.end(), [](const Found* a, const Found* b) { return a->key < b->key; });
+
+    for (Found* item : merged) {
+        if (item->result.is_error()) {
+            continue;
+        }
+        auto& tmpl = item->result.value();
+        std::string name = tmpl.info.name;
+        auto [it, added] = templates_.try_emplace(name, std::move(tmpl));
+        if (added) {
+            LOG_DEBUG("Loaded template: " + name);
+        } else {
+            LOG_WARN("Duplicate template name '" + name + "': ignoring " + item->path.string() +
+                     ", already defined by " + it->second.source_path.string());
+        }
     }
 }
 
@@ -331,20 +585,10 @@ bool TemplateManager::validate_structure_recursive(const nlohmann::json& structu
         return false;
     }
 
-    for (auto it = structure.begin(); it != structure.end(); ++it) {
-        const auto& value = it.value();
-
-        // Value can be empty string (file), string (file with content), or object (directory)
-        if (value.is_object()) {
-            if (!validate_structure_recursive(value)) {
-                return false;
-            }
-        } else if (!value.is_string()) {
-            return false;
-        }
-    }
-
-    return true;
+    // Value can be empty string (file), string (file with content), or object (directory)
+    return walk_tree(JsonTree{}, JsonTree::Node{{}, &structure}, [](const JsonTree::Node& entry, size_t) {
+        return entry.value->is_object() || entry.value->is_string() ? WalkAction::Continue : WalkAction::Stop;
+    });
 }
 
 // TemplateDisplay implementation
@@ -0,0 +1,460 @@
+#include "yaqeen/core/template_pack.hpp"
+#include "yaqeen/core/staging.hpp"
+#include "yaqeen/core/tree_walk.hpp"
+#include "yaqeen/utils/logger.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <set>
+
+namespace yaqeen::core {
+
+namespace {
+    // On-disk layout, in host byte order: a Header, then the tables it
+    // points to, each 8-byte aligned, then the blob every Text points into
+    constexpr char kMagic[8] = {'Y', 'Q', 'N', 'P', 'A', 'C', 'K', '\0'};
+    constexpr uint32_t kByteOrder = 0x01020304;
+    constexpr uint32_t kNoParent = std::numeric_limits<uint32_t>::max();
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t source_count;
+        uint32_t template_count;
+        uint32_t name_count;
+        uint32_t tag_count;
+        uint64_t node_count;
+        uint64_t sources;
+        uint64_t templates;
+        uint64_t names;
+        uint64_t tags;
+        uint64_t nodes;
+        uint64_t blob;
+        uint64_t size;  // of the whole pack
+    };
+
+    // A string in the blob
+    struct Text {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    // A template file, for staleness checks
+    struct Source {
+        Text path;  // relative to the templates directory, '/'-separated
+        uint64_t size;
+        int64_t mtime;
+    };
+
+    struct Record {
+        // NoStructure: the header read but the structure did not validate;
+        // the name is taken and using the template reads its JSON file
+        enum Flags : uint32_t { HasAuthor = 1, HasRepository = 2, NoStructure = 4 };
+
+        Text name;
+        Text description;
+        Text version;
+        Text category;
+        Text author;
+        Text repository;
+        uint32_t flags;
+        uint32_t source;
+        uint32_t first_tag;
+        uint32_t tag_count;
+        uint64_t first_node;
+        uint64_t node_count;
+    };
+
+    // Nodes below a template's root in pre-order; parent indexes the
+    // template's own nodes, kNoParent for children of the root
+    struct PackNode {
+        uint32_t name;
+        uint32_t parent;
+        uint32_t is_directory;
+        uint32_t reserved;
+        Text content;
+    };
+
+    template <typename T>
+    T load(std::string_view data, uint64_t offset) {
+        T value;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    T load(std::string_view data, uint64_t table, uint64_t index) {
+        return load<T>(data, table + index * sizeof(T));
+    }
+
+    // Out-of-range texts read as empty rather than past the map
+    std::string_view text(std::string_view data, const Header& header, const Text& ref) {
+        uint64_t blob_size = header.size - header.blob;
+        if (ref.offset > blob_size || ref.size > blob_size - ref.offset) {
+            return {};
+        }
+        return data.substr(header.blob + ref.offset, ref.size);
+    }
+
+    bool table_fits(const Header& header, uint64_t offset, uint64_t count, size_t record) {
+        return offset <= header.size && count <= (header.size - offset) / record;
+    }
+
+    struct SourceFile {
+        std::string path;
+        uint64_t size = 0;
+        int64_t mtime = 0;
+    };
+
+    // Every template file under dir, in order of relative path
+    Result<std::vector<SourceFile>> list_sources(const std::filesystem::path& dir) {
+        std::vector<SourceFile> sources;
+        std::error_code ec;
+        std::filesystem::recursive_directory_iterator it(dir, ec), end;
+        for (; !ec && it != end; it.increment(ec)) {
+            const auto& entry = *it;
+            if (entry.path().extension() != ".json" || !entry.is_regular_file(ec)) {
+                continue;
+            }
+
+            SourceFile source;
+            source.path = entry.path().lexically_relative(dir).generic_string();
+            source.size = entry.file_size(ec);
+            source.mtime = static_cast<int64_t>(entry.last_write_time(ec).time_since_epoch().count());
+            if (ec) {
+                break;
+            }
+            sources.push_back(std::move(source));
+        }
+        if (ec) {
+            return Error(ErrorCode::DirectoryNotFound,
+                        "Cannot scan templates directory: " + dir.string(),
+                        ec.message());
+        }
+
+        std::sort(sources.begin(), sources.end(),
+                  [](const SourceFile& a, const SourceFile& b) { return a.path < b.path; });
+        return sources;
+    }
+
+    size_t align(size_t offset) {
+        return (offset + 7) & ~size_t(7);
+    }
+
+    template <typename T>
+    void store_table(std::string& out, uint64_t offset, const std::vector<T>& table) {
+        if (!table.empty()) {
+            std::memcpy(&out[offset], table.data(), table.size() * sizeof(T));
+        }
+    }
+}
+
+std::filesystem::path TemplatePack::default_path(const std::filesystem::path& templates_dir) {
+    return templates_dir / kFileName;
+}
+
+Result<TemplatePack::CompileSummary> TemplatePack::compile(
+    const std::filesystem::path& templates_dir,
+    const std::filesystem::path& pack_path
+) {
+    auto listed = list_sources(templates_dir);
+    if (listed.is_error()) {
+        return listed.error();
+    }
+    const auto& files = listed.value();
+
+    std::string blob;
+    auto add_text = [&blob](std::string_view value) {
+        Text ref{blob.size(), value.size()};
+        blob.append(value);
+        return ref;
+    };
+
+    std::vector<Source> sources;
+    std::vector<Record> records;
+    std::vector<Text> tags;
+    std::vector<PackNode> nodes;
+    std::set<std::string> taken;
+    auto names = std::make_shared<NamePool>();
+    TemplateManager validator(templates_dir);
+    CompileSummary summary;
+
+    for (const auto& file : files) {
+        auto source = static_cast<uint32_t>(sources.size());
+        sources.push_back(Source{add_text(file.path), file.size, file.mtime});
+
+        // Names are claimed by header alone, exactly as a scan claims them
+        auto path = templates_dir / file.path;
+        auto read = TemplateInfo::read_from_file(path);
+        if (read.is_error()) {
+            LOG_WARN("Not packing template: " + file.path);
+            summary.skipped++;
+            continue;
+        }
+        const TemplateInfo& info = read.value();
+        if (!taken.insert(info.name).second) {
+            LOG_WARN("Not packing template: " + file.path + ": duplicate template name '" + info.name + "'");
+            summary.skipped++;
+            continue;
+        }
+
+        Record record{};
+        record.name = add_text(info.name);
+        record.description = add_text(info.description);
+        record.version = add_text(info.version);
+        record.category = add_text(info.category);
+        if (info.author) {
+            record.flags |= Record::HasAuthor;
+            record.author = add_text(*info.author);
+        }
+        if (info.repository) {
+            record.flags |= Record::HasRepository;
+            record.repository = add_text(*info.repository);
+        }
+        record.source = source;
+        record.first_tag = static_cast<uint32_t>(tags.size());
+        record.tag_count = static_cast<uint32_t>(info.tags.size());
+        for (const auto& tag : info.tags) {
+            tags.push_back(add_text(tag));
+        }
+        record.first_node = nodes.size();
+
+        // A structure that does not validate is left for generation to
+        // report, as it would be without the pack
+        auto loaded = Template::load_from_file(path);
+        std::optional<Result<NodeStore>> converted;
+        if (loaded.is_ok() && validator.validate_template(loaded.value()).is_ok()) {
+            converted = TemplateGenerator::json_to_store(loaded.value().structure, "", names);
+        }
+        if (!converted || converted->is_error()) {
+            LOG_WARN("Packing metadata only, the structure is invalid: " + file.path);
+            record.flags |= Record::NoStructure;
+            summary.invalid++;
+            records.push_back(record);
+            continue;
+        }
+        const NodeStore& tree = converted->value();
+
+        // Flatten in pre-order, so that a store rebuilt by appending the
+        // nodes in turn gets them back as ids 1, 2, ...
+        std::vector<uint32_t> position(tree.size(), kNoParent);
+        walk_tree(StoreTree{tree}, tree.root(), [&](NodeId node, size_t depth) {
+            if (depth == 0) {
+                return WalkAction::Continue;
+            }
+            position[node] = static_cast<uint32_t>(nodes.size() - record.first_node);
+
+            PackNode packed{};
+            packed.name = tree.name_id(node);
+            packed.parent = position[tree.parent(node)];
+            packed.is_directory = tree.is_directory(node);
+            packed.content = add_text(tree.content(node));
+            nodes.push_back(packed);
+            return WalkAction::Continue;
+        });
+        record.node_count = nodes.size() - record.first_node;
+        records.push_back(record);
+    }
+
+    std::vector<Text> name_table;
+    name_table.reserve(names->size());
+    for (NameId id = 0; id < names->size(); ++id) {
+        name_table.push_back(add_text(names->str(id)));
+    }
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order = kByteOrder;
+    header.source_count = static_cast<uint32_t>(sources.size());
+    header.template_count = static_cast<uint32_t>(records.size());
+    header.name_count = static_cast<uint32_t>(name_table.size());
+    header.tag_count = static_cast<uint32_t>(tags.size());
+    header.node_count = nodes.size();
+    header.sources = align(sizeof(Header));
+    header.templates = align(header.sources + sources.size() * sizeof(Source));
+    header.names = align(header.templates + records.size() * sizeof(Record));
+    header.tags = align(header.names + name_table.size() * sizeof(Text));
+    header.nodes = align(header.tags + tags.size() * sizeof(Text));
+    header.blob = align(header.nodes + nodes.size() * sizeof(PackNode));
+    header.size = header.blob + blob.size();
+
+    std::string out(header.size, '\0');
+    std::memcpy(&out[0], &header, sizeof(Header));
+    store_table(out, header.sources, sources);
+    store_table(out, header.templates, records);
+    store_table(out, header.names, name_table);
+    store_table(out, header.tags, tags);
+    store_table(out, header.nodes, nodes);
+    std::memcpy(&out[header.blob], blob.data(), blob.size());
+
+    auto written = write_file_atomically(pack_path, out, true);
+    if (written.is_error()) {
+        return written.error();
+    }
+
+    summary.templates = records.size();
+    summary.bytes = out.size();
+    return summary;
+}
+
+Result<TemplatePack> TemplatePack::open(
+    const std::filesystem::path& templates_dir,
+    const std::filesystem::path& pack_path
+) {
+    auto mapped = MappedFile::open(pack_path);
+    if (mapped.is_error()) {
+        return mapped.error();
+    }
+
+    TemplatePack pack;
+    pack.file_ = std::make_shared<const MappedFile>(std::move(mapped.value()));
+    pack.templates_dir_ = templates_dir;
+    std::string_view data = pack.file_->view();
+
+    auto invalid = [&pack_path](const std::string& why) {
+        return Error(ErrorCode::InvalidInput, "Template pack not usable: " + pack_path.string(), why);
+    };
+
+    if (data.size() < sizeof(Header)) {
+        return invalid("truncated");
+    }
+    auto header = load<Header>(data, 0);
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.byte_order != kByteOrder) {
+        return invalid("not a template pack for this machine");
+    }
+    if (header.version != kVersion) {
+        return invalid("format version " + std::to_string(header.version));
+    }
+    if (header.size != data.size() || header.blob > header.size ||
+        !table_fits(header, header.sources, header.source_count, sizeof(Source)) ||
+        !table_fits(header, header.templates, header.template_count, sizeof(Record)) ||
+        !table_fits(header, header.names, header.name_count, sizeof(Text)) ||
+        !table_fits(header, header.tags, header.tag_count, sizeof(Text)) ||
+        !table_fits(header, header.nodes, header.node_count, sizeof(PackNode))) {
+        return invalid("corrupt");
+    }
+
+    // Stale if any template file was added, removed or touched since
+    auto listed = list_sources(templates_dir);
+    if (listed.is_error()) {
+        return listed.error();
+    }
+    const auto& files = listed.value();
+    if (files.size() != header.source_count) {
+        return invalid("templates added or removed");
+    }
+    for (size_t i = 0; i < files.size(); ++i) {
+        auto source = load<Source>(data, header.sources, i);
+        if (text(data, header, source.path) != files[i].path ||
+            source.size != files[i].size || source.mtime != files[i].mtime) {
+            return invalid("changed: " + files[i].path);
+        }
+    }
+
+    // Records must stay inside the tables they index
+    for (size_t i = 0; i < header.template_count; ++i) {
+        auto record = load<Record>(data, header.templates, i);
+        if (record.source >= header.source_count ||
+            record.first_tag > header.tag_count || record.tag_count > header.tag_count - record.first_tag ||
+            record.first_node > header.node_count || record.node_count > header.node_count - record.first_node) {
+            return invalid("corrupt");
+        }
+    }
+
+    pack.templates_ = header.template_count;
+    return pack;
+}
+
+TemplateInfo TemplatePack::info(size_t index) const {
+    std::string_view data = file_->view();
+    auto header = load<Header>(data, 0);
+    auto record = load<Record>(data, header.templates, index);
+
+    TemplateInfo info;
+    info.name = text(data, header, record.name);
+    info.description = text(data, header, record.description);
+    info.version = text(data, header, record.version);
+    info.category = text(data, header, record.category);
+    info.tags.reserve(record.tag_count);
+    for (uint32_t i = 0; i < record.tag_count; ++i) {
+        info.tags.emplace_back(text(data, header, load<Text>(data, header.tags, record.first_tag + i)));
+    }
+    if (record.flags & Record::HasAuthor) {
+        info.author = std::string(text(data, header, record.author));
+    }
+    if (record.flags & Record::HasRepository) {
+        info.repository = std::string(text(data, header, record.repository));
+    }
+    return info;
+}
+
+bool TemplatePack::has_structure(size_t index) const {
+    std::string_view data = file_->view();
+    auto header = load<Header>(data, 0);
+    return (load<Record>(data, header.templates, index).flags & Record::NoStructure) == 0;
+}
+
+std::filesystem::path TemplatePack::source_path(size_t index) const {
+    std::string_view data = file_->view();
+    auto header = load<Header>(data, 0);
+    auto record = load<Record>(data, header.templates, index);
+    auto source = load<Source>(data, header.sources, record.source);
+    return templates_dir_ / std::filesystem::path(std::string(text(data, header, source.path)));
+}
+
+NodeStore TemplatePack::structure(size_t index, const std::string& root_name,
+                                  std::shared_ptr<NamePool> names) const {
+    std::string_view data = file_->view();
+    auto header = load<Header>(data, 0);
+    auto record = load<Record>(data, header.templates, index);
+
+    NodeStore tree(std::move(names));
+    tree.set_source(file_);
+    tree.add_root(root_name);
+    for (uint64_t i = 0; i < record.node_count; ++i) {
+        auto node = load<PackNode>(data, header.nodes, record.first_node + i);
+        auto name = node.name < header.name_count
+            ? text(data, header, load<Text>(data, header.names, node.name))
+            : std::string_view();
+
+        // Parents precede children; anything else is a corrupt pack, and
+        // the node goes to the root rather than out of bounds
+        NodeId parent = node.parent < i ? static_cast<NodeId>(node.parent + 1) : tree.root();
+        NodeId id = tree.add_child(parent, name, node.is_directory != 0);
+        if (!node.is_directory && node.content.size != 0) {
+            tree.set_source_content(id, text(data, header, node.content));
+        }
+    }
+    return tree;
+}
+
+nlohmann::json TemplatePack::structure_json(size_t index) const {
+    std::string_view data = file_->view();
+    auto header = load<Header>(data, 0);
+    auto record = load<Record>(data, header.templates, index);
+
+    // Object members keep their address as siblings are added
+    nlohmann::json root = nlohmann::json::object();
+    std::vector<nlohmann::json*> objects(record.node_count, nullptr);
+    for (uint64_t i = 0; i < record.node_count; ++i) {
+        auto node = load<PackNode>(data, header.nodes, record.first_node + i);
+        std::string name(node.name < header.name_count
+            ? text(data, header, load<Text>(data, header.names, node.name))
+            : std::string_view());
+
+        nlohmann::json* parent = node.parent < i && objects[node.parent] ? objects[node.parent] : &root;
+        auto& value = (*parent)[name];
+        if (node.is_directory) {
+            value = nlohmann::json::object();
+            objects[i] = &value;
+        } else {
+            value = std::string(text(data, header, node.content));
+        }
+    }
+    return root;
+}
+
+} // namespace yaqeen::core
@@ -0,0 +1,128 @@
+#include "yaqeen/core/thread_pool.hpp"
+#include <algorithm>
+
+namespace yaqeen::core {
+
+namespace {
+    // Identifies the pool and slot of the current thread, if it is a worker
+    thread_local const WorkStealingPool* tls_pool = nullptr;
+    thread_local size_t tls_index = 0;
+}
+
+WorkStealingPool::WorkStealingPool(size_t thread_count) {
+    thread_count = std::max<size_t>(thread_count, 1);
+
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back([this, i] { run(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+
+    // Workers push onto their own deque; outside callers spread round-robin
+    size_t target = current_worker();
+    if (target == workers_.size()) {
+        target = next_queue_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workers_[target]->mutex);
+        workers_[target]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        queued_.fetch_add(1, std::memory_order_relaxed);
+    }
+    work_available_.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    all_done_.wait(lock, [this] { return pending_.load() == 0; });
+}
+
+size_t WorkStealingPool::current_worker() const {
+    return tls_pool == this ? tls_index : workers_.size();
+}
+
+size_t WorkStealingPool::resolve_thread_count(size_t requested) {
+    if (requested == 0) {
+        return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    return requested;
+}
+
+void WorkStealingPool::run(size_t index) {
+    tls_pool = this;
+    tls_index = index;
+
+    while (true) {
+        Task task;
+        if (try_pop(index, task) || try_steal(index, task)) {
+            task();
+
+            if (pending_.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(state_mutex_);
+                all_done_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(state_mutex_);
+        work_available_.wait(lock, [this] { return stopping_ || queued_.load() > 0; });
+        if (stopping_ && queued_.load() == 0) {
+            return;
+        }
+    }
+}
+
+bool WorkStealingPool::try_pop(size_t index, Task& task) {
+    auto& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool WorkStealingPool::try_steal(size_t thief, Task& task) {
+    for (size_t offset = 1; offset < workers_.size(); ++offset) {
+        auto& victim = *workers_[(thief + offset) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) {
+            continue;
+        }
+
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+} // namespace yaqeen::core
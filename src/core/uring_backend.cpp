@@ -0,0 +1,522 @@
+#include "yaqeen/core/uring_backend.hpp"
+#include "yaqeen/utils/hash.hpp"
+
+#if YAQEEN_HAS_IO_URING
+
+#include <linux/io_uring.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+namespace yaqeen::core {
+
+namespace {
+    // Operation tag stored in the low bits of user_data; the entry index is above it
+    enum Op : uint64_t {
+        OpMkdir = 0,
+        OpOpen = 1,
+        OpWrite = 2,
+        OpClose = 3,
+        OpUnlink = 4
+    };
+
+    constexpr uint64_t kOpBits = 3;
+
+    uint64_t make_user_data(size_t index, Op op) {
+        return (static_cast<uint64_t>(index) << kOpBits) | op;
+    }
+
+    int sys_setup(unsigned entries, io_uring_params* params) {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int sys_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    int sys_register(int fd, unsigned opcode, const void* arg, unsigned nr_args) {
+        return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+    }
+
+    std::string join_path(std::string_view parent, const std::string& name) {
+        PathBuffer path{std::string(parent)};
+        path.push(name);
+        return path.str();
+    }
+}
+
+// Minimal single-producer io_uring wrapper: mapped SQ/CQ rings plus a table of
+// direct descriptors, one per file that can be in flight in a single round.
+class IoUringBackend::Ring {
+public:
+    static std::unique_ptr<Ring> open(unsigned depth) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+
+        int fd = sys_setup(depth, &params);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+        std::unique_ptr<Ring> ring(new Ring());
+        ring->fd_ = fd;
+
+        if (!ring->map(params) || !ring->supports_required_ops() || !ring->register_slots()) {
+            return nullptr;
+        }
+
+        return ring;
+    }
+
+    ~Ring() {
+        if (sqes_ != MAP_FAILED) {
+            ::munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+            ::munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_ != MAP_FAILED) {
+            ::munmap(sq_ring_, sq_ring_size_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    unsigned capacity() const { return sq_entries_; }
+
+    // Returns a zeroed SQE, or nullptr when the submission queue is full
+    io_uring_sqe* next_sqe() {
+        unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        unsigned tail = *sq_tail_ + queued_;
+        if (tail - head >= sq_entries_) {
+            return nullptr;
+        }
+
+        unsigned index = tail & *sq_mask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_array_[index] = index;
+        queued_++;
+        return sqe;
+    }
+
+    // Submit everything queued and wait for `expected` completions, handing
+    // each one to fn(user_data, res). Returns false if the kernel refused.
+    template <typename Fn>
+    bool submit_and_reap(unsigned expected, Fn&& fn) {
+        __atomic_store_n(sq_tail_, *sq_tail_ + queued_, __ATOMIC_RELEASE);
+        unsigned to_submit = queued_;
+        queued_ = 0;
+
+        unsigned reaped = 0;
+        while (reaped < expected) {
+            int ret = sys_enter(fd_, to_submit, 1, IORING_ENTER_GETEVENTS);
+            enter_calls_++;
+            if (ret < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                    continue;
+                }
+                return false;
+            }
+            to_submit -= std::min<unsigned>(to_submit, static_cast<unsigned>(ret));
+
+            unsigned head = *cq_head_;
+            unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            while (head != tail) {
+                const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+                fn(cqe.user_data, cqe.res);
+                ++head;
+                ++reaped;
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        }
+
+        return true;
+    }
+
+    // io_uring_enter calls made since the last call
+    size_t take_enter_calls() {
+        return std::exchange(enter_calls_, 0);
+    }
+
+private:
+    Ring() = default;
+
+    bool map(const io_uring_params& params) {
+        sq_entries_ = params.sq_entries;
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {
+            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        }
+
+        sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) {
+            return false;
+        }
+
+        if (single_mmap) {
+            cq_ring_ = sq_ring_;
+        } else {
+            cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+            if (cq_ring_ == MAP_FAILED) {
+                return false;
+            }
+        }
+
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        auto* sq = static_cast<char*>(sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        auto* cq = static_cast<char*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        return true;
+    }
+
+    // mkdirat (and with it direct openat/close) needs Linux 5.15
+    bool supports_required_ops() const {
+        constexpr unsigned kProbeOps = 256;
+        std::vector<char> buffer(sizeof(io_uring_probe) + kProbeOps * sizeof(io_uring_probe_op), 0);
+        auto* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+
+        if (sys_register(fd_, IORING_REGISTER_PROBE, probe, kProbeOps) < 0) {
+            return false;
+        }
+
+        for (unsigned op : {IORING_OP_MKDIRAT, IORING_OP_OPENAT, IORING_OP_WRITE, IORING_OP_CLOSE,
+                            IORING_OP_UNLINKAT}) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // One empty direct-descriptor slot per SQE
+    bool register_slots() {
+        std::vector<int> slots(sq_entries_, -1);
+        return sys_register(fd_, IORING_REGISTER_FILES, slots.data(), sq_entries_) == 0;
+    }
+
+    int fd_ = -1;
+    unsigned sq_entries_ = 0;
+    unsigned queued_ = 0;
+
+    void* sq_ring_ = MAP_FAILED;
+    void* cq_ring_ = MAP_FAILED;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqes_size_ = 0;
+    size_t enter_calls_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_mask_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned* cq_mask_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+// IoUringBackend implementation
+std::unique_ptr<IoUringBackend> IoUringBackend::create(const BackendOptions& options) {
+    auto ring = Ring::open(std::max(options.queue_depth, 4u));
+    if (!ring) {
+        return nullptr;
+    }
+    return std::unique_ptr<IoUringBackend>(new IoUringBackend(options, std::move(ring)));
+}
+
+IoUringBackend::IoUringBackend(const BackendOptions& options, std::unique_ptr<Ring> ring)
+    : PosixBackend(options)
+    , options_(options) {
+    idle_rings_.push_back(std::move(ring));
+}
+
+IoUringBackend::~IoUringBackend() = default;
+
+BackendCounters IoUringBackend::counters() const {
+    BackendCounters counters = PosixBackend::counters();
+    counters.sqes_submitted = sqes_submitted_.load();
+    counters.cqes_completed = cqes_completed_.load();
+    return counters;
+}
+
+std::unique_ptr<IoUringBackend::Ring> IoUringBackend::acquire_ring() {
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        if (!idle_rings_.empty()) {
+            auto ring = std::move(idle_rings_.back());
+            idle_rings_.pop_back();
+            return ring;
+        }
+    }
+    return Ring::open(std::max(options_.queue_depth, 4u));
+}
+
+void IoUringBackend::release_ring(std::unique_ptr<Ring> ring) {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    idle_rings_.push_back(std::move(ring));
+}
+
+Result<void> IoUringBackend::create_entries(
+    DirHandle parent,
+    std::vector<CreateRequest>& entries,
+    std::string_view parent_path
+) {
+    auto ring = acquire_ring();
+    if (!ring) {
+        return PosixBackend::create_entries(parent, entries, parent_path);
+    }
+
+    // Overwriting unlinks first and still creates exclusively: truncating in
+    // place would write through every hard link to the old file
+    const int open_flags = O_WRONLY | O_CREAT | O_EXCL;
+    const bool replace = options_.overwrite;
+
+    // Entries the batch could not settle, finished synchronously afterwards
+    std::vector<size_t> existing_dirs;
+    std::vector<size_t> rewrites;
+    std::optional<Error> error;
+    bool ring_usable = true;
+
+    // With dedup, repeated contents are held back from the batch and made
+    // from their first copy once it has been written
+    std::vector<bool> held_back;
+    std::vector<size_t> duplicates;
+    std::vector<size_t> first_copies;
+    std::unordered_map<uint64_t, std::vector<size_t>> batch_contents;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        auto& entry = entries[i];
+        if (entry.is_directory || !dedup_candidate(entry.content)) {
+            continue;
+        }
+        if (held_back.empty()) {
+            held_back.assign(entries.size(), false);
+        }
+
+        bool repeated = has_source(entry.content);
+        auto& candidates = batch_contents[Hash::fnv1a(entry.content)];
+        for (size_t j = 0; j < candidates.size() && !repeated; ++j) {
+            repeated = entries[candidates[j]].content == entry.content;
+        }
+
+        if (repeated) {
+            held_back[i] = true;
+            duplicates.push_back(i);
+        } else {
+            candidates.push_back(i);
+            first_copies.push_back(i);
+        }
+    }
+
+    size_t next = 0;
+    while (next < entries.size() && !error) {
+        unsigned queued = 0;
+        unsigned slot = 0;
+
+        // Queue whole chains until the ring or the descriptor table is full
+        while (next < entries.size()) {
+            if (!held_back.empty() && held_back[next]) {
+                next++;
+                continue;
+            }
+
+            auto& entry = entries[next];
+            unsigned needed = entry.is_directory ? 1 : (entry.content.empty() ? 2 : 3) + (replace ? 1 : 0);
+            if (queued + needed > ring->capacity() || (!entry.is_directory && slot == ring->capacity())) {
+                break;
+            }
+
+            if (entry.is_directory) {
+                io_uring_sqe* sqe = ring->next_sqe();
+                sqe->opcode = IORING_OP_MKDIRAT;
+                sqe->fd = parent;
+                sqe->addr = reinterpret_cast<uint64_t>(entry.name->c_str());
+                sqe->len = 0777;
+                sqe->user_data = make_user_data(next, OpMkdir);
+            } else {
+                if (replace) {
+                    // Hard link: a missing file is no reason to skip the open
+                    io_uring_sqe* unlink_sqe = ring->next_sqe();
+                    unlink_sqe->opcode = IORING_OP_UNLINKAT;
+                    unlink_sqe->fd = parent;
+                    unlink_sqe->addr = reinterpret_cast<uint64_t>(entry.name->c_str());
+                    unlink_sqe->unlink_flags = 0;
+                    unlink_sqe->flags = IOSQE_IO_HARDLINK;
+                    unlink_sqe->user_data = make_user_data(next, OpUnlink);
+                }
+
+                io_uring_sqe* open_sqe = ring->next_sqe();
+                open_sqe->opcode = IORING_OP_OPENAT;
+                open_sqe->fd = parent;
+                open_sqe->addr = reinterpret_cast<uint64_t>(entry.name->c_str());
+                open_sqe->len = 0666;
+                open_sqe->open_flags = static_cast<uint32_t>(open_flags);
+                open_sqe->file_index = slot + 1;
+                open_sqe->flags = IOSQE_IO_LINK;
+                open_sqe->user_data = make_user_data(next, OpOpen);
+
+                if (!entry.content.empty()) {
+                    // Hard link so the close still runs after a short write
+                    io_uring_sqe* write_sqe = ring->next_sqe();
+                    write_sqe->opcode = IORING_OP_WRITE;
+                    write_sqe->fd = static_cast<int>(slot);
+                    write_sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+                    write_sqe->addr = reinterpret_cast<uint64_t>(entry.content.data());
+                    write_sqe->len = static_cast<uint32_t>(entry.content.size());
+                    write_sqe->off = 0;
+                    write_sqe->user_data = make_user_data(next, OpWrite);
+                }
+
+                io_uring_sqe* close_sqe = ring->next_sqe();
+                close_sqe->opcode = IORING_OP_CLOSE;
+                close_sqe->file_index = slot + 1;
+                close_sqe->user_data = make_user_data(next, OpClose);
+
+                slot++;
+            }
+
+            queued += needed;
+            next++;
+        }
+
+        bool submitted = ring->submit_and_reap(queued, [&](uint64_t user_data, int res) {
+            size_t index = static_cast<size_t>(user_data >> kOpBits);
+            auto& entry = entries[index];
+
+            switch (static_cast<Op>(user_data & ((1u << kOpBits) - 1))) {
+                case OpMkdir:
+                    if (res == -EEXIST) {
+                        existing_dirs.push_back(index);
+                    } else if (res < 0 && !error) {
+                        error = Error(ErrorCode::CannotCreateDirectory,
+                                     "Cannot create directory: " + join_path(parent_path, *entry.name),
+                                     std::strerror(-res));
+                    }
+                    break;
+
+                case OpOpen:
+                    if (res >= 0) {
+                        entry.bytes_written = entry.content.size();
+                    } else if (res == -EEXIST && replace) {
+                        // Recreated between the unlink and the open, or not
+                        // unlinkable; the synchronous path reports why
+                        rewrites.push_back(index);
+                    } else if (res == -EEXIST) {
+                        entry.existed = true;
+                    } else if (!error) {
+                        error = Error(ErrorCode::CannotCreateFile,
+                                     "Cannot create file: " + join_path(parent_path, *entry.name),
+                                     std::strerror(-res));
+                    }
+                    break;
+
+                case OpWrite:
+                    // Cancelled writes belong to failed opens, which are handled above
+                    if (res != -ECANCELED && res != static_cast<int>(entry.content.size())) {
+                        rewrites.push_back(index);
+                    }
+                    break;
+
+                case OpUnlink:
+                    // Nothing there yet is the common case; anything else
+                    // surfaces as EEXIST from the open
+                case OpClose:
+                    break;
+            }
+        });
+
+        sqes_submitted_ += queued;
+        cqes_completed_ += queued;
+        count_syscalls(ring->take_enter_calls());
+
+        if (!submitted) {
+            // The ring may still hold unsubmitted entries; never reuse it
+            ring_usable = false;
+            if (!error) {
+                error = Error(ErrorCode::CannotCreateFile,
+                             "io_uring submission failed in: " + std::string(parent_path),
+                             std::strerror(errno));
+            }
+        }
+    }
+
+    if (ring_usable) {
+        release_ring(std::move(ring));
+    }
+
+    if (error) {
+        return *error;
+    }
+
+    for (size_t index : existing_dirs) {
+        auto& entry = entries[index];
+        auto result = check_existing_directory(parent, *entry.name, join_path(parent_path, *entry.name));
+        if (result.is_error()) {
+            return result;
+        }
+    }
+
+    for (size_t index : rewrites) {
+        auto& entry = entries[index];
+        auto written = write_file(parent, *entry.name, entry.content,
+                                  join_path(parent_path, *entry.name), true);
+        if (written.is_error()) {
+            return written.error();
+        }
+        entry.bytes_written = written.value().bytes_written;
+    }
+
+    for (size_t index : first_copies) {
+        auto& entry = entries[index];
+        if (!entry.existed) {
+            remember_source(parent, *entry.name, entry.content);
+        }
+    }
+
+    for (size_t index : duplicates) {
+        auto& entry = entries[index];
+        auto created = create_file(parent, *entry.name, entry.content, join_path(parent_path, *entry.name));
+        if (created.is_error()) {
+            return created.error();
+        }
+        entry.bytes_written = created.value().bytes_written;
+        entry.existed = created.value().existed;
+    }
+
+    return Result<void>();
+}
+
+} // namespace yaqeen::core
+
+#endif // YAQEEN_HAS_IO_URING
@@ -1,6 +1,9 @@
 #include "yaqeen/core/parser.hpp"
 #include "yaqeen/core/generator.hpp"
+#include "yaqeen/core/path_list.hpp"
+#include "yaqeen/core/tar_backend.hpp"
 #include "yaqeen/core/template_manager.hpp"
+#include "yaqeen/core/template_pack.hpp"
 #include "yaqeen/ui/theme.hpp"
 #include "yaqeen/ui/animations.hpp"
 #include "yaqeen/ui/progress.hpp"
@@ -11,11 +14,19 @@
 #include <ftxui/screen/screen.hpp>
 #include <ftxui/dom/elements.hpp>
 
+#include <cstdlib>
 #include <iostream>
+#include <iterator>
+#include <map>
 #include <memory>
 #include <thread>
 #include <chrono>
 
+#if YAQEEN_HAS_POSIX_BACKEND
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 using namespace yaqeen;
 using namespace ftxui;
 
@@ -23,6 +34,18 @@ using namespace ftxui;
 struct GlobalSettings {
     bool verbose = false;
     bool dry_run = false;
+    bool parallel = false;
+    bool atomic = false;
+    bool incremental = false;
+    bool prune = false;
+    bool dedup = false;
+    bool dedup_hardlinks = false;
+    std::string output_format = "dir";
+    bool print_plan = false;
+    size_t max_threads = 0;
+    size_t max_depth = 0;
+    size_t max_entries_per_dir = 0;
+    core::BackendKind backend = core::BackendKind::Auto;
     std::string log_file;
     std::string templates_dir;
 } g_settings;
@@ -81,50 +104,106 @@ void print_info(const std::string& message) {
     std::cout << std::endl;
 }
 
-int cmd_init(const std::string& markdown_file, const std::string& output_dir) {
-    print_logo();
-
-    print_info("Initializing project from markdown file");
-    std::cout << std::endl;
-
-    // Parse markdown file
-    print_info("Parsing markdown structure...");
-    core::MarkdownParser parser;
-    auto parse_result = parser.parse(markdown_file);
-
-    if (parse_result.is_error()) {
-        print_error("Failed to parse markdown: " + parse_result.error().message);
-        return 1;
+// Destination of --output-format tar: a file, or stdout for "-"
+struct ArchiveOutput {
+    int fd = -1;
+#if YAQEEN_HAS_POSIX_BACKEND
+    std::unique_ptr<core::TarBackend> sink;
+#endif
+
+    ArchiveOutput() = default;
+    ArchiveOutput(const ArchiveOutput&) = delete;
+    ArchiveOutput& operator=(const ArchiveOutput&) = delete;
+
+    ~ArchiveOutput() {
+#if YAQEEN_HAS_POSIX_BACKEND
+        if (fd >= 0) {
+            ::close(fd);
+        }
+#endif
+    }
+};
+
+// Must run before anything is printed: when the archive goes to stdout, the
+// archive keeps the original descriptor and all other output moves to stderr
+bool open_archive(const std::string& target, ArchiveOutput& archive) {
+#if YAQEEN_HAS_POSIX_BACKEND
+    // A dry run writes nothing, so an existing archive is neither opened nor
+    // truncated; the sink only marks the run as archive output
+    if (g_settings.dry_run) {
+        archive.sink = std::make_unique<core::TarBackend>(-1);
+        return true;
     }
 
-    auto tree = std::move(parse_result.value());
+    if (target.empty() || target == "-") {
+        std::cout.flush();
+        archive.fd = ::dup(STDOUT_FILENO);
+        if (archive.fd < 0 || ::dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+            print_error("Cannot redirect standard output");
+            return false;
+        }
+    } else {
+        archive.fd = ::open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (archive.fd < 0) {
+            print_error("Cannot open archive: " + target);
+            return false;
+        }
+    }
 
-    // Preview structure
-    if (g_settings.verbose) {
-        std::cout << std::endl;
-        print_info("Project structure:");
-        std::cout << core::TreeVisualizer::visualize(*tree, true) << std::endl;
+    // SOURCE_DATE_EPOCH keeps reproducible builds reproducible
+    uint64_t mtime = 0;
+    if (const char* epoch = std::getenv("SOURCE_DATE_EPOCH")) {
+        mtime = std::strtoull(epoch, nullptr, 10);
     }
+    archive.sink = std::make_unique<core::TarBackend>(archive.fd, mtime);
+    return true;
+#else
+    (void)target;
+    (void)archive;
+    print_error("Tar output is not supported on this platform");
+    return false;
+#endif
+}
 
-    // Generate files
-    print_info("Generating project structure...");
+core::GenerationBackend* archive_sink(ArchiveOutput& archive) {
+#if YAQEEN_HAS_POSIX_BACKEND
+    return archive.sink.get();
+#else
+    (void)archive;
+    return nullptr;
+#endif
+}
 
-    core::FileGenerator::Options options;
-    options.dry_run = g_settings.dry_run;
-    options.verbose = g_settings.verbose;
+// --print-plan: show the operations a structure compiles to, nothing else
+int print_plan(const core::NodeStore& tree) {
+    core::GenerationPlan::compile(tree).print(std::cout);
+    return 0;
+}
 
-    core::FileGenerator generator(options);
-    auto gen_result = generator.generate(*tree, output_dir.empty() ? "." : output_dir);
+// "-" reads the whole spec from stdin
+Result<core::NodeStore> parse_markdown(const std::string& markdown_file) {
+    core::MarkdownParser parser;
+    if (markdown_file != "-") {
+        return parser.parse_store(markdown_file);
+    }
 
-    if (gen_result.is_error()) {
-        print_error("Generation failed: " + gen_result.error().message);
-        return 1;
+    std::string markdown(std::istreambuf_iterator<char>(std::cin), {});
+    return parser.parse_string_store(markdown);
+}
+
+// --paths: one relative path per line instead of a drawn tree; "-" reads stdin
+Result<core::NodeStore> parse_path_list(const std::string& list_file) {
+    core::PathListParser parser;
+    if (list_file != "-") {
+        return parser.parse_store(list_file);
     }
 
-    std::cout << std::endl;
-    const auto& stats = gen_result.value();
+    std::string list(std::istreambuf_iterator<char>(std::cin), {});
+    return parser.parse_string_store(list);
+}
 
-    // Print summary
+// Summary shown after a successful init or create
+void print_summary(const core::GenerationStats& stats) {
     auto summary = vbox({
         ui::Theme::horizontal_line(),
         text("") | size(HEIGHT, EQUAL, 1),
@@ -154,11 +233,175 @@ int cmd_init(const std::string& markdown_file, const std::string& output_dir) {
     auto screen = Screen::Create(Dimension::Full());
     Render(screen, summary);
     screen.Print();
+}
+
+// yaqeen init - : create entries while the spec is still arriving on stdin
+int cmd_init_streaming(const std::string& output_dir) {
+    bool to_archive = g_settings.output_format == "tar";
+    ArchiveOutput archive;
+    if (to_archive && !open_archive(output_dir, archive)) {
+        return 1;
+    }
+
+    print_logo();
+    print_info("Generating project structure from standard input...");
+
+    core::FileGenerator::Options options;
+    options.dry_run = g_settings.dry_run;
+    options.verbose = g_settings.verbose;
+    options.dedup = g_settings.dedup || g_settings.dedup_hardlinks;
+    options.dedup_hardlinks = g_settings.dedup_hardlinks;
+    options.backend = g_settings.backend;
+
+    // Archive members are named after the parser's root, as for a file
+    std::filesystem::path target = output_dir.empty() ? "." : output_dir;
+    if (to_archive) {
+        options.sink = archive_sink(archive);
+        target = "root";
+    }
+
+    core::FileGenerator generator(options);
+    auto gen_result = generator.generate_streaming(std::cin, target);
+    if (gen_result.is_error()) {
+        print_error("Generation failed: " + gen_result.error().message);
+        return 1;
+    }
+
+    std::cout << std::endl;
+    print_summary(gen_result.value());
+    return 0;
+}
+
+int cmd_init(const std::string& markdown_file, const std::string& paths_file, const std::string& output_dir) {
+    if (markdown_file.empty() && paths_file.empty()) {
+        print_error("init needs a markdown file or --paths");
+        return 1;
+    }
+
+    // Streaming needs nothing that looks at the whole tree first
+    bool whole_tree = g_settings.print_plan || g_settings.verbose || g_settings.atomic ||
+                      g_settings.incremental || g_settings.parallel;
+    if (markdown_file == "-" && !whole_tree) {
+        return cmd_init_streaming(output_dir);
+    }
+
+    bool from_paths = !paths_file.empty();
+    std::string source_kind = from_paths ? "path list" : "markdown";
+    auto parse_structure = [&] {
+        return from_paths ? parse_path_list(paths_file) : parse_markdown(markdown_file);
+    };
+
+    if (g_settings.print_plan) {
+        auto parse_result = parse_structure();
+        if (parse_result.is_error()) {
+            print_error("Failed to parse " + source_kind + ": " + parse_result.error().message);
+            return 1;
+        }
+        return print_plan(parse_result.value());
+    }
+
+    bool to_archive = g_settings.output_format == "tar";
+    ArchiveOutput archive;
+    if (to_archive && !open_archive(output_dir, archive)) {
+        return 1;
+    }
+
+    print_logo();
+
+    print_info("Initializing project from " + source_kind + " file");
+    std::cout << std::endl;
+
+    // Parse markdown file or path list
+    print_info("Parsing " + source_kind + " structure...");
+    auto parse_result = parse_structure();
+
+    if (parse_result.is_error()) {
+        print_error("Failed to parse " + source_kind + ": " + parse_result.error().message);
+        return 1;
+    }
+
+    auto tree = std::move(parse_result.value());
+
+    // Preview structure
+    if (g_settings.verbose) {
+        std::cout << std::endl;
+        print_info("Project structure:");
+        core::TreeVisualizer::Options preview;
+        preview.max_depth = g_settings.max_depth;
+        preview.max_entries_per_dir = g_settings.max_entries_per_dir;
+        core::TreeVisualizer::print(tree, preview);
+        std::cout << std::endl;
+    }
+
+    // Generate files
+    print_info("Generating project structure...");
+
+    core::FileGenerator::Options options;
+    options.dry_run = g_settings.dry_run;
+    options.verbose = g_settings.verbose;
+    options.parallel = g_settings.parallel;
+    options.max_threads = g_settings.max_threads;
+    options.atomic = g_settings.atomic;
+    options.incremental = g_settings.incremental;
+    options.prune = g_settings.prune;
+    options.dedup = g_settings.dedup || g_settings.dedup_hardlinks;
+    options.dedup_hardlinks = g_settings.dedup_hardlinks;
+    options.backend = g_settings.backend;
+
+    // Archive members are named after the structure's root
+    std::filesystem::path target = output_dir.empty() ? "." : output_dir;
+    if (to_archive) {
+        options.sink = archive_sink(archive);
+        target = tree.name(tree.root());
+    }
+
+    core::FileGenerator generator(options);
+    auto gen_result = generator.generate(tree, target);
+
+    if (gen_result.is_error()) {
+        print_error("Generation failed: " + gen_result.error().message);
+        return 1;
+    }
+
+    std::cout << std::endl;
+    print_summary(gen_result.value());
 
     return 0;
 }
 
 int cmd_create(const std::string& template_name, const std::string& project_name, const std::string& output_dir) {
+    if (g_settings.print_plan) {
+        core::TemplateManager manager;
+        if (!g_settings.templates_dir.empty()) {
+            manager = core::TemplateManager(g_settings.templates_dir);
+        }
+
+        auto init_result = manager.initialize();
+        if (init_result.is_error()) {
+            print_error("Failed to initialize templates: " + init_result.error().message);
+            return 1;
+        }
+
+        auto tmpl_result = manager.get_template(template_name);
+        if (tmpl_result.is_error()) {
+            print_error("Template not found: " + template_name);
+            return 1;
+        }
+
+        auto tree = core::TemplateGenerator::json_to_store(tmpl_result.value().structure, project_name);
+        if (tree.is_error()) {
+            print_error("Invalid template: " + tree.error().message);
+            return 1;
+        }
+        return print_plan(tree.value());
+    }
+
+    bool to_archive = g_settings.output_format == "tar";
+    ArchiveOutput archive;
+    if (to_archive && !open_archive(output_dir, archive)) {
+        return 1;
+    }
+
     print_logo();
 
     print_info("Creating project: " + project_name);
@@ -189,8 +432,8 @@ int cmd_create(const std::string& template_name, const std::string& project_name
         return 1;
     }
 
-    // Prepare output directory
-    std::filesystem::path out_path = output_dir.empty() ? project_name : output_dir;
+    // Prepare output directory; archive members are named after the project
+    std::filesystem::path out_path = output_dir.empty() || to_archive ? project_name : output_dir;
 
     print_info("Generating project structure...");
 
@@ -200,6 +443,17 @@ int cmd_create(const std::string& template_name, const std::string& project_name
     options.output_dir = out_path;
     options.dry_run = g_settings.dry_run;
     options.verbose = g_settings.verbose;
+    options.parallel = g_settings.parallel;
+    options.max_threads = g_settings.max_threads;
+    options.atomic = g_settings.atomic;
+    options.incremental = g_settings.incremental;
+    options.prune = g_settings.prune;
+    options.dedup = g_settings.dedup || g_settings.dedup_hardlinks;
+    options.dedup_hardlinks = g_settings.dedup_hardlinks;
+    options.backend = g_settings.backend;
+    if (to_archive) {
+        options.sink = archive_sink(archive);
+    }
 
     auto gen_result = manager.generate_from_template(template_name, out_path, project_name, options);
 
@@ -209,38 +463,7 @@ int cmd_create(const std::string& template_name, const std::string& project_name
     }
 
     std::cout << std::endl;
-    const auto& stats = gen_result.value();
-
-    // Print summary
-    auto summary = vbox({
-        ui::Theme::horizontal_line(),
-        text("") | size(HEIGHT, EQUAL, 1),
-        ui::Theme::success_text("Project created successfully!") | bold | center,
-        text("") | size(HEIGHT, EQUAL, 1),
-        hbox({
-            text("  "),
-            vbox({
-                hbox({
-                    text("Directories: ") | color(ui::TokyoColors::FG),
-                    text(std::to_string(stats.dirs_created)) | color(ui::TokyoColors::GREEN) | bold
-                }),
-                hbox({
-                    text("Files: ") | color(ui::TokyoColors::FG),
-                    text(std::to_string(stats.files_created)) | color(ui::TokyoColors::GREEN) | bold
-                }),
-                hbox({
-                    text("Time: ") | color(ui::TokyoColors::FG),
-                    text(std::to_string(stats.elapsed.count()) + "ms") | color(ui::TokyoColors::YELLOW) | bold
-                })
-            })
-        }),
-        text("") | size(HEIGHT, EQUAL, 1),
-        ui::Theme::horizontal_line()
-    });
-
-    auto screen = Screen::Create(Dimension::Full());
-    Render(screen, summary);
-    screen.Print();
+    print_summary(gen_result.value());
 
     return 0;
 }
@@ -292,6 +515,30 @@ int cmd_list(const std::string& category) {
     return 0;
 }
 
+int cmd_templates_compile() {
+    std::filesystem::path dir = g_settings.templates_dir.empty()
+        ? core::TemplateManager::get_default_templates_directory()
+        : std::filesystem::path(g_settings.templates_dir);
+    auto pack_path = core::TemplatePack::default_path(dir);
+
+    auto compiled = core::TemplatePack::compile(dir, pack_path);
+    if (compiled.is_error()) {
+        print_error("Failed to compile templates: " + compiled.error().message);
+        return 1;
+    }
+
+    const auto& summary = compiled.value();
+    print_success("Packed " + std::to_string(summary.templates) + " templates (" +
+                  std::to_string(summary.bytes / 1024) + " KB) into " + pack_path.string());
+    if (summary.invalid != 0) {
+        print_info(std::to_string(summary.invalid) + " templates have an invalid structure and will fail when used");
+    }
+    if (summary.skipped != 0) {
+        print_info(std::to_string(summary.skipped) + " template files could not be packed");
+    }
+    return 0;
+}
+
 int cmd_show(const std::string& template_name) {
     print_logo();
 
@@ -342,20 +589,54 @@ int cmd_show(const std::string& template_name) {
     return 0;
 }
 
+void load_environment_settings() {
+    if (const char* parallel = std::getenv("YAQEEN_PARALLEL")) {
+        std::string value = parallel;
+        g_settings.parallel = value == "1" || value == "true";
+    }
+
+    if (const char* threads = std::getenv("YAQEEN_MAX_THREADS")) {
+        g_settings.max_threads = std::strtoul(threads, nullptr, 10);
+    }
+}
+
 int main(int argc, char** argv) {
     CLI::App app{"Yaqeen - Project Structure Generator", "yaqeen"};
 
+    load_environment_settings();
+
     app.add_flag("-v,--verbose", g_settings.verbose, "Verbose output");
     app.add_flag("--dry-run", g_settings.dry_run, "Show what would be created without creating");
+    app.add_flag("--parallel", g_settings.parallel, "Create sibling directories concurrently");
+    app.add_option("--threads", g_settings.max_threads, "Worker threads for --parallel (0 = one per core)");
+    app.add_flag("--atomic", g_settings.atomic, "Build in a staging directory and move it into place when complete");
+    app.add_flag("--incremental", g_settings.incremental, "Only write nodes changed since the last run (see .yaqeen-manifest)");
+    app.add_flag("--prune", g_settings.prune, "With --incremental, delete paths no longer in the structure");
+    app.add_flag("--dedup", g_settings.dedup, "Reflink repeated file contents instead of writing them again");
+    app.add_option("--output-format", g_settings.output_format, "Write a directory tree or a tar archive to -o (stdout by default)")
+        ->check(CLI::IsMember({"dir", "tar"}));
+    app.add_flag("--print-plan", g_settings.print_plan, "Print the compiled generation plan instead of generating");
+    app.add_option("--max-depth", g_settings.max_depth, "Levels of the --verbose structure preview to show (0 = all)");
+    app.add_option("--max-entries-per-dir", g_settings.max_entries_per_dir, "Entries per directory in the --verbose preview (0 = all)");
+    app.add_flag("--dedup-hardlinks", g_settings.dedup_hardlinks, "Like --dedup, hard-linking copies where reflinks are unsupported");
+    app.add_option("--backend", g_settings.backend, "File creation backend")
+        ->transform(CLI::CheckedTransformer(std::map<std::string, core::BackendKind>{
+            {"auto", core::BackendKind::Auto},
+            {"portable", core::BackendKind::Portable},
+            {"fd", core::BackendKind::DirectoryFd},
+            {"io_uring", core::BackendKind::IoUring}
+        }, CLI::ignore_case));
     app.add_option("--log-file", g_settings.log_file, "Log file path");
     app.add_option("--templates-dir", g_settings.templates_dir, "Custom templates directory");
 
     // Init command
     auto init_cmd = app.add_subcommand("init", "Initialize from markdown file");
     std::string markdown_file;
+    std::string paths_file;
     std::string init_output;
-    init_cmd->add_option("file", markdown_file, "Markdown file containing project structure")
-        ->required();
+    auto file_opt = init_cmd->add_option("file", markdown_file, "Markdown file containing project structure (- for stdin)");
+    init_cmd->add_option("--paths", paths_file, "Build from a list of relative paths, one per line, '/' ending directories (- for stdin)")
+        ->excludes(file_opt);
     init_cmd->add_option("-o,--output", init_output, "Output directory");
 
     // Create command
@@ -380,6 +661,12 @@ int main(int argc, char** argv) {
     show_cmd->add_option("template", show_template, "Template name")
         ->required();
 
+    // Templates command
+    auto templates_cmd = app.add_subcommand("templates", "Manage the templates directory");
+    auto compile_cmd = templates_cmd->add_subcommand("compile",
+        "Pack the templates directory into one file that later runs map instead of parsing JSON");
+    templates_cmd->require_subcommand(1);
+
     CLI11_PARSE(app, argc, argv);
 
     // Setup logger
@@ -393,13 +680,15 @@ int main(int argc, char** argv) {
 
     // Execute commands
     if (init_cmd->parsed()) {
-        return cmd_init(markdown_file, init_output);
+        return cmd_init(markdown_file, paths_file, init_output);
     } else if (create_cmd->parsed()) {
         return cmd_create(template_name, project_name, create_output);
     } else if (list_cmd->parsed()) {
         return cmd_list(list_category);
     } else if (show_cmd->parsed()) {
         return cmd_show(show_template);
+    } else if (compile_cmd->parsed()) {
+        return cmd_templates_compile();
     } else {
         // No command specified, show logo and help
         print_logo();
@@ -0,0 +1,172 @@
+#include "yaqeen/utils/mapped_file.hpp"
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <sstream>
+#endif
+
+namespace yaqeen {
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        mapped_ = std::exchange(other.mapped_, false);
+        size_ = std::exchange(other.size_, 0);
+        buffer_ = std::move(other.buffer_);
+        // An owned buffer moves with its string; a mapping moves as is
+        data_ = mapped_ ? other.data_ : buffer_.data();
+        other.data_ = nullptr;
+        other.buffer_.clear();
+    }
+    return *this;
+}
+
+void MappedFile::release() {
+#if defined(__unix__) || defined(__APPLE__)
+    if (mapped_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    buffer_.clear();
+}
+
+MappedFile MappedFile::from_buffer(std::string contents) {
+    MappedFile owned;
+    owned.buffer_ = std::move(contents);
+    owned.data_ = owned.buffer_.data();
+    owned.size_ = owned.buffer_.size();
+    return owned;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace {
+
+Error open_error(int error, const std::filesystem::path& path) {
+    switch (error) {
+    case ENOENT:
+    case ENOTDIR:
+        return Error(ErrorCode::FileNotFound, "File not found: " + path.string());
+    case EACCES:
+    case EPERM:
+        return Error(ErrorCode::PermissionDenied, "Cannot read file: " + path.string());
+    case EISDIR:
+        return Error(ErrorCode::InvalidInput, "Path is not a file: " + path.string());
+    default:
+        return Error(ErrorCode::UnknownError, "Cannot read file: " + path.string(), std::strerror(error));
+    }
+}
+
+// Closes the descriptor on every return path
+struct Descriptor {
+    int fd;
+    ~Descriptor() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+} // namespace
+
+Result<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+    Descriptor file{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (file.fd < 0) {
+        return open_error(errno, path);
+    }
+
+    struct stat info;
+    if (::fstat(file.fd, &info) != 0) {
+        return open_error(errno, path);
+    }
+    if (S_ISDIR(info.st_mode)) {
+        return open_error(EISDIR, path);
+    }
+
+    MappedFile mapped;
+    if (S_ISREG(info.st_mode)) {
+        if (info.st_size == 0) {
+            return mapped;
+        }
+
+        size_t size = static_cast<size_t>(info.st_size);
+        void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.fd, 0);
+        if (data != MAP_FAILED) {
+            ::madvise(data, size, MADV_SEQUENTIAL);
+            mapped.data_ = static_cast<const char*>(data);
+            mapped.size_ = size;
+            mapped.mapped_ = true;
+            return mapped;
+        }
+        // Some filesystems cannot be mapped; read them like a pipe
+    }
+
+    // Pipes, FIFOs and character devices have no size up front
+    char chunk[64 * 1024];
+    for (;;) {
+        ssize_t n = ::read(file.fd, chunk, sizeof(chunk));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return open_error(errno, path);
+        }
+        if (n == 0) {
+            break;
+        }
+        mapped.buffer_.append(chunk, static_cast<size_t>(n));
+    }
+
+    mapped.data_ = mapped.buffer_.data();
+    mapped.size_ = mapped.buffer_.size();
+    return mapped;
+}
+
+#else
+
+Result<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+    std::error_code ec;
+    if (std::filesystem::is_directory(path, ec)) {
+        return Error(ErrorCode::InvalidInput, "Path is not a file: " + path.string());
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        if (!std::filesystem::exists(path, ec)) {
+            return Error(ErrorCode::FileNotFound, "File not found: " + path.string());
+        }
+        return Error(ErrorCode::PermissionDenied, "Cannot read file: " + path.string());
+    }
+
+    std::ostringstream contents;
+    contents << in.rdbuf();
+
+    MappedFile mapped;
+    mapped.buffer_ = contents.str();
+    mapped.data_ = mapped.buffer_.data();
+    mapped.size_ = mapped.buffer_.size();
+    return mapped;
+}
+
+#endif
+
+} // namespace yaqeen
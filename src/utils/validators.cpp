@@ -1,6 +1,10 @@
 #include "yaqeen/utils/validators.hpp"
 #include <nlohmann/json.hpp>
-#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace yaqeen {
 
@@ -37,14 +41,17 @@ Result<void> Validator::validate_path_writable(const std::filesystem::path& path
         return Error(ErrorCode::DirectoryNotFound, "Parent directory does not exist: " + parent.string());
     }
 
-    // Check write permissions by attempting to create a test file
-    auto test_path = parent / (".yaqeen_write_test_" + std::to_string(std::time(nullptr)));
-    std::ofstream test_file(test_path);
-    if (!test_file) {
+    // Ask the kernel instead of creating and deleting a probe file
+#if defined(__unix__) || defined(__APPLE__)
+    bool writable = ::faccessat(AT_FDCWD, parent.c_str(), W_OK | X_OK, AT_EACCESS) == 0;
+#else
+    std::error_code ec;
+    auto perms = std::filesystem::status(parent, ec).permissions();
+    bool writable = !ec && (perms & std::filesystem::perms::owner_write) != std::filesystem::perms::none;
+#endif
+    if (!writable) {
         return Error(ErrorCode::PermissionDenied, "Cannot write to directory: " + parent.string());
     }
-    test_file.close();
-    std::filesystem::remove(test_path);
 
     return Result<void>();
 }
@@ -55,8 +62,15 @@ Result<void> Validator::validate_file_readable(const std::filesystem::path& path
         return result;
     }
 
-    std::ifstream file(path);
-    if (!file) {
+    // Ask the kernel instead of opening the file only to close it again
+#if defined(__unix__) || defined(__APPLE__)
+    bool readable = ::faccessat(AT_FDCWD, path.c_str(), R_OK, AT_EACCESS) == 0;
+#else
+    std::error_code ec;
+    auto perms = std::filesystem::status(path, ec).permissions();
+    bool readable = !ec && (perms & std::filesystem::perms::owner_read) != std::filesystem::perms::none;
+#endif
+    if (!readable) {
         return Error(ErrorCode::PermissionDenied, "Cannot read file: " + path.string());
     }
 
@@ -1,7 +1,18 @@
 #include <catch2/catch_test_macros.hpp>
+#include "yaqeen/core/entry_stream.hpp"
 #include "yaqeen/core/generator.hpp"
+#include "yaqeen/core/manifest.hpp"
 #include "yaqeen/core/parser.hpp"
+#include "yaqeen/core/plan.hpp"
+#include "yaqeen/core/preflight.hpp"
+#include "yaqeen/core/tar_backend.hpp"
+#include <fcntl.h>
+#include <unistd.h>
 #include <filesystem>
+#include <fstream>
+#include <atomic>
+#include <sstream>
+#include <thread>
 
 using namespace yaqeen::core;
 
@@ -78,3 +89,1030 @@ TEST_CASE("TemplateGenerator converts JSON to node tree", "[generator]") {
 
     REQUIRE(result.is_ok());
 }
+
+TEST_CASE("FileGenerator parallel mode matches serial output", "[generator]") {
+    auto root = std::make_unique<Node>(Node::Type::Directory, "root");
+    for (int d = 0; d < 8; ++d) {
+        auto dir = std::make_unique<Node>(Node::Type::Directory, "dir" + std::to_string(d));
+        for (int f = 0; f < 16; ++f) {
+            auto file = std::make_unique<Node>(Node::Type::File, "file" + std::to_string(f) + ".txt");
+            file->content = "content " + std::to_string(d * 100 + f);
+            dir->add_child(std::move(file));
+        }
+        dir->add_child(std::make_unique<Node>(Node::Type::Directory, "empty"));
+        root->add_child(std::move(dir));
+    }
+
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_parallel_test";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base);
+
+    std::vector<std::string> serial_order;
+    FileGenerator::Options serial_options;
+    serial_options.progress_callback = [&](const std::filesystem::path& path, bool, size_t, size_t) {
+        serial_order.push_back(path.lexically_relative(base / "serial").generic_string());
+    };
+    auto serial = FileGenerator(serial_options).generate(*root, base / "serial");
+    REQUIRE(serial.is_ok());
+
+    std::vector<std::string> parallel_order;
+    std::vector<size_t> parallel_counters;
+    FileGenerator::Options parallel_options;
+    parallel_options.parallel = true;
+    parallel_options.max_threads = 4;
+    parallel_options.progress_callback = [&](const std::filesystem::path& path, bool, size_t current, size_t) {
+        parallel_order.push_back(path.lexically_relative(base / "parallel").generic_string());
+        parallel_counters.push_back(current);
+    };
+    auto parallel = FileGenerator(parallel_options).generate(*root, base / "parallel");
+    REQUIRE(parallel.is_ok());
+
+    REQUIRE(parallel.value().files_created == serial.value().files_created);
+    REQUIRE(parallel.value().dirs_created == serial.value().dirs_created);
+    REQUIRE(parallel.value().total_size == serial.value().total_size);
+    REQUIRE(parallel_order == serial_order);
+    for (size_t i = 0; i < parallel_counters.size(); ++i) {
+        REQUIRE(parallel_counters[i] == i + 1);
+    }
+    REQUIRE(std::filesystem::exists(base / "parallel" / "dir7" / "file15.txt"));
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("FileGenerator backends produce identical trees", "[generator]") {
+    auto root = std::make_unique<Node>(Node::Type::Directory, "root");
+    auto src = std::make_unique<Node>(Node::Type::Directory, "src");
+    auto nested = std::make_unique<Node>(Node::Type::Directory, "nested");
+    auto main_file = std::make_unique<Node>(Node::Type::File, "main.cpp");
+    main_file->content = "int main() {}\n";
+    nested->add_child(std::make_unique<Node>(Node::Type::File, "deep.txt"));
+    src->add_child(std::move(nested));
+    src->add_child(std::move(main_file));
+    root->add_child(std::move(src));
+    root->add_child(std::make_unique<Node>(Node::Type::File, "README.md"));
+
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_backend_test";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base);
+
+    for (auto kind : {BackendKind::Portable, BackendKind::DirectoryFd}) {
+        auto out = base / (kind == BackendKind::Portable ? "portable" : "fd");
+
+        FileGenerator::Options options;
+        options.backend = kind;
+
+        auto result = FileGenerator(options).generate(*root, out);
+        REQUIRE(result.is_ok());
+        REQUIRE(result.value().dirs_created == 3);
+        REQUIRE(result.value().files_created == 3);
+        REQUIRE(result.value().total_size == 14);
+        REQUIRE(std::filesystem::file_size(out / "src" / "main.cpp") == 14);
+        REQUIRE(std::filesystem::is_regular_file(out / "src" / "nested" / "deep.txt"));
+
+        // A second run reuses directories and keeps existing files
+        auto rerun = FileGenerator(options).generate(*root, out);
+        REQUIRE(rerun.is_ok());
+        REQUIRE(rerun.value().files_created == 0);
+        REQUIRE(rerun.value().files_skipped == 3);
+        REQUIRE(rerun.value().total_size == 0);
+        REQUIRE(std::filesystem::file_size(out / "src" / "main.cpp") == 14);
+    }
+
+    // A file standing where a directory should go is an error
+    std::filesystem::remove_all(base / "fd" / "src");
+    std::ofstream(base / "fd" / "src").put('x');
+    FileGenerator::Options options;
+    options.backend = BackendKind::DirectoryFd;
+    auto conflict = FileGenerator(options).generate(*root, base / "fd");
+    REQUIRE(conflict.is_error());
+    REQUIRE(conflict.error().code == yaqeen::ErrorCode::FileAlreadyExists);
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("FileGenerator io_uring backend creates batched trees", "[generator]") {
+    auto root = std::make_unique<Node>(Node::Type::Directory, "root");
+    for (int d = 0; d < 4; ++d) {
+        auto dir = std::make_unique<Node>(Node::Type::Directory, "dir" + std::to_string(d));
+        for (int f = 0; f < 100; ++f) {
+            auto file = std::make_unique<Node>(Node::Type::File, "f" + std::to_string(f));
+            if (f % 2 == 0) {
+                file->content = std::string(static_cast<size_t>(f), 'x');
+            }
+            dir->add_child(std::move(file));
+        }
+        root->add_child(std::move(dir));
+    }
+
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_uring_test";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base);
+
+    FileGenerator::Options options;
+    options.backend = BackendKind::IoUring;
+    options.queue_depth = 32;  // force several rounds per directory
+
+    auto result = FileGenerator(options).generate(*root, base / "out");
+    REQUIRE(result.is_ok());
+    REQUIRE(result.value().files_created == 400);
+    REQUIRE(result.value().dirs_created == 5);
+    REQUIRE(result.value().sqes_submitted == result.value().cqes_completed);
+    REQUIRE(std::filesystem::file_size(base / "out" / "dir3" / "f98") == 98);
+    REQUIRE(std::filesystem::file_size(base / "out" / "dir3" / "f99") == 0);
+
+    // Collisions are settled by the batched opens and keep existing files
+    auto rerun = FileGenerator(options).generate(*root, base / "out");
+    REQUIRE(rerun.is_ok());
+    REQUIRE(rerun.value().files_skipped == 400);
+    REQUIRE(rerun.value().total_size == 0);
+    REQUIRE(std::filesystem::file_size(base / "out" / "dir3" / "f98") == 98);
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("FileGenerator directory-fd backend stays within its syscall budget", "[generator]") {
+    // root/{a/{one.txt, two.txt}, b/, empty.txt}
+    auto root = std::make_unique<Node>(Node::Type::Directory, "root");
+    auto a = std::make_unique<Node>(Node::Type::Directory, "a");
+    auto one = std::make_unique<Node>(Node::Type::File, "one.txt");
+    one->content = "1";
+    auto two = std::make_unique<Node>(Node::Type::File, "two.txt");
+    two->content = "22";
+    a->add_child(std::move(one));
+    a->add_child(std::move(two));
+    root->add_child(std::move(a));
+    root->add_child(std::make_unique<Node>(Node::Type::Directory, "b"));
+    root->add_child(std::make_unique<Node>(Node::Type::File, "empty.txt"));
+
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_syscall_test";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base);
+
+    FileGenerator::Options options;
+    options.backend = BackendKind::DirectoryFd;
+
+    // Root: failed open, reopen after creating it, close.
+    // a: mkdirat, openat, close. b: mkdirat only (nothing to open).
+    // Files: openat, close, plus one write when there is content.
+    auto result = FileGenerator(options).generate(*root, base / "out");
+    REQUIRE(result.is_ok());
+    REQUIRE(result.value().syscalls == 3 + 3 + 1 + (3 + 3 + 2));
+
+    // Existing nodes are detected by the create itself, never probed first:
+    // root open and close, a: mkdirat, fstatat, openat, close, b: mkdirat,
+    // fstatat, and one failed openat per file
+    auto rerun = FileGenerator(options).generate(*root, base / "out");
+    REQUIRE(rerun.is_ok());
+    REQUIRE(rerun.value().files_skipped == 3);
+    REQUIRE(rerun.value().syscalls == 2 + 4 + 2 + 3);
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("FileGenerator atomic mode publishes complete trees only", "[generator]") {
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_atomic_test";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base);
+
+    auto make_tree = [](const std::string& content) {
+        auto root = std::make_unique<Node>(Node::Type::Directory, "root");
+        auto src = std::make_unique<Node>(Node::Type::Directory, "src");
+        auto file = std::make_unique<Node>(Node::Type::File, "main.cpp");
+        file->content = content;
+        src->add_child(std::move(file));
+        root->add_child(std::move(src));
+        return root;
+    };
+
+    auto leftovers = [&base] {
+        size_t count = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(base)) {
+            auto name = entry.path().filename().string();
+            if (name.rfind('.', 0) == 0 && name.find(".yaqeen-") != std::string::npos) {
+                count++;
+            }
+        }
+        return count;
+    };
+
+    FileGenerator::Options options;
+    options.atomic = true;
+
+    auto first = FileGenerator(options).generate(*make_tree("v1"), base / "out");
+    REQUIRE(first.is_ok());
+    REQUIRE(first.value().files_created == 1);
+    REQUIRE(std::filesystem::file_size(base / "out" / "src" / "main.cpp") == 2);
+
+    // Without overwrite an existing output is never touched
+    auto refused = FileGenerator(options).generate(*make_tree("v2!"), base / "out");
+    REQUIRE(refused.is_error());
+    REQUIRE(refused.error().code == yaqeen::ErrorCode::FileAlreadyExists);
+
+    // Nor is one that appears while the tree is being staged
+    options.progress_callback = [&base](const std::filesystem::path&, bool, size_t current, size_t) {
+        if (current == 1) {
+            std::filesystem::create_directories(base / "raced");
+            std::ofstream(base / "raced" / "theirs.txt") << "theirs";
+        }
+    };
+    auto raced = FileGenerator(options).generate(*make_tree("v2!"), base / "raced");
+    REQUIRE(raced.is_error());
+    REQUIRE(raced.error().code == yaqeen::ErrorCode::FileAlreadyExists);
+    REQUIRE(std::filesystem::file_size(base / "raced" / "theirs.txt") == 6);
+    REQUIRE_FALSE(std::filesystem::exists(base / "raced" / "src"));
+    REQUIRE(leftovers() == 0);
+    options.progress_callback = nullptr;
+
+    // A rejected tree leaves the previous tree in place and no staging dir
+    auto broken = make_tree("v2!");
+    broken->add_child(std::make_unique<Node>(Node::Type::File, "clash"));
+    broken->add_child(std::make_unique<Node>(Node::Type::Directory, "clash"));
+    options.overwrite = true;
+    auto failed = FileGenerator(options).generate(*broken, base / "out");
+    REQUIRE(failed.is_error());
+    REQUIRE(std::filesystem::file_size(base / "out" / "src" / "main.cpp") == 2);
+    REQUIRE_FALSE(std::filesystem::exists(base / "out" / "clash"));
+    REQUIRE(leftovers() == 0);
+
+    // With overwrite the whole tree is swapped in
+    std::ofstream(base / "out" / "stale.txt") << "old";
+    auto replaced = FileGenerator(options).generate(*make_tree("v2!"), base / "out");
+    REQUIRE(replaced.is_ok());
+    REQUIRE(std::filesystem::file_size(base / "out" / "src" / "main.cpp") == 3);
+    REQUIRE_FALSE(std::filesystem::exists(base / "out" / "stale.txt"));
+    REQUIRE(leftovers() == 0);
+
+    // A single-file tree is written through a temporary and linked into place
+    auto single = std::make_unique<Node>(Node::Type::File, "notes.txt");
+    single->content = "hello";
+    auto file_result = FileGenerator(options).generate(*single, base / "notes.txt");
+    REQUIRE(file_result.is_ok());
+    REQUIRE(std::filesystem::file_size(base / "notes.txt") == 5);
+
+    options.overwrite = false;
+    auto kept = FileGenerator(options).generate(*single, base / "notes.txt");
+    REQUIRE(kept.is_ok());
+    REQUIRE(kept.value().files_skipped == 1);
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("Manifest round-trips and diffs trees", "[generator]") {
+    auto root = std::make_unique<Node>(Node::Type::Directory, "root");
+    auto src = std::make_unique<Node>(Node::Type::Directory, "src");
+    auto main_file = std::make_unique<Node>(Node::Type::File, "main.cpp");
+    main_file->content = "int main() {}\n";
+    src->add_child(std::move(main_file));
+    root->add_child(std::move(src));
+    root->add_child(std::make_unique<Node>(Node::Type::File, "odd name\\with\nnewline"));
+
+    auto manifest = Manifest::from_tree(*root);
+    REQUIRE(manifest.entries().size() == 3);
+    REQUIRE(manifest.entries()[2].path == "src/main.cpp");
+    REQUIRE(manifest.entries()[2].size == 14);
+
+    auto parsed = Manifest::parse(manifest.serialize());
+    REQUIRE(parsed.is_ok());
+    REQUIRE(parsed.value().entries() == manifest.entries());
+    REQUIRE(Manifest::parse("not a manifest\n").is_error());
+
+    auto same = ManifestDiff::compute(manifest, Manifest::from_tree(*root));
+    REQUIRE_FALSE(same.has_writes());
+    REQUIRE(same.removed.empty());
+    REQUIRE(same.unchanged_files == 2);
+
+    // Change one file, turn another into a directory, add a new one
+    root->children[0]->children[0]->content = "int main() { return 1; }\n";
+    root->children[1]->type = Node::Type::Directory;
+    root->children[0]->add_child(std::make_unique<Node>(Node::Type::File, "util.cpp"));
+
+    auto diff = ManifestDiff::compute(manifest, Manifest::from_tree(*root));
+    REQUIRE(diff.changed.size() == 1);
+    REQUIRE(diff.added.size() == 2);
+    REQUIRE(diff.removed.size() == 1);
+    REQUIRE(diff.unchanged_files == 0);
+}
+
+TEST_CASE("FileGenerator incremental mode touches only changed nodes", "[generator]") {
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_incremental_test";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base);
+    auto out = base / "out";
+
+    auto root = std::make_unique<Node>(Node::Type::Directory, "root");
+    auto src = std::make_unique<Node>(Node::Type::Directory, "src");
+    auto main_file = std::make_unique<Node>(Node::Type::File, "main.cpp");
+    main_file->content = "v1";
+    src->add_child(std::move(main_file));
+    src->add_child(std::make_unique<Node>(Node::Type::File, "util.cpp"));
+    root->add_child(std::move(src));
+    auto old_dir = std::make_unique<Node>(Node::Type::Directory, "old");
+    old_dir->add_child(std::make_unique<Node>(Node::Type::File, "gone.txt"));
+    root->add_child(std::move(old_dir));
+
+    FileGenerator::Options options;
+    options.incremental = true;
+    options.backend = BackendKind::DirectoryFd;
+
+    auto first = FileGenerator(options).generate(*root, out);
+    REQUIRE(first.is_ok());
+    REQUIRE(first.value().files_created == 3);
+    REQUIRE(std::filesystem::exists(out / Manifest::kFileName));
+
+    // Nothing changed: no filesystem work at all
+    auto unchanged = FileGenerator(options).generate(*root, out);
+    REQUIRE(unchanged.is_ok());
+    REQUIRE(unchanged.value().files_created == 0);
+    REQUIRE(unchanged.value().dirs_created == 0);
+    REQUIRE(unchanged.value().files_skipped == 3);
+    REQUIRE(unchanged.value().syscalls == 0);
+
+    // A changed file is rewritten even though it exists; others stay put
+    root->children[0]->children[0]->content = "version 2";
+    root->children.pop_back();
+    auto changed = FileGenerator(options).generate(*root, out);
+    REQUIRE(changed.is_ok());
+    REQUIRE(changed.value().files_created == 1);
+    REQUIRE(changed.value().files_skipped == 1);
+    REQUIRE(changed.value().total_size == 9);
+    REQUIRE(std::filesystem::file_size(out / "src" / "main.cpp") == 9);
+
+    // Without prune the removed subtree is left alone
+    REQUIRE(std::filesystem::exists(out / "old" / "gone.txt"));
+    REQUIRE(changed.value().entries_removed == 0);
+
+    // The manifest still lists what was left behind, so a later prune
+    // removes it even though the plan dropped it a run ago
+    auto left = Manifest::load(out / Manifest::kFileName);
+    REQUIRE(left.is_ok());
+    REQUIRE(left.value().entries().size() == Manifest::from_tree(*root).entries().size() + 2);
+    REQUIRE(FileGenerator(options).generate(*root, out).value().files_created == 0);
+
+    options.prune = true;
+    auto pruned = FileGenerator(options).generate(*root, out);
+    REQUIRE(pruned.is_ok());
+    REQUIRE(pruned.value().entries_removed == 2);
+    REQUIRE_FALSE(std::filesystem::exists(out / "old"));
+    REQUIRE(std::filesystem::exists(out / "src" / "util.cpp"));
+
+    auto manifest = Manifest::load(out / Manifest::kFileName);
+    REQUIRE(manifest.is_ok());
+    REQUIRE(manifest.value().entries() == Manifest::from_tree(*root).entries());
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("FileGenerator incremental first run keeps existing files", "[generator]") {
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_incremental_first_test";
+    std::filesystem::remove_all(base);
+    auto out = base / "out";
+    std::filesystem::create_directories(out);
+    {
+        std::ofstream user_file(out / "a.txt");
+        user_file << "USER DATA";
+    }
+
+    auto root = std::make_unique<Node>(Node::Type::Directory, "root");
+    auto a = std::make_unique<Node>(Node::Type::File, "a.txt");
+    a->content = "gen";
+    root->add_child(std::move(a));
+    auto b = std::make_unique<Node>(Node::Type::File, "b.txt");
+    b->content = "gen";
+    root->add_child(std::move(b));
+
+    // No manifest yet, so every entry is new and none of them may clobber
+    FileGenerator::Options options;
+    options.incremental = true;
+    auto result = FileGenerator(options).generate(*root, out);
+    REQUIRE(result.is_ok());
+    REQUIRE(result.value().files_created == 1);
+    REQUIRE(result.value().files_skipped == 1);
+
+    std::ifstream kept(out / "a.txt");
+    std::string content((std::istreambuf_iterator<char>(kept)), std::istreambuf_iterator<char>());
+    REQUIRE(content == "USER DATA");
+    REQUIRE(std::filesystem::file_size(out / "b.txt") == 3);
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("FileGenerator dedup materializes repeated content once", "[generator]") {
+    const std::string license(8192, 'L');
+
+    auto root = std::make_unique<Node>(Node::Type::Directory, "root");
+    for (int i = 0; i < 3; ++i) {
+        auto service = std::make_unique<Node>(Node::Type::Directory, "service" + std::to_string(i));
+        auto file = std::make_unique<Node>(Node::Type::File, "LICENSE");
+        file->content = license;
+        service->add_child(std::move(file));
+        auto own = std::make_unique<Node>(Node::Type::File, "main.cpp");
+        own->content = std::string(5000, static_cast<char>('a' + i));
+        service->add_child(std::move(own));
+        root->add_child(std::move(service));
+    }
+
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_dedup_test";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base);
+
+    auto read_all = [](const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    };
+
+    for (auto kind : {BackendKind::DirectoryFd, BackendKind::IoUring}) {
+        for (bool hardlinks : {false, true}) {
+            auto out = base / ((kind == BackendKind::IoUring ? "uring" : "fd") +
+                               std::string(hardlinks ? "_link" : "_plain"));
+
+            FileGenerator::Options options;
+            options.backend = kind;
+            options.dedup = true;
+            options.dedup_hardlinks = hardlinks;
+
+            auto result = FileGenerator(options).generate(*root, out);
+            REQUIRE(result.is_ok());
+            REQUIRE(result.value().files_created == 6);
+
+            // Without reflink support, plain mode writes every copy
+            const auto& stats = result.value();
+            REQUIRE(stats.total_size + stats.bytes_saved == 3 * license.size() + 3 * 5000);
+            if (hardlinks) {
+                REQUIRE(stats.bytes_saved == 2 * license.size());
+            }
+
+            for (int i = 0; i < 3; ++i) {
+                auto service = out / ("service" + std::to_string(i));
+                REQUIRE(read_all(service / "LICENSE") == license);
+                REQUIRE(std::filesystem::file_size(service / "main.cpp") == 5000);
+            }
+        }
+    }
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("FileGenerator overwrites do not write through hard links", "[generator]") {
+    const std::string shared(8192, 'S');
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_dedup_overwrite_test";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base);
+
+    auto read_all = [](const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    };
+
+    for (auto kind : {BackendKind::DirectoryFd, BackendKind::IoUring}) {
+        auto out = base / (kind == BackendKind::IoUring ? "uring" : "fd");
+
+        auto root = std::make_unique<Node>(Node::Type::Directory, "root");
+        for (const char* name : {"a.txt", "b.txt"}) {
+            auto file = std::make_unique<Node>(Node::Type::File, name);
+            file->content = shared;
+            root->add_child(std::move(file));
+        }
+
+        FileGenerator::Options options;
+        options.backend = kind;
+        options.incremental = true;
+        options.dedup = true;
+        options.dedup_hardlinks = true;
+        REQUIRE(FileGenerator(options).generate(*root, out).is_ok());
+
+        // a.txt changes; b.txt, possibly linked to it, must keep its bytes
+        root->children[0]->content = std::string(8192, 'A');
+        auto changed = FileGenerator(options).generate(*root, out);
+        REQUIRE(changed.is_ok());
+        REQUIRE(changed.value().files_created == 1);
+        REQUIRE(read_all(out / "a.txt") == root->children[0]->content);
+        REQUIRE(read_all(out / "b.txt") == shared);
+
+        // Plain overwrites replace the file rather than its shared inode too
+        options.incremental = false;
+        options.overwrite = true;
+        root->children[0]->content = shared;
+        REQUIRE(FileGenerator(options).generate(*root, out).is_ok());
+        root->children[1]->content = "b alone";
+        options.dedup = false;
+        REQUIRE(FileGenerator(options).generate(*root, out).is_ok());
+        REQUIRE(read_all(out / "a.txt") == shared);
+        REQUIRE(read_all(out / "b.txt") == "b alone");
+    }
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("FileGenerator streams trees into deterministic tar archives", "[generator]") {
+    auto root = std::make_unique<Node>(Node::Type::Directory, "proj");
+    auto src = std::make_unique<Node>(Node::Type::Directory, "src");
+    auto main_file = std::make_unique<Node>(Node::Type::File, "main.cpp");
+    main_file->content = "int main() {}\n";
+    src->add_child(std::move(main_file));
+    auto deep = std::make_unique<Node>(Node::Type::File, std::string(120, 'n'));
+    deep->content = std::string(700, 'x');
+    src->add_child(std::move(deep));
+    root->add_child(std::move(src));
+    root->add_child(std::make_unique<Node>(Node::Type::File, "empty"));
+
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_tar_test";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base);
+
+    auto archive = [&](const std::string& name) {
+        auto path = base / name;
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        REQUIRE(fd >= 0);
+
+        TarBackend sink(fd);
+        FileGenerator::Options options;
+        options.sink = &sink;
+        auto result = FileGenerator(options).generate(*root, "proj");
+        ::close(fd);
+
+        REQUIRE(result.is_ok());
+        REQUIRE(result.value().files_created == 3);
+        REQUIRE(result.value().dirs_created == 2);
+
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    };
+
+    auto first = archive("a.tar");
+    REQUIRE(first == archive("b.tar"));
+    REQUIRE(first.size() % 512 == 0);
+    REQUIRE(first.substr(first.size() - 1024) == std::string(1024, '\0'));
+    REQUIRE_FALSE(std::filesystem::exists(base / "proj"));
+
+    auto field = [&](size_t header, size_t offset, size_t width) {
+        auto value = first.substr(header + offset, width);
+        return value.substr(0, value.find('\0'));
+    };
+
+    // A directory's children are emitted before descending into it:
+    // proj/, proj/src/, proj/empty, proj/src/main.cpp, then a pax header
+    // carrying the long name
+    REQUIRE(field(0, 0, 100) == "proj/");
+    REQUIRE(first[156] == '5');
+    REQUIRE(field(0, 257, 6) == "ustar");
+    REQUIRE(field(512, 0, 100) == "proj/src/");
+    REQUIRE(field(1024, 0, 100) == "proj/empty");
+    REQUIRE(field(1536, 0, 100) == "proj/src/main.cpp");
+    REQUIRE(field(1536, 124, 12) == "00000000016");
+    REQUIRE(first.substr(2048, 14) == "int main() {}\n");
+
+    // Checksum: unsigned byte sum with the checksum field read as spaces
+    unsigned sum = 0;
+    for (size_t i = 0; i < 512; ++i) {
+        sum += (i >= 148 && i < 156) ? ' ' : static_cast<unsigned char>(first[1536 + i]);
+    }
+    REQUIRE(std::stoul(field(1536, 148, 8), nullptr, 8) == sum);
+
+    REQUIRE(first[2560 + 156] == 'x');
+    std::string long_name = "proj/src/" + std::string(120, 'n');
+    auto record = std::to_string(long_name.size() + 10) + " path=" + long_name + "\n";
+    REQUIRE(first.substr(3072, record.size()) == record);
+    REQUIRE(first[3584 + 156] == '0');
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("FileGenerator checks entry names before writing to a sink", "[generator]") {
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_tar_names_test";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base);
+
+    auto archive_size = [&](const Node& root, const std::filesystem::path& prefix = "proj") {
+        auto path = base / "out.tar";
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        REQUIRE(fd >= 0);
+
+        TarBackend sink(fd);
+        FileGenerator::Options options;
+        options.sink = &sink;
+        auto result = FileGenerator(options).generate(root, prefix);
+        ::close(fd);
+
+        REQUIRE(result.is_error());
+        REQUIRE(result.error().code == yaqeen::ErrorCode::InvalidInput);
+        return std::filesystem::file_size(path);
+    };
+
+    auto escaping = std::make_unique<Node>(Node::Type::Directory, "proj");
+    escaping->add_child(std::make_unique<Node>(Node::Type::File, "../evil.sh"));
+    REQUIRE(archive_size(*escaping) == 0);
+
+    auto duplicated = std::make_unique<Node>(Node::Type::Directory, "proj");
+    duplicated->add_child(std::make_unique<Node>(Node::Type::File, "a.txt"));
+    duplicated->add_child(std::make_unique<Node>(Node::Type::File, "a.txt"));
+    REQUIRE(archive_size(*duplicated) == 0);
+
+    // The member prefix must not climb out of the extraction directory either
+    auto plain = std::make_unique<Node>(Node::Type::Directory, "proj");
+    plain->add_child(std::make_unique<Node>(Node::Type::File, "a.txt"));
+    REQUIRE(archive_size(*plain, "../evil") == 0);
+    REQUIRE(archive_size(*plain, "nested/../../evil") == 0);
+    REQUIRE(archive_size(*plain, "/abs") == 0);
+
+    // Nothing is looked up on disk: "proj" does not exist and need not
+    REQUIRE_FALSE(std::filesystem::exists(base / "proj"));
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("GenerationPlan lays out child blocks and is reusable", "[generator]") {
+    // root/{a/{x.txt, b/{y.txt}}, c/, z.txt}
+    auto root = std::make_unique<Node>(Node::Type::Directory, "root");
+    auto a = std::make_unique<Node>(Node::Type::Directory, "a");
+    auto x = std::make_unique<Node>(Node::Type::File, "x.txt");
+    x->content = "xx";
+    a->add_child(std::move(x));
+    auto b = std::make_unique<Node>(Node::Type::Directory, "b");
+    auto y = std::make_unique<Node>(Node::Type::File, "y.txt");
+    y->content = "yyy";
+    b->add_child(std::move(y));
+    a->add_child(std::move(b));
+    root->add_child(std::move(a));
+    root->add_child(std::make_unique<Node>(Node::Type::Directory, "c"));
+    root->add_child(std::make_unique<Node>(Node::Type::File, "z.txt"));
+
+    auto plan = GenerationPlan::compile(*root);
+    REQUIRE(plan.size() == 7);
+    REQUIRE(plan.directory_count() == 4);
+    REQUIRE(plan.file_count() == 3);
+    REQUIRE(plan.content_bytes() == 5);
+
+    // root | a c z.txt | x.txt b | y.txt
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < plan.size(); ++i) {
+        paths.push_back(plan.relative_path(i));
+        if (i > 0) {
+            REQUIRE(plan[i].parent < i);
+        }
+    }
+    REQUIRE(paths == std::vector<std::string>{"", "a", "c", "z.txt", "a/x.txt", "a/b", "a/b/y.txt"});
+    REQUIRE(plan[0].first_child == 1);
+    REQUIRE(plan[0].child_count == 3);
+    REQUIRE(plan[1].first_child == 4);
+    REQUIRE(plan[1].child_count == 2);
+    REQUIRE(plan[2].child_count == 0);
+    REQUIRE(plan[6].depth == 3);
+    REQUIRE(plan[6].content == "yyy");
+
+    // Keeping y.txt keeps the directories leading to it
+    std::vector<bool> keep(plan.size(), false);
+    keep[6] = true;
+    auto subset = plan.subset(keep);
+    REQUIRE(subset.size() == 4);
+    REQUIRE(subset.relative_path(3) == "a/b/y.txt");
+    REQUIRE(subset[1].first_child == 2);
+    REQUIRE(subset[1].child_count == 1);
+
+    std::ostringstream printed;
+    plan.print(printed);
+    REQUIRE(printed.str().find("root/a/b/y.txt\n") != std::string::npos);
+
+    // One plan, two output directories, same progress sequence
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_plan_test";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base);
+
+    for (const char* name : {"first", "second"}) {
+        std::vector<std::string> order;
+        FileGenerator::Options options;
+        options.progress_callback = [&](const std::filesystem::path& path, bool, size_t, size_t) {
+            order.push_back(path.lexically_relative(base / name).generic_string());
+        };
+
+        auto result = FileGenerator(options).generate(plan, base / name);
+        REQUIRE(result.is_ok());
+        REQUIRE(result.value().files_created == 3);
+        REQUIRE(result.value().dirs_created == 4);
+        REQUIRE(order == std::vector<std::string>{".", "a", "c", "z.txt", "a/x.txt", "a/b", "a/b/y.txt"});
+    }
+    REQUIRE(std::filesystem::exists(base / "second" / "a" / "b" / "y.txt"));
+    REQUIRE(std::filesystem::is_directory(base / "first" / "c"));
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("GenerationPlan compiles a NodeStore like the Node tree it holds", "[generator]") {
+    nlohmann::json structure = {
+        {"src", {{"main.ts", "console.log(1);"}, {"lib", {{"util.ts", ""}}}}},
+        {"docs/", nullptr},
+        {"README.md", "# demo"}
+    };
+
+    auto tree = TemplateGenerator::json_to_store(structure, "demo");
+    REQUIRE(tree.is_ok());
+    auto root = TemplateGenerator::json_to_node_tree(structure, "demo");
+    REQUIRE(root.is_ok());
+
+    auto from_store = GenerationPlan::compile(tree.value());
+    auto from_node = GenerationPlan::compile(*root.value());
+    REQUIRE(from_store.size() == from_node.size());
+    REQUIRE(from_store.content_bytes() == from_node.content_bytes());
+    for (size_t i = 0; i < from_store.size(); ++i) {
+        REQUIRE(from_store.relative_path(i) == from_node.relative_path(i));
+        REQUIRE(from_store[i].parent == from_node[i].parent);
+        REQUIRE(from_store[i].first_child == from_node[i].first_child);
+        REQUIRE(from_store[i].child_count == from_node[i].child_count);
+        REQUIRE(from_store[i].is_directory == from_node[i].is_directory);
+        REQUIRE(from_store[i].content == from_node[i].content);
+    }
+
+    // Plan names are the store's own strings
+    REQUIRE(from_store[0].name == &tree.value().name(tree.value().root()));
+    REQUIRE(from_store.names_interned());
+    REQUIRE_FALSE(from_node.names_interned());
+
+    // Stores converted with one pool share name strings
+    auto names = std::make_shared<NamePool>();
+    auto first = TemplateGenerator::json_to_store(structure, "demo", names);
+    auto second = TemplateGenerator::json_to_store({{"src", {{"main.ts", ""}}}}, "other", names);
+    REQUIRE(first.is_ok());
+    REQUIRE(second.is_ok());
+    NodeId first_src = first.value().find_child(first.value().root(), "src");
+    NodeId second_src = second.value().find_child(second.value().root(), "src");
+    REQUIRE(&first.value().name(first_src) == &second.value().name(second_src));
+
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_store_test";
+    std::filesystem::remove_all(base);
+    auto result = FileGenerator(FileGenerator::Options{}).generate(tree.value(), base);
+    REQUIRE(result.is_ok());
+    REQUIRE(std::filesystem::is_directory(base / "docs"));
+    REQUIRE(std::filesystem::file_size(base / "src" / "main.ts") == 15);
+    REQUIRE(std::filesystem::exists(base / "src" / "lib" / "util.ts"));
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("TemplateGenerator merges directories named twice", "[generator]") {
+    nlohmann::json structure = {
+        {"src", {{"main.ts", ""}}},
+        {"src/", nullptr},
+        {"docs/", nullptr}
+    };
+    auto tree = TemplateGenerator::json_to_store(structure, "demo");
+    REQUIRE(tree.is_ok());
+    REQUIRE(tree.value().child_count(tree.value().root()) == 2);
+
+    nlohmann::json conflicting = {
+        {"lib", {{"a", {{"index.ts", ""}}}, {"a/", nullptr}}},
+        {"notes", "text"},
+        {"notes/", nullptr}
+    };
+    auto rejected = TemplateGenerator::json_to_node_tree(conflicting, "demo");
+    REQUIRE(rejected.is_error());
+    REQUIRE(rejected.error().code == yaqeen::ErrorCode::InvalidTemplateStructure);
+    REQUIRE(rejected.error().details == "notes");
+}
+
+TEST_CASE("FileGenerator writes markdown file contents from the document", "[generator]") {
+    const std::string markdown =
+        "```\n"
+        "app/\n"
+        "    main.cpp\n"
+        "    empty.txt\n"
+        "```\n"
+        "```cpp file=app/main.cpp\n"
+        "int main() { return 0; }\n"
+        "```\n";
+
+    MarkdownParser parser;
+    auto root = parser.parse_string(markdown);
+    REQUIRE(root.is_ok());
+
+    // Plan contents are views into the document the root keeps
+    auto plan = GenerationPlan::compile(*root.value());
+    auto source = root.value()->source->view();
+    REQUIRE(plan.content_bytes() == 25);
+    for (const auto& entry : plan.entries()) {
+        if (!entry.content.empty()) {
+            REQUIRE(entry.content.data() >= source.data());
+            REQUIRE(entry.content.data() + entry.content.size() <= source.data() + source.size());
+        }
+    }
+
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_span_test";
+    std::filesystem::remove_all(base);
+
+    auto result = FileGenerator(FileGenerator::Options{}).generate(plan, base);
+    REQUIRE(result.is_ok());
+    REQUIRE(result.value().total_size == 25);
+
+    std::ifstream in(base / "app" / "main.cpp", std::ios::binary);
+    std::string written((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    REQUIRE(written == "int main() { return 0; }\n");
+    REQUIRE(std::filesystem::file_size(base / "app" / "empty.txt") == 0);
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("Preflight rejects a whole plan before creating anything", "[generator]") {
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_preflight_test";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base / "out" / "docs");
+    std::ofstream(base / "out" / "src") << "not a directory";
+    std::ofstream(base / "out" / "README.md") << "old";
+
+    auto root = std::make_unique<Node>(Node::Type::Directory, "out");
+    auto src = std::make_unique<Node>(Node::Type::Directory, "src");
+    src->add_child(std::make_unique<Node>(Node::Type::File, "main.cpp"));
+    root->add_child(std::move(src));
+    root->add_child(std::make_unique<Node>(Node::Type::File, "docs"));
+    root->add_child(std::make_unique<Node>(Node::Type::File, "README.md"));
+    root->add_child(std::make_unique<Node>(Node::Type::File, "a.txt"));
+    root->add_child(std::make_unique<Node>(Node::Type::File, "a.txt"));
+    root->add_child(std::make_unique<Node>(Node::Type::File, ".."));
+
+    // All four problems are reported together and nothing is written
+    auto plan = GenerationPlan::compile(*root);
+    auto checked = preflight(plan, base / "out", PreflightOptions{});
+    REQUIRE(checked.is_error());
+    REQUIRE(checked.error().message.find("3 more problems") != std::string::npos);
+    REQUIRE(checked.error().details->find("Duplicate entry") != std::string::npos);
+    REQUIRE(checked.error().details->find("not a directory") != std::string::npos);
+    REQUIRE(checked.error().details->find("exists as a directory") != std::string::npos);
+
+    // The same tree as a store compares interned names
+    auto store = NodeStore::from_node(*root);
+    auto interned = GenerationPlan::compile(store);
+    REQUIRE(interned.names_interned());
+    auto rechecked = preflight(interned, base / "out", PreflightOptions{});
+    REQUIRE(rechecked.is_error());
+    REQUIRE(rechecked.error().details->find("Duplicate entry") != std::string::npos);
+
+    auto result = FileGenerator(FileGenerator::Options{}).generate(plan, base / "out");
+    REQUIRE(result.is_error());
+    REQUIRE_FALSE(std::filesystem::exists(base / "out" / "a.txt"));
+
+    // A valid plan reports what it will need; existing entries cost nothing
+    auto clean = std::make_unique<Node>(Node::Type::Directory, "out");
+    auto readme = std::make_unique<Node>(Node::Type::File, "README.md");
+    readme->content = "new";
+    clean->add_child(std::move(readme));
+    clean->add_child(std::make_unique<Node>(Node::Type::Directory, "docs"));
+    auto notes = std::make_unique<Node>(Node::Type::File, "notes.txt");
+    notes->content = std::string(5000, 'n');
+    clean->add_child(std::move(notes));
+
+    auto report = preflight(GenerationPlan::compile(*clean), base / "out", PreflightOptions{});
+    REQUIRE(report.is_ok());
+    REQUIRE(report.value().existing_files == 1);
+    REQUIRE(report.value().existing_dirs == 2);
+    REQUIRE(report.value().inodes_needed == 1);
+    REQUIRE(report.value().bytes_needed >= 5000);
+    REQUIRE(report.value().bytes_needed <= report.value().bytes_available);
+
+    auto missing = preflight(GenerationPlan::compile(*clean), base / "no" / "out", PreflightOptions{});
+    REQUIRE(missing.is_error());
+    REQUIRE(missing.error().code == yaqeen::ErrorCode::DirectoryNotFound);
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("FileGenerator streams markdown into the tree while it is read", "[generator]") {
+    // Large enough to span several read chunks and queue batches
+    std::string spec = "# Layout\n\n```\n";
+    for (int p = 0; p < 40; ++p) {
+        spec += "pkg" + std::to_string(p) + "/\n";
+        for (int m = 0; m < 5; ++m) {
+            spec += "\xE2\x94\x9C\xE2\x94\x80\xE2\x94\x80 mod" + std::to_string(m) + "/\n";
+            for (int f = 0; f < 60; ++f) {
+                spec += "\xE2\x94\x82   \xE2\x94\x9C\xE2\x94\x80\xE2\x94\x80 file" + std::to_string(f) + ".ts\n";
+            }
+        }
+        spec += "\xE2\x94\x94\xE2\x94\x80\xE2\x94\x80 README.md\n";
+    }
+    spec += "```\n";
+    REQUIRE(spec.size() > 2 * 64 * 1024);
+
+    // Entries arrive in document order with the depth their nodes have
+    MarkdownParser parser;
+    auto tree = parser.parse_string(spec);
+    REQUIRE(tree.is_ok());
+    auto plan = GenerationPlan::compile(*tree.value());
+
+    std::istringstream in(spec);
+    std::vector<std::pair<uint32_t, std::string>> streamed;
+    auto parsed = parser.parse_stream(in, [&](StreamEntry&& entry) {
+        streamed.emplace_back(entry.depth, entry.name);
+        return true;
+    });
+    REQUIRE(parsed.is_ok());
+    REQUIRE(streamed.size() == plan.size() - 1);
+    REQUIRE(streamed[0] == std::make_pair(1u, std::string("pkg0")));
+    REQUIRE(streamed[1] == std::make_pair(2u, std::string("mod0")));
+    REQUIRE(streamed[2] == std::make_pair(3u, std::string("file0.ts")));
+
+    // emit can stop the parser early
+    std::istringstream again(spec);
+    size_t seen = 0;
+    REQUIRE(parser.parse_stream(again, [&](StreamEntry&&) { return ++seen < 3; }).is_ok());
+    REQUIRE(seen == 3);
+
+    std::istringstream prose("no tree here\n");
+    REQUIRE(parser.parse_stream(prose, [](StreamEntry&&) { return true; }).is_error());
+
+    // Streaming produces what generating the parsed tree does
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_stream_test";
+    std::filesystem::remove_all(base);
+
+    std::istringstream piped(spec);
+    size_t progress = 0;
+    bool in_order = true;
+    FileGenerator::Options options;
+    options.progress_callback = [&](const std::filesystem::path&, bool, size_t current, size_t total) {
+        in_order = in_order && current == ++progress && total == 0;
+    };
+    auto streamed_stats = FileGenerator(options).generate_streaming(piped, base / "streamed", 2);
+    REQUIRE(streamed_stats.is_ok());
+
+    auto whole_stats = FileGenerator(FileGenerator::Options{}).generate(plan, base / "whole");
+    REQUIRE(whole_stats.is_ok());
+    REQUIRE(streamed_stats.value().dirs_created == whole_stats.value().dirs_created);
+    REQUIRE(streamed_stats.value().files_created == whole_stats.value().files_created);
+    REQUIRE(in_order);
+    REQUIRE(progress == plan.size());
+
+    size_t matching = 0;
+    for (size_t i = 1; i < plan.size(); ++i) {
+        auto path = base / "streamed" / plan.relative_path(i);
+        if (std::filesystem::exists(path) && std::filesystem::is_directory(path) == plan[i].is_directory) {
+            matching++;
+        }
+    }
+    REQUIRE(matching == plan.size() - 1);
+
+    // Nothing is created for input without a tree
+    std::istringstream empty("just prose\n");
+    auto failed = FileGenerator(FileGenerator::Options{}).generate_streaming(empty, base / "none");
+    REQUIRE(failed.is_error());
+    REQUIRE(failed.error().code == yaqeen::ErrorCode::InvalidMarkdownFormat);
+    REQUIRE_FALSE(std::filesystem::exists(base / "none"));
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("FileGenerator stream consumer rejects malformed entries", "[generator]") {
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_stream_reject_test";
+    std::filesystem::remove_all(base);
+
+    auto run = [&](EntryBatch batch, FileGenerator::Options options = {}) {
+        EntryQueue queue(1);
+        REQUIRE(queue.push(std::move(batch)));
+        queue.close();
+        auto result = FileGenerator(options).generate_stream(queue, base);
+        if (result.is_error()) {
+            // The producer side is told to stop
+            REQUIRE(queue.cancelled());
+        }
+        return result;
+    };
+
+    auto nested_in_file = run({{1, "notes.txt", false}, {2, "inner", true}});
+    REQUIRE(nested_in_file.is_error());
+    REQUIRE(nested_in_file.error().code == yaqeen::ErrorCode::InvalidTemplateStructure);
+    REQUIRE(nested_in_file.error().message.find("inside file") != std::string::npos);
+
+    // A stream rejected at its first entry does not create the output root
+    std::filesystem::remove_all(base);
+    auto escaping = run({{1, "..", true}});
+    REQUIRE(escaping.is_error());
+    REQUIRE_FALSE(std::filesystem::exists(base));
+
+    auto orphan = run({{3, "lost", true}});
+    REQUIRE(orphan.is_error());
+
+    FileGenerator::Options atomic;
+    atomic.atomic = true;
+    REQUIRE(run({{1, "src", true}}, atomic).is_error());
+
+    // Files after a nested directory go back to their own parent
+    auto ok = run({{1, "src", true}, {2, "lib", true}, {3, "a.rs", false}, {2, "main.rs", false}, {1, "b.md", false}});
+    REQUIRE(ok.is_ok());
+    REQUIRE(ok.value().dirs_created == 3);
+    REQUIRE(ok.value().files_created == 3);
+    REQUIRE(std::filesystem::is_regular_file(base / "src" / "lib" / "a.rs"));
+    REQUIRE(std::filesystem::is_regular_file(base / "src" / "main.rs"));
+    REQUIRE(std::filesystem::is_regular_file(base / "b.md"));
+
+    // A full queue holds the producer back until the consumer catches up
+    EntryQueue queue(1);
+    REQUIRE(queue.push({{1, "first", false}}));
+    std::atomic<bool> pushed{false};
+    std::thread producer([&] {
+        pushed = queue.push({{1, "second", false}});
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE_FALSE(pushed);
+    EntryBatch batch;
+    REQUIRE(queue.pop(batch));
+    producer.join();
+    REQUIRE(pushed);
+    queue.cancel();
+    REQUIRE_FALSE(queue.pop(batch));
+    REQUIRE_FALSE(queue.push({}));
+
+    std::filesystem::remove_all(base);
+}
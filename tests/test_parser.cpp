@@ -1,5 +1,20 @@
 #include <catch2/catch_test_macros.hpp>
 #include "yaqeen/core/parser.hpp"
+#include "yaqeen/core/glyph_scan.hpp"
+#include "yaqeen/core/path_list.hpp"
+#include "yaqeen/core/tree_walk.hpp"
+#include "yaqeen/utils/mapped_file.hpp"
+#include <filesystem>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace yaqeen::core;
 
@@ -45,9 +60,12 @@ project/
     auto& root = result.value();
     REQUIRE(root != nullptr);
 
-    // Check for files in the tree
+    // Branches nest the files under the directory above them
+    const Node* project = root->find_child("project");
+    REQUIRE(project != nullptr);
+
     bool hasFiles = false;
-    for (const auto& child : root->children) {
+    for (const auto& child : project->children) {
         if (child->is_file()) {
             hasFiles = true;
             break;
@@ -94,3 +112,704 @@ TEST_CASE("TreeVisualizer generates correct output", "[parser]") {
     REQUIRE(output.find("src") != std::string::npos);
     REQUIRE(output.find("main.cpp") != std::string::npos);
 }
+
+TEST_CASE("MarkdownParser scans lines without copying them", "[parser]") {
+    std::string markdown =
+        "# Layout\n"
+        "Some prose without structure\n"
+        "```\r\n"
+        "app/\r\n"
+        "    src/\r\n"
+        "        main.cpp  \r\n"
+        "    README.md\r\n"
+        "\xE2\x94\x94\xE2\x94\x80\xE2\x94\x80 docs/\r\n"
+        "```\r\n"
+        "Trailing prose\n";
+
+    MarkdownParser parser;
+    auto result = parser.parse_string(markdown);
+    REQUIRE(result.is_ok());
+
+    auto& root = result.value();
+    REQUIRE(root->children.size() == 1);
+
+    const Node* app = root->find_child("app");
+    REQUIRE(app != nullptr);
+    REQUIRE(app->is_directory());
+    REQUIRE(app->children.size() == 3);
+
+    const Node* src = app->find_child("src");
+    REQUIRE(src != nullptr);
+    REQUIRE(src->find_child("main.cpp") != nullptr);
+    REQUIRE(src->find_child("main.cpp")->is_file());
+    REQUIRE(app->find_child("README.md") != nullptr);
+
+    // Glyphs are stripped from names; a name without an extension is a directory
+    const Node* docs = app->find_child("docs");
+    REQUIRE(docs != nullptr);
+    REQUIRE(docs->is_directory());
+
+    // An unterminated last line is still read
+    auto unterminated = parser.parse_string("```\nonly.txt");
+    REQUIRE(unterminated.is_ok());
+    REQUIRE(unterminated.value()->find_child("only.txt") != nullptr);
+
+    REQUIRE(parser.parse_string("no structure here\n").is_error());
+}
+
+TEST_CASE("MarkdownParser measures tree prefixes in display columns", "[parser]") {
+    MarkdownParser parser;
+
+    auto expect_nested = [](const Node& root) {
+        const Node* app = root.find_child("app");
+        REQUIRE(app != nullptr);
+        REQUIRE(root.children.size() == 1);
+        REQUIRE(app->children.size() == 2);
+
+        const Node* src = app->find_child("src");
+        REQUIRE(src != nullptr);
+        REQUIRE(src->children.size() == 2);
+        REQUIRE(src->find_child("main.cpp") != nullptr);
+
+        const Node* util = src->find_child("util");
+        REQUIRE(util != nullptr);
+        REQUIRE(util->find_child("io.cpp") != nullptr);
+        REQUIRE(app->find_child("README.md") != nullptr);
+    };
+
+    SECTION("Unicode branches") {
+        auto result = parser.parse_string(
+            "```\n"
+            "app/\n"
+            "\xE2\x94\x9C\xE2\x94\x80\xE2\x94\x80 src/\n"
+            "\xE2\x94\x82   \xE2\x94\x9C\xE2\x94\x80\xE2\x94\x80 main.cpp\n"
+            "\xE2\x94\x82   \xE2\x94\x94\xE2\x94\x80\xE2\x94\x80 util/\n"
+            "\xE2\x94\x82       \xE2\x95\xB0\xE2\x94\x80\xE2\x94\x80 io.cpp\n"
+            "\xE2\x94\x94\xE2\x94\x80\xE2\x94\x80 README.md\n"
+            "```\n");
+        REQUIRE(result.is_ok());
+        expect_nested(*result.value());
+    }
+
+    SECTION("ASCII branches") {
+        auto result = parser.parse_string(
+            "```\n"
+            "app/\n"
+            "|-- src/\n"
+            "|   |-- main.cpp\n"
+            "|   `-- util/\n"
+            "|       +-- io.cpp\n"
+            "`-- README.md\n"
+            "```\n");
+        REQUIRE(result.is_ok());
+        expect_nested(*result.value());
+    }
+
+    SECTION("tree(1) output with no-break spaces") {
+        auto result = parser.parse_string(
+            "```\n"
+            "app/\n"
+            "\xE2\x94\x9C\xE2\x94\x80\xE2\x94\x80 src/\n"
+            "\xE2\x94\x82\xC2\xA0\xC2\xA0 \xE2\x94\x9C\xE2\x94\x80\xE2\x94\x80 main.cpp\n"
+            "\xE2\x94\x82\xC2\xA0\xC2\xA0 \xE2\x94\x94\xE2\x94\x80\xE2\x94\x80 util/\n"
+            "\xE2\x94\x82\xC2\xA0\xC2\xA0 \xC2\xA0\xC2\xA0\xC2\xA0 \xE2\x94\x94\xE2\x94\x80\xE2\x94\x80 io.cpp\n"
+            "\xE2\x94\x94\xE2\x94\x80\xE2\x94\x80 README.md\n"
+            "```\n");
+        REQUIRE(result.is_ok());
+        expect_nested(*result.value());
+    }
+
+    SECTION("Tabs count as one level") {
+        auto result = parser.parse_string("```\napp/\n\tsrc/\n\t\tmain.cpp\n\t\tutil/\n\t\t\tio.cpp\n\tREADME.md\n```\n");
+        REQUIRE(result.is_ok());
+        expect_nested(*result.value());
+    }
+}
+
+TEST_CASE("Glyph scanners agree with the scalar classifier", "[parser]") {
+    // Long prefixes and glyphs straddling 16- and 32-byte windows
+    std::string deep;
+    for (int i = 0; i < 9; ++i) {
+        deep += "\xE2\x94\x82   ";
+    }
+    deep += "\xE2\x94\x94\xE2\x94\x80\xE2\x94\x80 leaf.txt";
+
+    std::vector<std::string> lines = {
+        "",
+        "```tree",
+        "src/",
+        "    |-- lib.rs",
+        "|   |   |   |   |   |   |   |   |   `-- deep-name.md",
+        "  \xE2\x94\x9C\xE2\x94\x80\xE2\x94\x80 a \xE2\x94\x82 b.txt \xE2\x94\x82\r",
+        "-- not a branch",
+        "\xE2\x82\xAC euro.txt",
+        "\xE2\x94 truncated",
+        std::string(70, ' ') + "far/",
+        deep,
+    };
+
+    auto expected_deep = classify_line(deep, GlyphScanner::Scalar);
+    REQUIRE(expected_deep.prefix_columns == 40);
+    REQUIRE(deep.substr(expected_deep.prefix_bytes, expected_deep.name_end - expected_deep.prefix_bytes) == "leaf.txt");
+
+    for (auto scanner : {GlyphScanner::Auto, GlyphScanner::SSE2, GlyphScanner::AVX2}) {
+        for (const auto& line : lines) {
+            auto expected = classify_line(line, GlyphScanner::Scalar);
+            auto actual = classify_line(line, scanner);
+            INFO(glyph_scanner_name(scanner) << ": " << line);
+            REQUIRE(actual.prefix_bytes == expected.prefix_bytes);
+            REQUIRE(actual.prefix_columns == expected.prefix_columns);
+            REQUIRE(actual.name_end == expected.name_end);
+            REQUIRE(actual.has_glyph == expected.has_glyph);
+            REQUIRE(actual.has_dot == expected.has_dot);
+            REQUIRE(actual.has_slash == expected.has_slash);
+            REQUIRE(actual.has_fence == expected.has_fence);
+        }
+    }
+}
+
+TEST_CASE("MarkdownParser reads the tree only from fenced tree blocks", "[parser]") {
+    std::string markdown =
+        "# Design notes\n"
+        "\n"
+        "The loader reads config.json from /etc, see ``` in the style guide.\n"
+        "Paths like src/main.cpp are prose, not entries.\n"
+        "\n"
+        "```cpp\n"
+        "int main() { return load(\"config.json\"); }\n"
+        "```\n"
+        "\n"
+        "```tree\n"
+        "app/\n"
+        "\xE2\x94\x9C\xE2\x94\x80\xE2\x94\x80 src/\n"
+        "\xE2\x94\x82   \xE2\x94\x94\xE2\x94\x80\xE2\x94\x80 main.cpp\n"
+        "\xE2\x94\x94\xE2\x94\x80\xE2\x94\x80 README.md\n"
+        "```\n"
+        "\n"
+        "More prose.\n"
+        "\n"
+        "  ~~~~ text\n"
+        "  docs/\n"
+        "      guide.md\n"
+        "  ~~~~~\n"
+        "docs.md\n";
+
+    MarkdownParser parser;
+    auto result = parser.parse_string(markdown);
+    REQUIRE(result.is_ok());
+
+    // Prose, the inline ``` and the cpp block add nothing
+    auto& root = result.value();
+    REQUIRE(root->children.size() == 2);
+
+    const Node* app = root->find_child("app");
+    REQUIRE(app != nullptr);
+    REQUIRE(app->children.size() == 2);
+    REQUIRE(app->find_child("src") != nullptr);
+    REQUIRE(app->find_child("src")->find_child("main.cpp") != nullptr);
+
+    // The fence's own indent is stripped, and a longer run closes it
+    const Node* docs = root->find_child("docs");
+    REQUIRE(docs != nullptr);
+    REQUIRE(docs->find_child("guide.md") != nullptr);
+    REQUIRE(root->find_child("docs.md") == nullptr);
+
+    // The streaming path picks out the same blocks
+    std::istringstream in(markdown);
+    std::string streamed;
+    auto status = parser.parse_stream(in, [&](StreamEntry&& entry) {
+        streamed += std::to_string(entry.depth) + " " + entry.name + "\n";
+        return true;
+    });
+    REQUIRE(status.is_ok());
+    REQUIRE(streamed == "1 app\n2 src\n3 main.cpp\n2 README.md\n1 docs\n2 guide.md\n");
+
+    // Code in other languages is never read as a tree
+    REQUIRE(parser.parse_string("```python\nsetup.py\nsrc/\n```\n").is_error());
+    std::istringstream code("```python\nsetup.py\n```\n");
+    REQUIRE(parser.parse_stream(code, [](StreamEntry&&) { return true; }).is_error());
+}
+
+TEST_CASE("MarkdownParser attaches file= blocks as spans of the document", "[parser]") {
+    std::string markdown =
+        "```tree\n"
+        "app/\n"
+        "\xE2\x94\x9C\xE2\x94\x80\xE2\x94\x80 src/\n"
+        "\xE2\x94\x82   \xE2\x94\x94\xE2\x94\x80\xE2\x94\x80 main.cpp\n"
+        "\xE2\x94\x94\xE2\x94\x80\xE2\x94\x80 README.md\n"
+        "```\n"
+        "\n"
+        "```cpp file=app/src/main.cpp\n"
+        "int main() {}\n"
+        "```\n"
+        "\n"
+        "~~~~ text file=\"app/README.md\"\n"
+        "# App\n"
+        "```\n"
+        "  indented/\n"
+        "```\n"
+        "~~~~\n";
+
+    MarkdownParser parser;
+    auto result = parser.parse_string(markdown);
+    REQUIRE(result.is_ok());
+
+    // Content blocks are never read as trees, even when tagged text
+    auto& root = result.value();
+    REQUIRE(root->children.size() == 1);
+    const Node* app = root->find_child("app");
+    REQUIRE(app->children.size() == 2);
+
+    // The borrowed document is copied once into the root
+    REQUIRE(root->source != nullptr);
+    auto source = root->source->view();
+    REQUIRE(source == markdown);
+
+    const Node* main_cpp = app->find_child("src")->find_child("main.cpp");
+    REQUIRE_FALSE(main_cpp->content.has_value());
+    REQUIRE(source.substr(main_cpp->content_span.offset, main_cpp->content_span.length) == "int main() {}\n");
+
+    const Node* readme = app->find_child("README.md");
+    REQUIRE(source.substr(readme->content_span.offset, readme->content_span.length) ==
+            "# App\n```\n  indented/\n```\n");
+
+    // Without content blocks nothing is kept
+    REQUIRE(parser.parse_string("```\na.txt\n```\n").value()->source == nullptr);
+
+    // Paths must name a file of the tree, once, from an unindented fence
+    const std::string tree = "```\napp/\n    a.txt\n```\n";
+    REQUIRE(parser.parse_string(tree + "```file=app/b.txt\nb\n```\n").is_error());
+    REQUIRE(parser.parse_string(tree + "```file=app\nb\n```\n").is_error());
+    REQUIRE(parser.parse_string(tree + "```file=app/a.txt\n1\n```\n```file=./app/a.txt\n2\n```\n").is_error());
+    REQUIRE(parser.parse_string(tree + "  ```file=app/a.txt\nb\n  ```\n").is_error());
+
+    // An unterminated block runs to the end of the document
+    auto open = parser.parse_string(tree + "```file=app/a.txt\nlast line");
+    REQUIRE(open.is_ok());
+    const Node* a = open.value()->find_child("app")->find_child("a.txt");
+    REQUIRE(open.value()->source->view().substr(a->content_span.offset, a->content_span.length) == "last line");
+
+    // Streaming cannot go back to entries it has handed out
+    std::istringstream in(markdown);
+    REQUIRE(parser.parse_stream(in, [](StreamEntry&&) { return true; }).is_error());
+}
+
+TEST_CASE("MarkdownParser::parse reads mapped files and pipes", "[parser]") {
+    auto base = std::filesystem::temp_directory_path() / "yaqeen_mapped_test";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base);
+
+    const std::string spec = "```\napp/\n\xE2\x94\x94\xE2\x94\x80\xE2\x94\x80 main.cpp\n```\n";
+    std::ofstream(base / "spec.md", std::ios::binary) << spec;
+    std::ofstream(base / "empty.md").close();
+
+    auto mapped = yaqeen::MappedFile::open(base / "spec.md");
+    REQUIRE(mapped.is_ok());
+    REQUIRE(mapped.value().view() == spec);
+
+    // The view survives a move of its owner
+    auto moved = std::move(mapped.value());
+    REQUIRE(moved.view() == spec);
+
+    auto empty = yaqeen::MappedFile::open(base / "empty.md");
+    REQUIRE(empty.is_ok());
+    REQUIRE(empty.value().empty());
+
+    REQUIRE(yaqeen::MappedFile::open(base / "missing.md").error().code == yaqeen::ErrorCode::FileNotFound);
+    REQUIRE(yaqeen::MappedFile::open(base).error().code == yaqeen::ErrorCode::InvalidInput);
+
+    MarkdownParser parser;
+    auto result = parser.parse(base / "spec.md");
+    REQUIRE(result.is_ok());
+    REQUIRE(result.value()->find_child("app") != nullptr);
+    REQUIRE(result.value()->find_child("app")->find_child("main.cpp") != nullptr);
+    REQUIRE(result.value()->source == nullptr);
+
+    // A tree with file contents keeps the mapping instead of copying it
+    std::ofstream(base / "contents.md", std::ios::binary) << spec << "```file=app/main.cpp\nint main() {}\n```\n";
+    auto with_contents = parser.parse(base / "contents.md");
+    REQUIRE(with_contents.is_ok());
+    REQUIRE(with_contents.value()->source != nullptr);
+    REQUIRE(with_contents.value()->source->is_mapped());
+    REQUIRE(with_contents.value()->find_child("app")->find_child("main.cpp")->content_span.length == 14);
+
+    REQUIRE(parser.parse(base / "missing.md").is_error());
+
+#if defined(__unix__) || defined(__APPLE__)
+    // A FIFO has no size and cannot be mapped, so it is read instead
+    auto fifo = base / "spec.fifo";
+    REQUIRE(::mkfifo(fifo.c_str(), 0600) == 0);
+    std::thread writer([&] { std::ofstream(fifo, std::ios::binary) << spec; });
+    auto piped = yaqeen::MappedFile::open(fifo);
+    writer.join();
+    REQUIRE(piped.is_ok());
+    REQUIRE_FALSE(piped.value().is_mapped());
+    REQUIRE(piped.value().view() == spec);
+#endif
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("PathListParser builds trees from find-style path lists", "[parser]") {
+    const std::string sorted =
+        ".\n"
+        "./app\n"
+        "./app/README.md\n"
+        "./app/src\n"
+        "./app/src/main.cpp\n"
+        "./app/src/util/\n"
+        "./app/tests/\r\n"
+        "\n"
+        "docs/guide.md\n";
+
+    PathListParser parser;
+    auto result = parser.parse_string(sorted);
+    REQUIRE(result.is_ok());
+    REQUIRE(parser.stats().lines == 7);
+
+    // Listed in order, every component is found on the previous line's chain
+    // or is new: nothing goes through the index
+    REQUIRE(parser.stats().indexed_lookups == 0);
+
+    auto& root = result.value();
+    REQUIRE(root->name == "root");
+    REQUIRE(root->children.size() == 2);
+
+    // Directories without a trailing '/' are recognized by their entries
+    const Node* app = root->find_child("app");
+    REQUIRE(app != nullptr);
+    REQUIRE(app->is_directory());
+    REQUIRE(app->children.size() == 3);
+    REQUIRE(app->find_child("README.md")->is_file());
+    const Node* src = app->find_child("src");
+    REQUIRE(src->is_directory());
+    REQUIRE(src->find_child("main.cpp")->is_file());
+    REQUIRE(src->find_child("util")->is_directory());
+    REQUIRE(app->find_child("tests")->is_directory());
+    REQUIRE(root->find_child("docs")->find_child("guide.md") != nullptr);
+
+    // The same paths shuffled give the same tree through the index
+    std::vector<std::string> lines{"app/src/main.cpp", "docs/guide.md", "app/README.md", "app/tests/",
+                                   "app/src/util/", "app/src", "app/README.md", "app"};
+    std::string shuffled;
+    for (const auto& line : lines) {
+        shuffled += line + "\n";
+    }
+    auto unsorted = parser.parse_string(shuffled);
+    REQUIRE(unsorted.is_ok());
+    REQUIRE(parser.stats().indexed_lookups > 0);
+
+    auto sorted_children = [](const Node& node) {
+        std::vector<std::string> names;
+        for (const auto& child : node.children) {
+            names.push_back(child->name + (child->is_directory() ? "/" : ""));
+        }
+        std::sort(names.begin(), names.end());
+        return names;
+    };
+    const Node* shuffled_app = unsorted.value()->find_child("app");
+    REQUIRE(sorted_children(*shuffled_app) == sorted_children(*app));
+    REQUIRE(sorted_children(*shuffled_app->find_child("src")) == sorted_children(*src));
+
+    REQUIRE(parser.parse_string("/etc/passwd\n").is_error());
+    REQUIRE(parser.parse_string("app/../../escape\n").is_error());
+    REQUIRE(parser.parse_string("\n./\n").is_error());
+}
+
+TEST_CASE("NodeStore holds trees as linked indices and converts to Node", "[parser]") {
+    NodeStore store;
+    NodeId root = store.add_root("app");
+    NodeId src = store.add_child(root, "src", true);
+    NodeId main_cpp = store.add_child(src, "main.cpp", false);
+    NodeId readme = store.add_child(root, "README.md", false);
+    store.set_content(main_cpp, "int main() {}\n");
+
+    REQUIRE(store.size() == 4);
+    REQUIRE(store.first_child(root) == src);
+    REQUIRE(store.next_sibling(src) == readme);
+    REQUIRE(store.last_child(root) == readme);
+    REQUIRE(store.next_sibling(readme) == NodeStore::kNone);
+    REQUIRE(store.child_count(root) == 2);
+    REQUIRE(store.parent(main_cpp) == src);
+    REQUIRE(store.find_child(src, "main.cpp") == main_cpp);
+    REQUIRE(store.find_child(root, "main.cpp") == NodeStore::kNone);
+    REQUIRE(store.content(main_cpp) == "int main() {}\n");
+    REQUIRE(store.content(readme).empty());
+
+    // Names stay where they are when the store moves
+    const std::string* name = &store.name(main_cpp);
+    NodeStore moved = std::move(store);
+    REQUIRE(&moved.name(main_cpp) == name);
+
+    auto node = moved.to_node();
+    REQUIRE(node->name == "app");
+    REQUIRE(node->children.size() == 2);
+    REQUIRE(node->children[0]->find_child("main.cpp")->content == std::string("int main() {}\n"));
+    REQUIRE(node->children[1]->name == "README.md");
+    REQUIRE(node->to_string() == NodeStore::from_node(*node).to_node()->to_string());
+    REQUIRE(TreeVisualizer::visualize(moved, false) == TreeVisualizer::visualize(*node, false));
+
+    // The parsers build stores; file contents stay spans of the document
+    const std::string markdown =
+        "```\n"
+        "app/\n"
+        "    main.cpp\n"
+        "```\n"
+        "```cpp file=app/main.cpp\n"
+        "int x;\n"
+        "```\n";
+    MarkdownParser parser;
+    auto parsed = parser.parse_string_store(markdown);
+    REQUIRE(parsed.is_ok());
+    const NodeStore& tree = parsed.value();
+    REQUIRE(tree.source() != nullptr);
+    NodeId file = tree.find_child(tree.find_child(tree.root(), "app"), "main.cpp");
+    REQUIRE(file != NodeStore::kNone);
+    REQUIRE(tree.content(file) == "int x;\n");
+    REQUIRE(tree.content(file).data() >= tree.source()->view().data());
+
+    auto converted = tree.to_node();
+    REQUIRE(converted->source == tree.source());
+    REQUIRE(!converted->children[0]->children[0]->content);
+    REQUIRE(converted->children[0]->children[0]->content_span.length == 7);
+
+    PathListParser paths;
+    auto listed = paths.parse_string_store("b/y\na/x\na/\n");
+    REQUIRE(listed.is_ok());
+    REQUIRE(listed.value().size() == 5);
+    REQUIRE(listed.value().is_directory(listed.value().find_child(0, "a")));
+}
+
+TEST_CASE("NodeStore indexes wide directories and merges repeated siblings", "[parser]") {
+    NodeStore store;
+    NodeId root = store.add_root("root");
+    NodeId wide = store.add_child(root, "wide", true);
+    for (int i = 0; i < 50000; ++i) {
+        store.add_child(wide, "entry" + std::to_string(i) + ".txt", false);
+    }
+    REQUIRE(store.child_count(wide) == 50000);
+    REQUIRE(store.name(store.find_child(wide, "entry0.txt")) == "entry0.txt");
+    REQUIRE(store.name(store.find_child(wide, "entry49999.txt")) == "entry49999.txt");
+    REQUIRE(store.find_child(wide, "entry50000.txt") == NodeStore::kNone);
+    REQUIRE(store.find_child(root, "entry1.txt") == NodeStore::kNone);
+    REQUIRE(store.path(store.find_child(wide, "entry7.txt")) == "wide/entry7.txt");
+
+    auto again = store.place_child(root, "wide", true);
+    REQUIRE(again.kind == NodeStore::Placement::Merged);
+    REQUIRE(again.id == wide);
+    auto file = store.place_child(wide, "entry3.txt", false);
+    REQUIRE(file.kind == NodeStore::Placement::Conflict);
+    REQUIRE(store.place_child(wide, "entry3.txt", true).kind == NodeStore::Placement::Conflict);
+    REQUIRE(store.place_child(wide, "extra.txt", false).kind == NodeStore::Placement::Added);
+    REQUIRE(store.child_count(wide) == 50001);
+    REQUIRE(store.conflict(file, false, yaqeen::ErrorCode::InvalidInput).details == "wide/entry3.txt");
+
+    // A directory drawn twice in a spec is one directory
+    MarkdownParser parser;
+    auto merged = parser.parse_string(
+        "```\n"
+        "src/\n"
+        "    main.cpp\n"
+        "docs/\n"
+        "src/\n"
+        "    util.cpp\n"
+        "```\n");
+    REQUIRE(merged.is_ok());
+    REQUIRE(merged.value()->children.size() == 2);
+    REQUIRE(merged.value()->find_child("src")->children.size() == 2);
+
+    auto twice = parser.parse_string(
+        "```\n"
+        "src/\n"
+        "    main.cpp\n"
+        "    main.cpp\n"
+        "```\n");
+    REQUIRE(twice.is_error());
+    REQUIRE(twice.error().details == "src/main.cpp");
+
+    auto both = parser.parse_string(
+        "```\n"
+        "src/\n"
+        "    lib/\n"
+        "    lib.d/\n"
+        "    lib.d\n"
+        "```\n");
+    REQUIRE(both.is_error());
+}
+
+TEST_CASE("NamePool interns names shared across stores", "[parser]") {
+    NamePool pool;
+    NameId src = pool.intern("src");
+    REQUIRE(pool.intern("src") == src);
+    REQUIRE(pool.intern("tests") != src);
+    REQUIRE(pool.find("src") == src);
+    REQUIRE(pool.find("docs") == NamePool::kNone);
+    REQUIRE(pool.str(src) == "src");
+    REQUIRE(pool.hash(src) == NamePool::hash_of("src"));
+    for (int i = 0; i < 10000; ++i) {
+        pool.intern("name" + std::to_string(i));
+    }
+    REQUIRE(pool.size() == 10002);
+    REQUIRE(pool.find("name9999") == pool.intern("name9999"));
+    REQUIRE(pool.str(src) == "src");
+
+    // Trees parsed with one pool share their names
+    auto names = std::make_shared<NamePool>();
+    MarkdownParser parser(names);
+    auto first = parser.parse_string_store("```\napp/\n    src/\n        main.cpp\n```\n");
+    auto second = parser.parse_string_store("```\nlib/\n    src/\n        main.cpp\n```\n");
+    REQUIRE(first.is_ok());
+    REQUIRE(second.is_ok());
+    const NodeStore& a = first.value();
+    const NodeStore& b = second.value();
+    NodeId a_src = a.find_child(a.find_child(a.root(), "app"), "src");
+    NodeId b_src = b.find_child(b.find_child(b.root(), "lib"), "src");
+    REQUIRE(a.name_id(a_src) == b.name_id(b_src));
+    REQUIRE(&a.name(a_src) == &b.name(b_src));
+    REQUIRE(a.find_child(a_src, b.name_id(b.first_child(b_src))) == a.first_child(a_src));
+    REQUIRE(a.find_child(a.root(), "lib") == NodeStore::kNone);
+
+    PathListParser paths(names);
+    auto listed = paths.parse_string_store("app/src/main.cpp\n");
+    REQUIRE(listed.is_ok());
+    REQUIRE(listed.value().name_pool() == names);
+    REQUIRE(names->find("main.cpp") != NamePool::kNone);
+
+    // Without one, every store keeps its own
+    NodeStore own;
+    own.add_root("src");
+    REQUIRE(own.name_pool() != names);
+    REQUIRE(own.names().size() == 1);
+}
+
+TEST_CASE("walk_tree visits in pre and post order and stops early", "[parser]") {
+    NodeStore store;
+    NodeId root = store.add_root("root");
+    NodeId src = store.add_child(root, "src", true);
+    store.add_child(src, "main.cpp", false);
+    store.add_child(root, "docs", true);
+    store.add_child(root, "README.md", false);
+
+    std::string order;
+    walk_tree(StoreTree{store}, root,
+        [&](NodeId node, size_t depth) {
+            order += "+" + store.name(node) + std::to_string(depth);
+            return WalkAction::Continue;
+        },
+        [&](NodeId node, size_t depth) {
+            order += "-" + store.name(node) + std::to_string(depth);
+            return WalkAction::Continue;
+        });
+    REQUIRE(order == "+root0+src1+main.cpp2-main.cpp2-src1+docs1-docs1+README.md1-README.md1-root0");
+
+    // Skip leaves the children out but still closes the node
+    order.clear();
+    bool finished = walk_tree(StoreTree{store}, root,
+        [&](NodeId node, size_t) {
+            order += "+" + store.name(node);
+            return store.name(node) == "src" ? WalkAction::Skip : WalkAction::Continue;
+        },
+        [&](NodeId node, size_t) {
+            order += "-" + store.name(node);
+            return store.name(node) == "docs" ? WalkAction::Stop : WalkAction::Continue;
+        });
+    REQUIRE_FALSE(finished);
+    REQUIRE(order == "+root+src-src+docs-docs");
+
+    // Deep trees are walked, converted and freed without recursing
+    const size_t depth = 200000;
+    NodeStore deep;
+    NodeId last = deep.add_root("root");
+    for (size_t i = 0; i < depth; ++i) {
+        last = deep.add_child(last, "d", true);
+    }
+    deep.add_child(last, "leaf.txt", false);
+
+    size_t deepest = 0;
+    walk_tree(StoreTree{deep}, deep.root(), [&](NodeId, size_t level) {
+        deepest = std::max(deepest, level);
+        return WalkAction::Continue;
+    });
+    REQUIRE(deepest == depth + 1);
+
+    auto node = deep.to_node();
+    size_t nodes = 0;
+    bool stopped = !walk_tree(NodeTree{}, node.get(), [&](const Node* visited, size_t) {
+        ++nodes;
+        return visited->is_file() ? WalkAction::Stop : WalkAction::Continue;
+    });
+    REQUIRE(stopped);
+    REQUIRE(nodes == depth + 2);
+    REQUIRE(NodeStore::from_node(*node).size() == depth + 2);
+    node.reset();
+
+    // Rendering is quadratic in depth, so check it on a shallower chain
+    NodeStore chain;
+    last = chain.add_root("root");
+    for (int i = 0; i < 2000; ++i) {
+        last = chain.add_child(last, "d", true);
+    }
+    auto rendered = TreeVisualizer::visualize(chain, false);
+    REQUIRE(rendered.size() == 6 + 2000 * 3 + 4 * (2000 * 1999 / 2) + 2000 * 4);
+    REQUIRE(chain.to_node()->to_string().size() == 6 + 2000 * 3 + 2 * (2000 * 2001 / 2));
+}
+
+TEST_CASE("TreeVisualizer elides past depth and entry limits and streams to fds", "[parser]") {
+    NodeStore store;
+    NodeId root = store.add_root("root");
+    NodeId src = store.add_child(root, "src", true);
+    NodeId lib = store.add_child(src, "lib", true);
+    store.add_child(lib, "a.cpp", false);
+    store.add_child(lib, "b.cpp", false);
+    for (int i = 0; i < 5; ++i) {
+        store.add_child(src, "f" + std::to_string(i) + ".cpp", false);
+    }
+    store.add_child(root, "README.md", false);
+
+    TreeVisualizer::Options options;
+    options.use_unicode = false;
+    REQUIRE(TreeVisualizer::visualize(store, options) == TreeVisualizer::visualize(store, false));
+
+    options.max_entries_per_dir = 2;
+    REQUIRE(TreeVisualizer::visualize(store, options) ==
+            "root/\n"
+            "|-- src/\n"
+            "|   |-- lib/\n"
+            "|   |   |-- a.cpp\n"
+            "|   |   `-- b.cpp\n"
+            "|   |-- f0.cpp\n"
+            "|   `-- ... 4 more\n"
+            "`-- README.md\n");
+
+    options.max_entries_per_dir = 0;
+    options.max_depth = 1;
+    options.use_unicode = true;
+    REQUIRE(TreeVisualizer::visualize(store, options) ==
+            "root/\n"
+            "├── src/\n"
+            "│   └── … 6 more\n"
+            "└── README.md\n");
+
+    // Output far larger than the buffer arrives whole and in order
+    NodeStore wide;
+    NodeId top = wide.add_root("wide");
+    for (int i = 0; i < 20000; ++i) {
+        wide.add_child(top, "entry" + std::to_string(i) + ".txt", false);
+    }
+    auto expected = TreeVisualizer::visualize(wide, TreeVisualizer::Options{});
+
+#if defined(__unix__) || defined(__APPLE__)
+    auto path = std::filesystem::temp_directory_path() / "yaqeen_visualize_test.txt";
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    REQUIRE(fd >= 0);
+    REQUIRE(TreeVisualizer::write(wide, fd, TreeVisualizer::Options{}).is_ok());
+    ::close(fd);
+    std::ifstream in(path, std::ios::binary);
+    std::string written((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    REQUIRE(written.size() > 64 * 1024);
+    REQUIRE(written == expected);
+    std::filesystem::remove(path);
+
+    REQUIRE(TreeVisualizer::write(wide, -1, TreeVisualizer::Options{}).is_error());
+#endif
+}
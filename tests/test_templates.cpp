@@ -1,6 +1,11 @@
 #include <catch2/catch_test_macros.hpp>
 #include "yaqeen/core/template_manager.hpp"
+#include "yaqeen/core/template_pack.hpp"
 #include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
 
 using namespace yaqeen::core;
 
@@ -74,3 +79,273 @@ TEST_CASE("Template structure validation", "[templates]") {
     // Validation would be tested through manager methods
     REQUIRE(true); // Placeholder
 }
+
+TEST_CASE("Deep template structures are walked without recursion", "[templates]") {
+    const size_t depth = 100000;
+    Template tmpl;
+    tmpl.info.name = "deep";
+    tmpl.info.description = "Deeply nested";
+    tmpl.structure = nlohmann::json::object();
+    nlohmann::json* level = &tmpl.structure;
+    for (size_t i = 0; i < depth; ++i) {
+        level = &(*level)["d"];
+        *level = nlohmann::json::object();
+    }
+    (*level)["leaf.txt"] = "content";
+
+    TemplateManager manager;
+    REQUIRE(manager.validate_template(tmpl).is_ok());
+
+    auto store = TemplateGenerator::json_to_store(tmpl.structure, "deep");
+    REQUIRE(store.is_ok());
+    REQUIRE(store.value().size() == depth + 2);
+    REQUIRE(store.value().content(static_cast<NodeId>(depth + 1)) == "content");
+
+    auto root = TemplateGenerator::json_to_node_tree(tmpl.structure, "deep");
+    REQUIRE(root.is_ok());
+
+    // A bad value at the bottom fails the whole structure
+    (*level)["bad"] = 42;
+    REQUIRE(manager.validate_template(tmpl).is_error());
+    (*level)["leaf.txt/"] = nullptr;
+    (*level).erase("bad");
+    auto conflicting = TemplateGenerator::json_to_store(tmpl.structure, "deep");
+    REQUIRE(conflicting.is_error());
+    REQUIRE(conflicting.error().code == yaqeen::ErrorCode::InvalidTemplateStructure);
+}
+
+TEST_CASE("TemplateManager reads metadata up front and structures on demand", "[templates]") {
+    auto dir = std::filesystem::temp_directory_path() / "yaqeen_lazy_templates";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "web");
+
+    auto write = [](const std::filesystem::path& path, const std::string& text) {
+        std::ofstream(path, std::ios::binary) << text;
+    };
+    write(dir / "web" / "site.json",
+          R"({"name": "site", "description": "A site", "category": "web", "tags": ["html", "css"],)"
+          R"( "structure": {"index.html": "<html>"}})");
+    // Header keys after the structure still count
+    write(dir / "tool.json",
+          R"({"structure": {"src/": {"main.cpp": ""}}, "name": "tool", "description": "A tool",)"
+          R"( "author": "someone", "tags": ["cli"]})");
+    write(dir / "nostructure.json", R"({"name": "broken", "description": "No structure"})");
+    write(dir / "malformed.json", R"({"name": "bad", "description": )");
+
+    TemplateManager manager(dir);
+    REQUIRE(manager.initialize().is_ok());
+    REQUIRE(manager.list_templates() == std::vector<std::string>{"site", "tool"});
+    REQUIRE(manager.list_templates_in_category("web").size() == 1);
+
+    auto info = manager.get_template_info("tool");
+    REQUIRE(info.is_ok());
+    REQUIRE(info.value().author == std::optional<std::string>("someone"));
+    REQUIRE(info.value().tags == std::vector<std::string>{"cli"});
+    REQUIRE(manager.get_template_info("site").value().tags.size() == 2);
+
+    // The structure is read when first asked for, then kept
+    write(dir / "web" / "site.json",
+          R"({"name": "site", "description": "A site", "structure": {"changed.html": ""}})");
+    std::vector<std::thread> threads;
+    std::vector<yaqeen::Result<Template>> loaded(8, yaqeen::Error(yaqeen::ErrorCode::UnknownError, ""));
+    for (size_t i = 0; i < loaded.size(); ++i) {
+        threads.emplace_back([&, i] { loaded[i] = manager.get_template("site"); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& result : loaded) {
+        REQUIRE(result.is_ok());
+        REQUIRE(result.value().structure.contains("changed.html"));
+        REQUIRE(result.value().info.category == "web");
+    }
+
+    write(dir / "web" / "site.json",
+          R"({"name": "site", "description": "A site", "structure": {"again.html": ""}})");
+    REQUIRE(manager.get_template("site").value().structure.contains("changed.html"));
+    REQUIRE(manager.validate_all_templates().is_ok());
+    REQUIRE(manager.get_template("missing").is_error());
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("TemplatePack packs a templates directory and goes stale with it", "[templates]") {
+    auto dir = std::filesystem::temp_directory_path() / "yaqeen_pack_templates";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "web");
+
+    auto write = [](const std::filesystem::path& path, const std::string& text) {
+        std::ofstream(path, std::ios::binary) << text;
+    };
+    write(dir / "web" / "site.json",
+          R"({"name": "site", "description": "A site", "category": "web", "tags": ["html"], "author": "someone",)"
+          R"( "structure": {"public/": {"index.html": "<html>", "img/": {}}, "README.md": "# site"}})");
+    write(dir / "tool.json",
+          R"({"name": "tool", "description": "A tool", "structure": {"src": {"main.cpp": "int main() {}"}}})");
+    write(dir / "broken.json", R"({"name": "broken", "description": "Bad value", "structure": {"x": 1}})");
+
+    auto pack_path = TemplatePack::default_path(dir);
+    auto compiled = TemplatePack::compile(dir, pack_path);
+    REQUIRE(compiled.is_ok());
+    REQUIRE(compiled.value().templates == 3);
+    REQUIRE(compiled.value().invalid == 1);
+    REQUIRE(compiled.value().skipped == 0);
+    REQUIRE(compiled.value().bytes == std::filesystem::file_size(pack_path));
+
+    auto pack = TemplatePack::open(dir, pack_path);
+    REQUIRE(pack.is_ok());
+    REQUIRE(pack.value().size() == 3);
+    size_t site = 0;
+    while (pack.value().info(site).name != "site") {
+        site++;
+    }
+    REQUIRE(pack.value().has_structure(site));
+    auto info = pack.value().info(site);
+    REQUIRE(info.category == "web");
+    REQUIRE(info.tags == std::vector<std::string>{"html"});
+    REQUIRE(info.author == std::optional<std::string>("someone"));
+    REQUIRE_FALSE(info.repository.has_value());
+    REQUIRE(pack.value().source_path(site) == dir / "web" / "site.json");
+    REQUIRE(pack.value().structure_json(site) ==
+            nlohmann::json::parse(R"({"public": {"index.html": "<html>", "img": {}}, "README.md": "# site"})"));
+
+    auto tree = pack.value().structure(site, "demo");
+    REQUIRE(tree.name(tree.root()) == "demo");
+    REQUIRE(tree.size() == 5);
+    NodeId index = tree.find_child(tree.find_child(tree.root(), "public"), "index.html");
+    REQUIRE(tree.content(index) == "<html>");
+    REQUIRE(tree.source() != nullptr);
+
+    // The manager reads the pack and generates from it
+    TemplateManager manager(dir);
+    REQUIRE(manager.initialize().is_ok());
+    REQUIRE(manager.list_templates() == std::vector<std::string>{"broken", "site", "tool"});
+    REQUIRE(manager.get_template("tool").value().structure["src"]["main.cpp"] == "int main() {}");
+
+    auto out = std::filesystem::temp_directory_path() / "yaqeen_pack_output";
+    std::filesystem::remove_all(out);
+    TemplateGenerator::TemplateOptions options;
+    options.project_name = "demo";
+    options.output_dir = out;
+    REQUIRE(manager.generate_from_template("site", out, "demo", options).is_ok());
+    REQUIRE(std::filesystem::file_size(out / "public" / "index.html") == 6);
+    REQUIRE(std::filesystem::is_directory(out / "public" / "img"));
+    std::filesystem::remove_all(out);
+    REQUIRE(manager.generate_from_template("broken", out, "demo", options).is_error());
+
+    // Any change to the sources makes the pack stale
+    write(dir / "tool.json",
+          R"({"name": "tool", "description": "A new tool", "structure": {"src": {"main.cpp": ""}}})");
+    REQUIRE(TemplatePack::open(dir, pack_path).is_error());
+    REQUIRE(manager.load_templates().is_ok());
+    REQUIRE(manager.get_template_info("tool").value().description == "A new tool");
+
+    REQUIRE(TemplatePack::compile(dir, pack_path).is_ok());
+    REQUIRE(TemplatePack::open(dir, pack_path).is_ok());
+    write(dir / "extra.json", R"({"name": "extra", "description": "New", "structure": {}})");
+    REQUIRE(TemplatePack::open(dir, pack_path).is_error());
+    std::filesystem::remove(dir / "extra.json");
+    REQUIRE(TemplatePack::open(dir, pack_path).is_ok());
+
+    // A truncated pack is refused
+    std::filesystem::resize_file(pack_path, 64);
+    REQUIRE(TemplatePack::open(dir, pack_path).is_error());
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("TemplateManager scans nested directories in parallel and reports duplicate names", "[templates]") {
+    auto dir = std::filesystem::temp_directory_path() / "yaqeen_parallel_templates";
+    std::filesystem::remove_all(dir);
+
+    const int groups = 20;
+    const int per_group = 25;
+    for (int g = 0; g < groups; ++g) {
+        auto group = dir / ("group" + std::to_string(g)) / "nested";
+        std::filesystem::create_directories(group);
+        for (int t = 0; t < per_group; ++t) {
+            std::string name = "t" + std::to_string(g) + "_" + std::to_string(t);
+            std::ofstream(group / (name + ".json"))
+                << R"({"name": ")" << name << R"(", "description": "Template )" << name
+                << R"(", "category": "g)" << g << R"(", "structure": {"README.md": ""}})";
+        }
+        std::ofstream(group / "notes.txt") << "not a template";
+    }
+
+    // The same name in two files: the first in path order is kept
+    std::ofstream(dir / "a_dup.json") << R"({"name": "dup", "description": "first", "structure": {}})";
+    std::ofstream(dir / "group3" / "dup.json") << R"({"name": "dup", "description": "second", "structure": {}})";
+
+    for (int run = 0; run < 3; ++run) {
+        TemplateManager manager(dir);
+        REQUIRE(manager.initialize().is_ok());
+        REQUIRE(manager.list_templates().size() == groups * per_group + 1);
+        REQUIRE(manager.list_categories().size() == groups + 1);
+        REQUIRE(manager.get_template_info("dup").value().description == "first");
+        REQUIRE(manager.get_template_info("t19_24").value().category == "g19");
+        REQUIRE(manager.get_template("t7_3").value().structure.contains("README.md"));
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("TemplateManager and TemplatePack keep the same duplicate", "[templates]") {
+    auto dir = std::filesystem::temp_directory_path() / "yaqeen_duplicate_templates";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "a");
+    std::filesystem::create_directories(dir / "a-b");
+
+    // Component-wise, a/ sorts before a-b/; as relative strings, '-' sorts
+    // before '/'. Both sides must agree on the latter.
+    std::ofstream(dir / "a" / "y.json") << R"({"name": "dup", "description": "nested", "structure": {}})";
+    std::ofstream(dir / "a-b" / "x.json") << R"({"name": "dup", "description": "dashed", "structure": {}})";
+
+    TemplateManager scanned(dir);
+    REQUIRE(scanned.initialize().is_ok());
+    REQUIRE(scanned.get_template_info("dup").value().description == "dashed");
+
+    auto compiled = TemplatePack::compile(dir, TemplatePack::default_path(dir));
+    REQUIRE(compiled.is_ok());
+    REQUIRE(compiled.value().skipped == 1);
+
+    TemplateManager packed(dir);
+    REQUIRE(packed.initialize().is_ok());
+    REQUIRE(packed.get_template_info("dup").value().description == "dashed");
+    REQUIRE(packed.get_template("dup").value().source_path == dir / "a-b" / "x.json");
+
+    // A name is claimed by the first readable header, even when a later
+    // file with the same name has the only valid structure
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "a");
+    std::filesystem::create_directories(dir / "b");
+    std::ofstream(dir / "a" / "x.json") << R"({"name": "foo", "description": "invalid one", "structure": {"f": 5}})";
+    std::ofstream(dir / "b" / "y.json") << R"({"name": "foo", "description": "valid one", "structure": {"f": ""}})";
+
+    TemplateManager scanned_invalid(dir);
+    REQUIRE(scanned_invalid.initialize().is_ok());
+    REQUIRE(scanned_invalid.get_template_info("foo").value().description == "invalid one");
+
+    compiled = TemplatePack::compile(dir, TemplatePack::default_path(dir));
+    REQUIRE(compiled.is_ok());
+    REQUIRE(compiled.value().templates == 1);
+    REQUIRE(compiled.value().invalid == 1);
+    REQUIRE(compiled.value().skipped == 1);
+
+    TemplateManager packed_invalid(dir);
+    REQUIRE(packed_invalid.initialize().is_ok());
+    REQUIRE(packed_invalid.list_templates() == scanned_invalid.list_templates());
+    REQUIRE(packed_invalid.get_template_info("foo").value().description == "invalid one");
+
+    // Both fail the same way when the template is used
+    auto out = dir / "out";
+    TemplateGenerator::TemplateOptions options;
+    options.project_name = "demo";
+    options.output_dir = out;
+    auto from_scan = scanned_invalid.generate_from_template("foo", out, "demo", options);
+    auto from_pack = packed_invalid.generate_from_template("foo", out, "demo", options);
+    REQUIRE(from_scan.is_error());
+    REQUIRE(from_pack.is_error());
+    REQUIRE(from_pack.error().code == from_scan.error().code);
+
+    std::filesystem::remove_all(dir);
+}